@@ -10,7 +10,7 @@ AnalytiksAudioProcessorEditor::AnalytiksAudioProcessorEditor(
     AudioProcessorEditor(p),
     audioProcessor(p),
     mainUIComponent(apvts_ref, freeze_button_callback, settings_button_callback, p.getComponentArray()),
-    settings_page_component(apvts_ref)
+    settings_page_component(apvts_ref, p.perf, p.governor)
 {
     setOpaque(true);
     
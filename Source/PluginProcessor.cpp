@@ -10,22 +10,35 @@ AnalytiksAudioProcessor::AnalytiksAudioProcessor()
                        .withInput  ("Input",  AudioChannelSet::stereo(), true)
                       #endif
                        .withOutput ("Output", AudioChannelSet::stereo(), true)
+                      #if ! JucePlugin_IsSynth
+                       // the reference of "gb_transfer", off until the host routes one.
+                       .withInput  ("Sidechain", AudioChannelSet::stereo(), false)
+                      #endif
                      #endif
                        ),
 #endif
         apvts(*this, nullptr, "PARAMETERS", create_parameter_layout())
 {
-    // max supported block size.
-    temp_buffer.resize(8192 * 2);
-    
-    oscilloscope_component = std::make_unique<OscilloscopeComponent>(apvts);
-    phase_correlation_component = std::make_unique<PhaseCorrelationAnalyserComponent>(apvts);
-    fft_engine = std::make_unique<PFFFT>(apvts);
+    oscilloscope_component = std::make_unique<OscilloscopeComponent>(apvts, &perf);
+    phase_correlation_component = std::make_unique<PhaseCorrelationAnalyserComponent>(apvts, &perf);
+    fft_engine = std::make_unique<PFFFT>(apvts, &perf);
 
+    governor.onLevelChange = [this](int level) { applyQuality(level); };
 }
 
 AnalytiksAudioProcessor::~AnalytiksAudioProcessor()
 {
+    // the governor outlives the components.
+    governor.onLevelChange = nullptr;
+}
+
+void AnalytiksAudioProcessor::applyQuality(int level)
+{
+    auto settings = QualityGovernor::getSettings(level);
+
+    fft_engine->setQuality(settings.hop_multiplier, settings.fft_order_drop);
+    oscilloscope_component->setResolutionDivider(settings.scope_resolution_divider);
+    phase_correlation_component->setUpdateRateDivider(settings.correlation_rate_divider);
 }
 
 //==============================================================================
@@ -99,6 +112,8 @@ void AnalytiksAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBl
     SR = (float)sampleRate;
     fft_engine->prepareToPlay(sampleRate, samplesPerBlock);
     phase_correlation_component->prepareToPlay(sampleRate, samplesPerBlock);
+    loudness_meter.prepare(sampleRate);
+    silence.assign(jmax(samplesPerBlock, 1), 0.0f);
     // oscilloscope_component->setSampleRate((float)sampleRate);
 }
 
@@ -207,12 +222,80 @@ AudioProcessorValueTreeState::ParameterLayout AnalytiksAudioProcessor::create_pa
         ),
         2,
         choice_param_attributes));
+    // the analysis window, levels are corrected for its gain (see FFTTables.h).
+    // Flat-top reads tone levels right, wherever they fall between bins.
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "gb_window",
+        "FFT Window",
+        StringArray(
+            "Hann",
+            "Blackman-Harris",
+            "Flat-top",
+            "Kaiser"
+        ),
+        WindowHann,
+        choice_param_attributes));
+    // in steps, each value used builds a table of its own.
+    layout.add(std::make_unique<AudioParameterFloat>(
+        "gb_kaiser_beta",
+        "Kaiser Beta",
+        NormalisableRange<float>(0.0, 20.0, 0.5, 1),
+        WINDOW_DEFAULT_KAISER_BETA,
+        float_param_attributes));
+    // a denser bin grid for the same window, see FFTTables.h.
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "gb_zero_pad",
+        "Zero Padding",
+        StringArray(
+            "Off",
+            "2x",
+            "4x"
+        ),
+        0,
+        choice_param_attributes));
     // based on the channel selection, output is written.
     layout.add(std::make_unique<AudioParameterBool>(
         "gb_listen", 
         "Listen", 
         true, 
         bool_param_attributes));
+    // spectrogram and LTAS to ~/Documents/Analytiks, see AnalysisRecorder.h.
+    layout.add(std::make_unique<AudioParameterBool>(
+        "gb_record", 
+        "Record Analysis", 
+        false, 
+        bool_param_attributes));
+    // lets the quality governor trade resolution for headroom, see QualityGovernor.h.
+    layout.add(std::make_unique<AudioParameterBool>(
+        "gb_adaptive", 
+        "Adaptive Quality", 
+        true, 
+        bool_param_attributes));
+    // at 88.2 kHz and above the FFT only covers up to 20 kHz, see Decimator.h.
+    layout.add(std::make_unique<AudioParameterBool>(
+        "gb_decimate", 
+        "Decimate To Range", 
+        true, 
+        bool_param_attributes));
+    // the analyser shows the transfer function from the sidechain to the
+    // main input instead of the spectrum, see CrossSpectrum.h.
+    layout.add(std::make_unique<AudioParameterBool>(
+        "gb_transfer", 
+        "Transfer Function", 
+        false, 
+        bool_param_attributes));
+    // the transfer function's averaging, over 0.3 s, 3 s or everything
+    // since it was turned on.
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "gb_tf_avg",
+        "Transfer Averaging",
+        StringArray(
+            "Fast",
+            "Slow",
+            "Infinite"
+        ),
+        1,
+        choice_param_attributes));
 
     ////////////////////////////////////////////////////
     // SPECTRUM PARAMETERS.
@@ -277,6 +360,18 @@ AudioProcessorValueTreeState::ParameterLayout AnalytiksAudioProcessor::create_pa
         "Non Blurred Spectrogram", 
         false, 
         bool_param_attributes));
+    // the spectrogram coloured by the phase between the channels instead
+    // of the level, see PhaseSpectrum.h.
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "sg_phase",
+        "Spectrogram Phase View",
+        StringArray(
+            "Off",
+            "Phase L-R",
+            "Group Delay"
+        ),
+        PhaseOff,
+        choice_param_attributes));
     layout.add(std::make_unique<AudioParameterChoice>(
             "sp_measure",
             "History Window Bars",
@@ -294,6 +389,16 @@ AudioProcessorValueTreeState::ParameterLayout AnalytiksAudioProcessor::create_pa
             NormalisableRange<float>(0.15f, 64.0f, 0.01, 5, true),
             16.0f,
             float_param_attributes));
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "os_trig",
+        "Oscilloscope Trigger",
+        StringArray(
+            "Free",
+            "Beat",
+            "Edge"
+        ),
+        triggerMode.at("Free"),
+        choice_param_attributes));
 
     ////////////////////////////////////////////////////
     ////////////////////////////////////////////////////
@@ -304,6 +409,43 @@ AudioProcessorValueTreeState::ParameterLayout AnalytiksAudioProcessor::create_pa
         NormalisableRange<float>(0.1, 500.0, 0.01, 1, true), 
         45.0, 
         float_param_attributes));
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "v_meter",
+        "Volume Meter",
+        StringArray(
+            "RMS",
+            "Digital Peak",
+            "VU",
+            "PPM"
+        ),
+        0,
+        choice_param_attributes));
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "v_bands",
+        "Correlation Bands",
+        StringArray(
+            "Off",
+            "3",
+            "5",
+            "8"
+        ),
+        0,
+        choice_param_attributes));
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "v_gonio",
+        "Goniometer Mode",
+        StringArray(
+            "Lines",
+            "Density"
+        ),
+        0,
+        choice_param_attributes));
+    layout.add(std::make_unique<AudioParameterFloat>(
+        "v_gonio_ms",
+        "Goniometer History[ms]",
+        NormalisableRange<float>(5.0, 500.0, 0.1, 0.5, true),
+        40.0,
+        float_param_attributes));
 
     return layout;
 }
@@ -315,18 +457,32 @@ bool AnalytiksAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
     ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != AudioChannelSet::stereo())
-        return false;
+    // mono, stereo, or a surround set up to 7.1.4 of which the front left
+    // and right pair is analysed, the other channels pass through.
+    const auto& output_set = layouts.getMainOutputChannelSet();
+    if (output_set != AudioChannelSet::mono()
+     && output_set != AudioChannelSet::stereo())
+    {
+        if (output_set.size() > 12
+         || output_set.getChannelIndexForType(AudioChannelSet::left) < 0
+         || output_set.getChannelIndexForType(AudioChannelSet::right) < 0)
+            return false;
+    }
 
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // the sidechain is mixed to mono for the transfer function.
+    if (layouts.inputBuses.size() > 1)
+    {
+        const auto& sidechain_set = layouts.getChannelSet(true, 1);
+        if (!sidechain_set.isDisabled()
+         && sidechain_set != AudioChannelSet::mono()
+         && sidechain_set != AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -337,6 +493,9 @@ bool AnalytiksAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
 void AnalytiksAudioProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
 {
     ScopedNoDenormals noDenormals;
+    PerfScope callback_scope(&perf, buffer.getNumSamples(), SR);
+    auto callback_start = PerfCounters::now();
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -361,6 +520,10 @@ void AnalytiksAudioProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuff
     float bpm = 120.0f; 
     int timeSigNum = 4;
     int timeSigDen = 4;
+
+    // musical position of the first sample in the block, only valid while playing.
+    double ppqPosition = 0.0;
+    bool ppqValid = false;
     
     if (playHead) {
         auto position = playHead->getPosition();
@@ -379,6 +542,11 @@ void AnalytiksAudioProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuff
                         timeSigNum = ts->numerator;
                         timeSigDen = ts->denominator;
                     }
+
+                    if (auto ppq = pos->getPpqPosition()) {
+                        ppqPosition = *ppq;
+                        ppqValid = isPlayingNow;
+                    }
                 }
             }
         }
@@ -387,48 +555,64 @@ void AnalytiksAudioProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuff
     int present_channel = apvts.getRawParameterValue("gb_chnl")->load();
     bool listen_enabled = static_cast<bool>((int)apvts.getRawParameterValue("gb_listen")->load());
 
-    const float* left_channel_data = buffer.getReadPointer(0);
-    const float* right_channel_data = buffer.getReadPointer(1);
+    // the sidechain's channels follow the main ones in `buffer`.
+    auto main_buffer = getBusBuffer(buffer, true, 0);
+
+    // left and right come first in every supported set, a mono input is both.
+    const bool has_right = main_buffer.getNumChannels() > 1;
+    const float* left_channel_data = main_buffer.getReadPointer(0);
+    const float* right_channel_data = has_right ? main_buffer.getReadPointer(1) : left_channel_data;
+
+    // the reference of the transfer function, when it is on and routed.
+    const float* reference_left = nullptr;
+    const float* reference_right = nullptr;
+    if (apvts.getRawParameterValue("gb_transfer")->load() >= 0.5f
+     && getBusCount(true) > 1 && getBus(true, 1)->isEnabled())
+    {
+        auto sidechain = getBusBuffer(buffer, true, 1);
+        if (sidechain.getNumChannels() > 0)
+        {
+            reference_left = sidechain.getReadPointer(0);
+            reference_right = sidechain.getNumChannels() > 1 ? sidechain.getReadPointer(1) : reference_left;
+        }
+    }
 
     int number_of_samples = buffer.getNumSamples();
 
     // send data to the respective components, if they are not freezed.
     if (!freeze.load())
     {
-        if (present_channel == 0)
-        {
-            for (int sample = 0; sample < number_of_samples; ++sample)
-            {
-                temp_buffer[sample] = (left_channel_data[sample] + right_channel_data[sample]) * 0.5;
-            }
-        }
-        else if (present_channel == 1)
-        {
-            for (int sample = 0; sample < number_of_samples; ++sample)
-            {
-                temp_buffer[sample] = left_channel_data[sample];
-            }
-        }
-        else if (present_channel == 2)
+        // both channels, every channel view is derived from their spectra.
+        fft_engine->processBlock(left_channel_data, right_channel_data, number_of_samples, bpm, SR, timeSigNum, timeSigDen,
+                                 reference_left, reference_right);
+
+        oscilloscope_component->newAudioBatch(left_channel_data, right_channel_data, number_of_samples, bpm, SR, timeSigNum,
+                                              timeSigDen, ppqPosition, ppqValid);
+
+        // loudness wants the overs, so it gets the input before it is
+        // clipped, and before the listen rewrite below changes it.
+        if (phase_correlation_component->takeLoudnessReset())
+            loudness_meter.resetIntegration();
+
+        bool new_readings = false;
+        if (has_right)
         {
-            for (int sample = 0; sample < number_of_samples; ++sample)
-            {
-                temp_buffer[sample] = right_channel_data[sample];
-            }
+            new_readings = loudness_meter.process(left_channel_data, right_channel_data, number_of_samples);
         }
-        else
+        else if (!silence.empty())
         {
-            for (int sample = 0; sample < number_of_samples; ++sample)
+            // a block longer than announced goes in pieces of the silence.
+            for (int offset = 0; offset < number_of_samples; offset += (int) silence.size())
             {
-                temp_buffer[sample] = (left_channel_data[sample] - right_channel_data[sample]) * 0.5;
+                int num = jmin((int) silence.size(), number_of_samples - offset);
+                new_readings |= loudness_meter.process(left_channel_data + offset, silence.data(), num);
             }
         }
 
-        fft_engine->processBlock(temp_buffer.data(), number_of_samples, bpm, SR, timeSigNum, timeSigDen);
+        if (new_readings)
+            phase_correlation_component->newLoudnessReadings(loudness_meter.getReadings());
 
-        oscilloscope_component->newAudioBatch(buffer.getReadPointer(0), buffer.getReadPointer(1), number_of_samples, bpm, SR, timeSigNum);
-
-        if (present_channel == 0) {
+        if (present_channel == 0 || !has_right) {
             // do nothing, both channels are already there.
         } else if (present_channel == 1) {
             // left only
@@ -447,7 +631,7 @@ void AnalytiksAudioProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuff
 
         if (phase_correlation_component->getHeight() != 0) {
             if (phase_correlation_component->getWidth() != 0)
-                phase_correlation_component->processBlock(buffer);
+                phase_correlation_component->processBlock(main_buffer);
         }
         
     }
@@ -458,6 +642,8 @@ void AnalytiksAudioProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuff
         for (auto i = 0; i < totalNumOutputChannels; ++i)
             buffer.clear(i, 0, buffer.getNumSamples());
     }
+
+    governor.audioCallbackFinished(PerfCounters::microsecondsSince(callback_start), number_of_samples, SR);
 }
 
 //==============================================================================
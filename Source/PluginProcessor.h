@@ -14,6 +14,7 @@ constexpr auto DEFAULT_HEIGHT = 1000;
 
 #include "UI_Comp/Oscilloscope/Oscilloscope.h"
 #include "UI_Comp/Correlation/Correlation.h"
+#include "QualityGovernor.h"
 
 using namespace juce;
 
@@ -64,9 +65,26 @@ public:
         { "Rotated",    1 },
     };
 
+    // Free -> free running scroll.
+    // Beat -> columns locked to the host's musical position.
+    // Edge -> starts at a rising zero crossing, for steady tones.
+    const std::unordered_map<String, int> triggerMode {
+        { "Free",       0 },
+        { "Beat",       1 },
+        { "Edge",       2 },
+    };
+
     AudioProcessorValueTreeState apvts;
     AudioProcessorValueTreeState::ParameterLayout create_parameter_layout();
 
+    // timings of the hot paths, shown by the settings page's performance HUD.
+    // declared before the components, they keep a pointer to it.
+    PerfCounters perf;
+
+    // lowers the analysis quality while processBlock is short of headroom,
+    // its level is shown on the settings page.
+    QualityGovernor governor { apvts };
+
    #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
@@ -108,8 +126,6 @@ public:
 
 private:
 
-    std::vector<float> temp_buffer;
-
     bool isLastPlaying = false;
 
     std::unique_ptr<PFFFT> fft_engine;
@@ -118,8 +134,17 @@ private:
     std::unique_ptr<OscilloscopeComponent> oscilloscope_component;
     std::unique_ptr<PhaseCorrelationAnalyserComponent> phase_correlation_component;
 
+    // BS.1770 loudness and true peak of the unclipped input, fed ahead of
+    // the "gb_chnl" rewrite and whether the panel is shown or not.
+    LoudnessMeter loudness_meter;
+    // the missing channel of a mono input, so its loudness is not counted twice.
+    std::vector<float> silence;
+
     std::function<void(float*, int)> new_fft_frame_callback;
 
+    // message thread, from the governor.
+    void applyQuality(int level);
+
     std::atomic<bool> freeze = false;
 
     //==============================================================================
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <functional>
+
+using namespace juce;
+
+#define GOVERNOR_HZ 4
+#define GOVERNOR_MAX_LEVEL 4
+// peak share of the block's duration (per mille) that lowers the quality,
+// and the one it has to stay under before it is raised again.
+#define GOVERNOR_HIGH_LOAD 600
+#define GOVERNOR_LOW_LOAD 300
+// consecutive GOVERNOR_HZ windows over / under those.
+#define GOVERNOR_LOWER_AFTER 2
+#define GOVERNOR_RAISE_AFTER 12
+
+// Watches processBlock against its deadline (samplesPerBlock / sampleRate)
+// and steps the analysis quality down while the headroom is short, back up
+// once the load stayed low for a while. The audio thread only reports its
+// times, every decision and every change runs on the message thread.
+// "gb_adaptive" off holds the quality at full.
+class QualityGovernor : public ChangeBroadcaster, private Timer
+{
+public:
+
+    // what a level turns down, level 0 is full quality.
+    struct Settings
+    {
+        int hop_multiplier;              // FFT hop, times HOP_SIZE.
+        int fft_order_drop;              // orders below the "gb_fft_ord" choice, 9 at least.
+        int scope_resolution_divider;    // oscilloscope columns, OSC_MAX_WIDTH / this at most.
+        int correlation_rate_divider;    // correlation meter updates, TARGET_TRIGGER_HZ / this.
+    };
+
+    static Settings getSettings(int level)
+    {
+        static const Settings table[GOVERNOR_MAX_LEVEL + 1] = {
+            { 1, 0, 1, 1 },
+            { 2, 0, 1, 1 },
+            { 2, 0, 2, 2 },
+            { 4, 1, 2, 4 },
+            { 4, 2, 4, 4 },
+        };
+        return table[jlimit(0, GOVERNOR_MAX_LEVEL, level)];
+    }
+
+    QualityGovernor(AudioProcessorValueTreeState& apvts_reference)
+        : apvts_ref(apvts_reference)
+    {
+        startTimerHz(GOVERNOR_HZ);
+    }
+
+    ~QualityGovernor() override { stopTimer(); }
+
+    // audio thread, once per block.
+    void audioCallbackFinished(uint64 elapsed_us, int num_samples, double sample_rate)
+    {
+        if (num_samples <= 0 || sample_rate <= 0.0)
+            return;
+
+        const double deadline_us = (double) num_samples * 1e6 / sample_rate;
+        const uint32 load = (uint32) jmin(100000.0, 1000.0 * (double) elapsed_us / deadline_us);
+
+        uint32 previous = window_peak.load(std::memory_order_relaxed);
+        while (load > previous
+               && !window_peak.compare_exchange_weak(previous, load, std::memory_order_relaxed)) {}
+    }
+
+    int getLevel() const { return level.load(); }
+
+    // message thread, whenever the level changes.
+    std::function<void(int)> onLevelChange;
+
+private:
+
+    void timerCallback() override
+    {
+        const uint32 peak = window_peak.exchange(0, std::memory_order_relaxed);
+        int new_level = level.load();
+
+        if (apvts_ref.getRawParameterValue("gb_adaptive")->load() < 0.5f)
+        {
+            new_level = 0;
+            windows_over = windows_under = 0;
+        }
+        else if (peak >= GOVERNOR_HIGH_LOAD)
+        {
+            windows_under = 0;
+
+            if (++windows_over >= GOVERNOR_LOWER_AFTER)
+            {
+                new_level = jmin(new_level + 1, GOVERNOR_MAX_LEVEL);
+                windows_over = 0;
+            }
+        }
+        else if (peak < GOVERNOR_LOW_LOAD)
+        {
+            windows_over = 0;
+
+            if (++windows_under >= GOVERNOR_RAISE_AFTER)
+            {
+                new_level = jmax(new_level - 1, 0);
+                windows_under = 0;
+            }
+        }
+        else
+        {
+            windows_over = windows_under = 0;
+        }
+
+        if (new_level != level.load())
+        {
+            level = new_level;
+
+            if (onLevelChange) onLevelChange(new_level);
+            sendChangeMessage();
+        }
+    }
+
+    AudioProcessorValueTreeState& apvts_ref;
+
+    std::atomic<uint32> window_peak { 0 };
+    std::atomic<int> level { 0 };
+
+    int windows_over = 0;
+    int windows_under = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(QualityGovernor)
+};
@@ -3,15 +3,14 @@
 
 SpectrumAnalyserComponent::SpectrumAnalyserComponent(
     AudioProcessorValueTreeState& apvts_reference,
-    std::function<void(string)>& label_callback)
-    : apvts_ref(apvts_reference)
+    std::function<void(string)>& label_callback,
+    PerfCounters* perf_counters)
+    : apvts_ref(apvts_reference),
+      perf(perf_counters)
 {
     setOpaque(true);
 
-    for (int i = 0; i < AMPLITUDE_DATA_SIZE; ++i) {
-        amplitude_data[i] = 0.0f;
-        ribbon_data[i] = 0.0f;
-    }
+    clearData();
 
     opengl_context.setOpenGLVersionRequired(OpenGLContext::OpenGLVersion::openGL3_2);
     opengl_context.setRenderer(this);
@@ -51,18 +50,31 @@ SpectrumAnalyserComponent::~SpectrumAnalyserComponent()
 void SpectrumAnalyserComponent::prepareToPlay(float SampleRate, float BlockSize)
 {
     SR = SampleRate;
+    bins_rate = SampleRate;
 }
 
 void SpectrumAnalyserComponent::clearData()
 {
+    for (int view = 0; view < NumAnalysisViews; ++view) {
+        for (int i = 0; i < AMPLITUDE_DATA_SIZE; ++i) {
+            amplitude_data[view][i] = 0.0f;
+            ribbon_data[view][i] = 0.0f;
+        }
+    }
+
     for (int i = 0; i < AMPLITUDE_DATA_SIZE; ++i) {
-        amplitude_data[i] = 0.0f;
-        ribbon_data[i] = 0.0f;
+        transfer_gain[i] = 0.0f;
+        transfer_coherence[i] = 0.0f;
+        transfer_phase[i] = 0.5f;
     }
 }
 
 void SpectrumAnalyserComponent::timerCallback()
 {
+    // a measurement starts over every time the mode is turned on.
+    if (!isTransferMode() && transfer.getNumBins() > 0)
+        transfer = CrossSpectrum();
+
     if (send_triggerRepaint) opengl_context.triggerRepaint();
     repaint();
 }
@@ -74,21 +86,25 @@ void SpectrumAnalyserComponent::paint(Graphics& g)
 float SpectrumAnalyserComponent::getTopFrequency(float& outAmplitude) const {
     float min_freq = (float)apvts_ref.getRawParameterValue("sp_rng_min")->load();
     float max_freq = std::max((float)apvts_ref.getRawParameterValue("sp_rng_max")->load(), min_freq + 100.0f);
-    float sampleRate = SR.load();
+    float sampleRate = bins_rate.load();
     int numBins = bins_number.load();
     float fftSize = float(2 * (numBins - 1));
     int minBin = std::max(0, int(min_freq * fftSize / sampleRate));
     int maxBin = std::min(numBins - 1, int(max_freq * fftSize / sampleRate));
+    const GLfloat* amplitudes = amplitude_data[getView()];
     float maxAmp = 0.0f;
     int maxIdx = minBin;
     for (int i = minBin; i <= maxBin; ++i) {
-        if (amplitude_data[i] > maxAmp) {
-            maxAmp = amplitude_data[i];
+        if (amplitudes[i] > maxAmp) {
+            maxAmp = amplitudes[i];
             maxIdx = i;
         }
     }
     outAmplitude = maxAmp;
-    float freq = (sampleRate * maxIdx) / fftSize;
+    if (peak_estimator == nullptr || peak_estimator->getFFTSize() != (int)fftSize)
+        return (sampleRate * maxIdx) / fftSize;
+
+    float freq = (float)(sampleRate * peak_estimator->estimate(amplitudes, numBins, maxIdx, outAmplitude) / fftSize);
     return freq;
 }
 
@@ -116,15 +132,16 @@ juce::String SpectrumAnalyserComponent::frequencyToNote(float frequency) {
 float SpectrumAnalyserComponent::getVolumeLevel() const {
     float min_freq = (float)apvts_ref.getRawParameterValue("sp_rng_min")->load();
     float max_freq = std::max((float)apvts_ref.getRawParameterValue("sp_rng_max")->load(), min_freq + 100.0f);
-    float sampleRate = SR.load();
+    float sampleRate = bins_rate.load();
     int numBins = bins_number.load();
     float fftSize = float(2 * (numBins - 1));
     int minBin = std::max(0, int(min_freq * fftSize / sampleRate));
     int maxBin = std::min(numBins - 1, int(max_freq * fftSize / sampleRate));
+    const GLfloat* amplitudes = amplitude_data[getView()];
     float sum = 0.0f;
     int count = 0;
     for (int i = minBin; i <= maxBin; ++i) {
-        sum += amplitude_data[i] * amplitude_data[i];
+        sum += amplitudes[i] * amplitudes[i];
         ++count;
     }
     return count > 0 ? std::sqrt(sum / count) : 0.0f;
@@ -136,6 +153,9 @@ void SpectrumAnalyserComponent::drawOverlay(juce::Graphics& g) {
     float freq = 0.0f;
     char noteBuf[8] = { '-', '\0', 0, 0, 0, 0, 0, 0 };
     float vol = 0.0f;
+    CrossBand band;
+    bool band_valid = false;
+    const bool transfer_mode = isTransferMode();
 
     if (mouseOver) {
 
@@ -154,7 +174,7 @@ void SpectrumAnalyserComponent::drawOverlay(juce::Graphics& g) {
         // Get frequency under mouse X position using logarithmic mapping (same as shader)
         float min_freq = (float)apvts_ref.getRawParameterValue("sp_rng_min")->load();
         float max_freq = std::max((float)apvts_ref.getRawParameterValue("sp_rng_max")->load(), min_freq + 100.0f);
-        float sampleRate = SR.load();
+        float sampleRate = bins_rate.load();
         int numBins = bins_number.load();
         float fftSize = float(2 * (numBins - 1));
         
@@ -165,7 +185,21 @@ void SpectrumAnalyserComponent::drawOverlay(juce::Graphics& g) {
         
         // Get bin and amplitude
         int bin = juce::jlimit(0, (int)numBins - 1, (int)(freq * fftSize / sampleRate));
-        amp = amplitude_data[bin];
+        amp = amplitude_data[getView()][bin];
+
+        // between L and R over the bins of the hovered bar, or of the
+        // transfer function.
+        const CrossSpectrum& spectra = transfer_mode ? transfer : cross;
+        if (spectra.getNumBins() > 1) {
+            int bars = std::max(1, (int)apvts_ref.getRawParameterValue("sp_num_brs")->load());
+            float bar = std::floor(t * bars);
+            float f0 = min_freq * std::pow(max_freq / min_freq, bar / bars);
+            float f1 = min_freq * std::pow(max_freq / min_freq, (bar + 1.0f) / bars);
+            float crossSize = float(2 * (spectra.getNumBins() - 1));
+
+            band = spectra.getBand((int)(f0 * crossSize / sampleRate), (int)(f1 * crossSize / sampleRate));
+            band_valid = true;
+        }
         
         // Get note as char buffer
         getFrequencyToNoteBuf(freq, noteBuf);
@@ -183,7 +217,37 @@ void SpectrumAnalyserComponent::drawOverlay(juce::Graphics& g) {
     
     // Build text using char buffer to avoid encoding issues
     char textBuf[256];
-    if (mouseOver) {
+    int lines = 3;
+    if (transfer_mode && mouseOver && band_valid) {
+        std::snprintf(textBuf, sizeof(textBuf),
+                      "Freq: %.1f Hz\nNote: %s\nGain: %.2f dB\nPhase: %.0f deg\nCoherence: %.2f",
+                      freq, noteBuf, Decibels::gainToDecibels(band.gain, -120.0f),
+                      band.phase * 180.0f / MathConstants<float>::pi, band.coherence);
+        lines = 5;
+    } else if (transfer_mode) {
+        // over the whole displayed range when not hovering.
+        if (transfer.getNumBins() > 1) {
+            float min_freq = (float)apvts_ref.getRawParameterValue("sp_rng_min")->load();
+            float max_freq = std::max((float)apvts_ref.getRawParameterValue("sp_rng_max")->load(), min_freq + 100.0f);
+            float crossSize = float(2 * (transfer.getNumBins() - 1));
+            float sampleRate = bins_rate.load();
+            CrossBand range = transfer.getBand((int)(min_freq * crossSize / sampleRate), (int)(max_freq * crossSize / sampleRate));
+            std::snprintf(textBuf, sizeof(textBuf), "Transfer H1\nCoherence: %.2f", range.coherence);
+        } else {
+            std::snprintf(textBuf, sizeof(textBuf), "Transfer H1\nNo sidechain");
+        }
+        lines = 2;
+    } else if (mouseOver && band_valid) {
+        char panBuf[16];
+        int pan = roundToInt(std::abs(band.pan) * 100.0f);
+        if (pan == 0) std::snprintf(panBuf, sizeof(panBuf), "C");
+        else std::snprintf(panBuf, sizeof(panBuf), "%s %d%%", band.pan < 0.0f ? "L" : "R", pan);
+
+        std::snprintf(textBuf, sizeof(textBuf),
+                      "Freq: %.1f Hz\nNote: %s\nLevel: %.2f dB\nCoherence: %.2f\nPhase: %.0f deg\nPan: %s",
+                      freq, noteBuf, dB, band.coherence, band.phase * 180.0f / MathConstants<float>::pi, panBuf);
+        lines = 6;
+    } else if (mouseOver) {
         std::snprintf(textBuf, sizeof(textBuf), "Freq: %.1f Hz\nNote: %s\nLevel: %.2f dB", freq, noteBuf, dB);
     } else {
         std::snprintf(textBuf, sizeof(textBuf), "Peak: %.1f Hz\nNote: %s", freq, noteBuf);
@@ -191,14 +255,14 @@ void SpectrumAnalyserComponent::drawOverlay(juce::Graphics& g) {
     
     juce::String text(textBuf);
 
-    auto bounds = getLocalBounds().removeFromRight(150).removeFromBottom(50);
+    auto bounds = getLocalBounds().removeFromRight(150).removeFromBottom(lines * 14 + 8);
     bounds.reduce(4, 4);
 
     g.setColour(juce::Colours::black.withAlpha(0.5f));
     g.fillRoundedRectangle(bounds.toFloat(), 8.0f);
     g.setColour(juce::Colours::white);
     g.setFont(juce::Font(12.0f));
-    g.drawFittedText(text, bounds.reduced(4), juce::Justification::topLeft, 3);
+    g.drawFittedText(text, bounds.reduced(4), juce::Justification::topLeft, lines);
 }
 
 void SpectrumAnalyserComponent::newOpenGLContextCreated()
@@ -214,14 +278,23 @@ void SpectrumAnalyserComponent::newOpenGLContextCreated()
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexImage1D(GL_TEXTURE_1D, 0, GL_R32F, AMPLITUDE_DATA_SIZE, 0, GL_RED, GL_FLOAT, amplitude_data);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_R32F, AMPLITUDE_DATA_SIZE, 0, GL_RED, GL_FLOAT, amplitude_data[ViewMid]);
 
     glGenTextures(1, &ribbonTexture);
     glBindTexture(GL_TEXTURE_1D, ribbonTexture);
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexImage1D(GL_TEXTURE_1D, 0, GL_R32F, AMPLITUDE_DATA_SIZE, 0, GL_RED, GL_FLOAT, ribbon_data);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_R32F, AMPLITUDE_DATA_SIZE, 0, GL_RED, GL_FLOAT, ribbon_data[ViewMid]);
+
+    glGenTextures(1, &phaseTexture);
+    glBindTexture(GL_TEXTURE_1D, phaseTexture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_R32F, AMPLITUDE_DATA_SIZE, 0, GL_RED, GL_FLOAT, transfer_phase);
+
+    uploaded_view = ViewMid;
 
     send_triggerRepaint = true;
 }
@@ -232,6 +305,9 @@ void SpectrumAnalyserComponent::renderOpenGL()
 
     if (pause) return;
 
+    PerfScope render_scope(perf, PerfGLRender);
+    size_t uploaded = 0;
+
     int pres_fft_size = po2[(int)apvts_ref.getRawParameterValue("gb_fft_ord")->load()];
 
     using namespace ::juce::gl;
@@ -243,6 +319,10 @@ void SpectrumAnalyserComponent::renderOpenGL()
 
     if (shader_uniforms && shader_uniforms->amplitudeData) shader_uniforms->amplitudeData->set(0);
     if (shader_uniforms && shader_uniforms->ribbonData)    shader_uniforms->ribbonData->set(1);    
+    if (shader_uniforms && shader_uniforms->phaseData)     shader_uniforms->phaseData->set(2);
+
+    const bool transfer_mode = isTransferMode();
+    if (shader_uniforms && shader_uniforms->transferMode)  shader_uniforms->transferMode->set(transfer_mode ? 1 : 0);
 
     if (shader_uniforms) {
         if (shader_uniforms->resolution)
@@ -253,7 +333,7 @@ void SpectrumAnalyserComponent::renderOpenGL()
             shader_uniforms->numBins->set((GLint)bins_number.load());
 
         if (shader_uniforms->sampleRate)
-            shader_uniforms->sampleRate->set((GLfloat)SR.load());
+            shader_uniforms->sampleRate->set((GLfloat)bins_rate.load());
         if (shader_uniforms->minFreq && shader_uniforms->maxFreq) {
             float min_freq = (float)apvts_ref.getRawParameterValue("sp_rng_min")->load();
             float max_freq = max((float)apvts_ref.getRawParameterValue("sp_rng_max")->load(), min_freq + 100.0f);
@@ -271,19 +351,36 @@ void SpectrumAnalyserComponent::renderOpenGL()
             shader_uniforms->colorMap_higher->set(clr_data[3], clr_data[4], clr_data[5]);
     }
     
+    // a switched view is uploaded whether new data came or not.
+    const int view = transfer_mode ? NumAnalysisViews : getView();
+    const bool upload = newDataAvailable || view != uploaded_view;
+
     // Update amplitude texture
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_1D, dataTexture);
-    if (newDataAvailable) {
-        glTexSubImage1D(GL_TEXTURE_1D, 0, 0, AMPLITUDE_DATA_SIZE, GL_RED, GL_FLOAT, amplitude_data);
+    if (upload) {
+        glTexSubImage1D(GL_TEXTURE_1D, 0, 0, AMPLITUDE_DATA_SIZE, GL_RED, GL_FLOAT,
+                        transfer_mode ? transfer_gain : amplitude_data[view]);
+        uploaded += sizeof(float) * AMPLITUDE_DATA_SIZE;
+    }
+
+    // Update phase texture, only drawn in transfer mode
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_1D, phaseTexture);
+    if (upload && transfer_mode) {
+        glTexSubImage1D(GL_TEXTURE_1D, 0, 0, AMPLITUDE_DATA_SIZE, GL_RED, GL_FLOAT, transfer_phase);
+        uploaded += sizeof(float) * AMPLITUDE_DATA_SIZE;
     }
 
     // Update ribbon texture
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_1D, ribbonTexture);
-    if (newDataAvailable) {
-        glTexSubImage1D(GL_TEXTURE_1D, 0, 0, AMPLITUDE_DATA_SIZE, GL_RED, GL_FLOAT, ribbon_data);
+    if (upload) {
+        glTexSubImage1D(GL_TEXTURE_1D, 0, 0, AMPLITUDE_DATA_SIZE, GL_RED, GL_FLOAT,
+                        transfer_mode ? transfer_coherence : ribbon_data[view]);
+        uploaded += sizeof(float) * AMPLITUDE_DATA_SIZE;
         newDataAvailable = false;
+        uploaded_view = view;
     }
 
     // Draw full viewport quad
@@ -295,6 +392,7 @@ void SpectrumAnalyserComponent::renderOpenGL()
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STREAM_DRAW);
+    uploaded += sizeof(vertices) + sizeof(indices);
 
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
     glEnableVertexAttribArray(0);
@@ -303,6 +401,8 @@ void SpectrumAnalyserComponent::renderOpenGL()
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    if (perf) perf->record(PerfGLUpload, uploaded);
 }
 
 void SpectrumAnalyserComponent::mouseWheelMove(
@@ -379,8 +479,16 @@ void SpectrumAnalyserComponent::openGLContextClosing()
     shader_uniforms.reset();
 }
 
-void SpectrumAnalyserComponent::newData(float* data, int num_bins)
+void SpectrumAnalyserComponent::newData(const float* const* views, int num_bins, float sample_rate,
+                                        const std::shared_ptr<const WindowTable>& window)
 {
+    // a new window or padding, its kernel is tabulated once here.
+    const int fft_size = 2 * (num_bins - 1);
+    if (window != nullptr && (window != peak_window || peak_estimator->getFFTSize() != fft_size)) {
+        peak_window = window;
+        peak_estimator = std::make_unique<PeakEstimator>(*window, fft_size);
+    }
+
     int bars = (int)apvts_ref.getRawParameterValue("sp_num_brs")->load();
     float onion_speed = apvts_ref.getRawParameterValue("sp_bar_spd")->load() * 0.001f;
 
@@ -388,25 +496,66 @@ void SpectrumAnalyserComponent::newData(float* data, int num_bins)
     float alpha_onion = 1.0f - expf(-1.0f / (onion_speed * SR));
     float rem_alpha = 1.0f - alpha_onion;
 
-    // Update amplitude data and ribbon (onion) data
-    for (int i = 0; i < num_bins; ++i) {
-        amplitude_data[i] = data[i];
-
-        // Onion maintains peak, but decays when new data is lower
-        if (data[i] > ribbon_data[i]) {
-            ribbon_data[i] = data[i];
-        } else {
-            ribbon_data[i] = data[i] * alpha_onion + ribbon_data[i] * rem_alpha;
+    // Update amplitude data and ribbon (onion) data, of every view so a
+    // switch shows the ribbon as it would have been.
+    for (int view = 0; view < NumAnalysisViews; ++view) {
+        const float* data = views[view];
+        GLfloat* amplitudes = amplitude_data[view];
+        GLfloat* ribbon = ribbon_data[view];
+
+        for (int i = 0; i < num_bins; ++i) {
+            amplitudes[i] = data[i];
+
+            // Onion maintains peak, but decays when new data is lower
+            if (data[i] > ribbon[i]) {
+                ribbon[i] = data[i];
+            } else {
+                ribbon[i] = data[i] * alpha_onion + ribbon[i] * rem_alpha;
+            }
         }
     }
 
     newDataAvailable = true;
     bins_number = num_bins;
+    bins_rate = sample_rate;
 
     // cout << "Analyser received new data batch with " + String(num_bins) + " bins." << "\n";
 
 }
 
+void SpectrumAnalyserComponent::newCrossSpectrum(const CrossSpectrum& batch, int num_samples, float sample_rate)
+{
+    float keep = std::exp(-(float)num_samples / (sample_rate * (float)CROSS_SPECTRUM_SECONDS));
+    cross.blend(batch, keep);
+}
+
+void SpectrumAnalyserComponent::newTransfer(const CrossSpectrum& batch, int num_samples, float sample_rate)
+{
+    if (!isTransferMode()) return;
+
+    // exponential over "Fast" or "Slow", a plain sum since the start for
+    // "Infinite", H1 and the coherence are ratios of the sums either way.
+    static const float averageSeconds[] = { 0.3f, 3.0f };
+    int average = jlimit(0, 2, (int)apvts_ref.getRawParameterValue("gb_tf_avg")->load());
+    float keep = average < 2 ? std::exp(-(float)num_samples / (sample_rate * averageSeconds[average])) : 1.0f;
+
+    transfer.blend(batch, keep);
+
+    const int num_bins = jmin(transfer.getNumBins(), AMPLITUDE_DATA_SIZE);
+    for (int bin = 0; bin < num_bins; ++bin) {
+        CrossBand band = transfer.getBand(bin, bin);
+        float dB = Decibels::gainToDecibels(band.gain, -TRANSFER_RANGE_DB);
+
+        transfer_gain[bin] = jlimit(0.0f, 1.0f, 0.5f + dB / (2.0f * TRANSFER_RANGE_DB));
+        transfer_phase[bin] = 0.5f + band.phase / MathConstants<float>::twoPi;
+        transfer_coherence[bin] = band.coherence;
+    }
+
+    newDataAvailable = true;
+    bins_number = num_bins;
+    bins_rate = sample_rate;
+}
+
 void SpectrumAnalyserComponent::createShaders()
 {
     std::unique_ptr<OpenGLShaderProgram> shaderProgramAttempt = std::make_unique<OpenGLShaderProgram>(opengl_context);
@@ -438,6 +587,8 @@ SpectrumAnalyserComponent::Uniforms::Uniforms(OpenGLContext& OpenGL_Context, Ope
     sampleRate.reset(createUniform(OpenGL_Context, shader_program, "sampleRate"));
     minFreq.reset(createUniform(OpenGL_Context, shader_program, "minFreq"));
     maxFreq.reset(createUniform(OpenGL_Context, shader_program, "maxFreq"));
+    phaseData.reset(createUniform(OpenGL_Context, shader_program, "phaseData"));
+    transferMode.reset(createUniform(OpenGL_Context, shader_program, "transferMode"));
 }
 
 OpenGLShaderProgram::Uniform* SpectrumAnalyserComponent::Uniforms::createUniform(
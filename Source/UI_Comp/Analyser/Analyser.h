@@ -5,11 +5,18 @@
 #include <juce_opengl/juce_opengl.h>
 
 #include "../../ColourMaps.h"
-#include "../../ds/dataStructure.h"
+#include "../util.h"
+#include "../DFT/CrossSpectrum.h"
+#include "../DFT/PeakEstimator.h"
+#include "../../ds/PerfCounters.h"
 
 using namespace juce;
 
-#define AMPLITUDE_DATA_SIZE 8192
+// bins of the largest zero padded transform, 2^FFT_MAX_PADDED_ORDER / 2 + 1, fit.
+#define AMPLITUDE_DATA_SIZE 16384
+// transfer mode draws the gain from -TRANSFER_RANGE_DB to TRANSFER_RANGE_DB,
+// 0 dB in the middle.
+#define TRANSFER_RANGE_DB 40.0f
 
 class SpectrumAnalyserComponent
         : public Component,
@@ -20,7 +27,8 @@ class SpectrumAnalyserComponent
 public:
     SpectrumAnalyserComponent(
         AudioProcessorValueTreeState& apvts_reference,
-        std::function<void(string)>& label_callback);
+        std::function<void(string)>& label_callback,
+        PerfCounters* perf_counters = nullptr);
     ~SpectrumAnalyserComponent();
 
     void mouseEnter(const juce::MouseEvent&) override;
@@ -33,8 +41,22 @@ public:
     
     void timerCallback();
 
-    // Call this with FFT bin data. num_bins should be (fft_size / 2) + 1
-    void newData(float* data, int num_bins);
+    // Call this with FFT bin data. num_bins should be (fft_size / 2) + 1,
+    // `sample_rate` the one the bins were computed at (decimated or not).
+    // `views` holds the bins of every AnalysisView, the one of "gb_chnl" is drawn.
+    // `window` is the one of the frames, the peak readout fits its kernel.
+    void newData(const float* const* views, int num_bins, float sample_rate,
+                 const std::shared_ptr<const WindowTable>& window);
+
+    // the cross spectrum of a batch covering `num_samples` at `sample_rate`,
+    // averaged over CROSS_SPECTRUM_SECONDS for the overlay.
+    void newCrossSpectrum(const CrossSpectrum& batch, int num_samples, float sample_rate);
+
+    // "gb_transfer": the sums of the measured and the reference spectra of a
+    // batch, averaged as "gb_tf_avg" says. Drawn instead of the spectrum:
+    // the gain of H1 as bars, the coherence as the ribbon behind them and
+    // the phase as their hue.
+    void newTransfer(const CrossSpectrum& batch, int num_samples, float sample_rate);
 
     void newOpenGLContextCreated() override;
     void renderOpenGL() override;
@@ -54,18 +76,51 @@ private:
     juce::Point<int> lastMousePos;
     void drawOverlay(juce::Graphics& g);
     AudioProcessorValueTreeState& apvts_ref;
+    PerfCounters* perf;
     std::atomic<float> SR = 44100.0f;
+    // of the latest bins, SR over the decimation factor.
+    std::atomic<float> bins_rate = 44100.0f;
     std::atomic<bool> pause = false;
     std::atomic<bool> send_triggerRepaint = false;
     std::atomic<bool> newDataAvailable = false;
     std::atomic<int> bins_number = 257;
 
-    // Amplitude data: direct FFT bin data
-    GLfloat amplitude_data[AMPLITUDE_DATA_SIZE];
+    // Amplitude data: direct FFT bin data, of every view
+    GLfloat amplitude_data[NumAnalysisViews][AMPLITUDE_DATA_SIZE];
     // Ribbon data: smoothed/onion-skin version (background bars)
-    GLfloat ribbon_data[AMPLITUDE_DATA_SIZE];
+    GLfloat ribbon_data[NumAnalysisViews][AMPLITUDE_DATA_SIZE];
+    // the view in the textures, NumAnalysisViews for the transfer function.
+    // GL thread only.
+    int uploaded_view = -1;
+
+    // of L and R, message thread only.
+    CrossSpectrum cross;
+
+    // the window of the latest bins and the fit of its kernel. Message
+    // thread only.
+    std::shared_ptr<const WindowTable> peak_window;
+    std::unique_ptr<PeakEstimator> peak_estimator;
+
+    // transfer mode, the averaged sums on the message thread and per bin
+    // what is drawn of them: gain and phase from 0 to 1, the coherence.
+    CrossSpectrum transfer;
+    GLfloat transfer_gain[AMPLITUDE_DATA_SIZE];
+    GLfloat transfer_coherence[AMPLITUDE_DATA_SIZE];
+    GLfloat transfer_phase[AMPLITUDE_DATA_SIZE];
+
+    bool isTransferMode() const
+    {
+        return apvts_ref.getRawParameterValue("gb_transfer")->load() >= 0.5f;
+    }
+
+    int getView() const
+    {
+        return jlimit(0, NumAnalysisViews - 1, (int) apvts_ref.getRawParameterValue("gb_chnl")->load());
+    }
 
     // Overlay helpers
+    // the loudest visible bin, refined between bins by PeakEstimator. A
+    // steady tone reads within 0.02 cents from 80 Hz up, padded or not.
     float getTopFrequency(float& outAmplitude) const;
     juce::String frequencyToNote(float frequency);
     void getFrequencyToNoteBuf(float frequency, char* buf) const;
@@ -90,7 +145,9 @@ private:
             numBins,
             sampleRate,
             minFreq,
-            maxFreq;
+            maxFreq,
+            phaseData,
+            transferMode;
 
     private:
         static OpenGLShaderProgram::Uniform* createUniform(
@@ -99,7 +156,7 @@ private:
             const char* uniform_name);
     };
 
-    GLuint dataTexture, ribbonTexture;
+    GLuint dataTexture, ribbonTexture, phaseTexture;
     GLuint VBO, EBO;
 
     std::unique_ptr<OpenGLShaderProgram> shader;
@@ -116,6 +173,8 @@ private:
         uniform vec2 resolution;
         uniform sampler1D amplitudeData;
         uniform sampler1D ribbonData;
+        uniform sampler1D phaseData;
+        uniform int transferMode;
         uniform vec3 colorMap_lower;
         uniform vec3 colorMap_higher;
 
@@ -217,6 +276,22 @@ private:
 
             vec3 colour = mix(colorMap_lower, colorMap_higher, amp);
 
+            // the hue of the transfer function's phase in the middle of the
+            // band, the ribbon is its coherence.
+            if (transferMode == 1)
+            {
+                int centre = int(0.5 * (binF0 + binF1) + 0.5);
+                float phase = texelFetch(phaseData, clamp(centre, 0, numBins - 1), 0).r;
+                colour = 0.5 + 0.5 * cos(6.2831853 * (phase + vec3(0.0, 0.6666667, 0.3333333)));
+
+                // 0 dB
+                if (abs(uv.x - 0.5) < 1.0 / resolution.x)
+                {
+                    gl_FragColor = vec4(0.8, 0.8, 0.8, 1.0);
+                    return;
+                }
+            }
+
             // looks stupid works perfectly. 
             float pxx = (1.0 / resolution.x) * 7 + 0.001; 
             // your vertical grid lines 
@@ -0,0 +1,198 @@
+#pragma once
+
+// Splits a stereo signal into bands and gathers the per band
+// sums of L*L, R*R and L*R, used for the multiband correlation.
+// Free of any juce dependency, like the oscilloscope's MinMaxPyramid.
+//
+// Every band is a Linkwitz-Riley (4th order) band pass: two butterworth
+// high passes at the lower edge and two butterworth low passes at the
+// upper one. Both channels of every band run as independent lanes of the
+// same 4 stage chain, so one sample is a handful of fixed length loops over
+// `BAND_LANES` that the compiler vectorizes. The lowest and the highest
+// band simply have pass through stages on their open side.
+//
+// L and R go through identical filters, so the phase the filters add
+// cancels out of the correlation.
+
+#include <cmath>
+#include <algorithm>
+
+#define BAND_MAX_BANDS 8
+// left channel of every band, then the right channel of every band.
+#define BAND_LANES (2 * BAND_MAX_BANDS)
+#define BAND_STAGES 4
+// crossovers are spread logarithmically over this range.
+#define BAND_LOWEST_HZ 20.0
+#define BAND_HIGHEST_HZ 20000.0
+
+struct BandSums
+{
+    double ll[BAND_MAX_BANDS] = {};
+    double rr[BAND_MAX_BANDS] = {};
+    double lr[BAND_MAX_BANDS] = {};
+
+    void clear() { *this = BandSums(); }
+};
+
+class BandSplitter
+{
+public:
+
+    BandSplitter() { prepare(44100.0, 0); }
+
+    // 0 bands turns the splitter off. Does not allocate, so it is
+    // fine to call it from the audio thread when the band count changes.
+    void prepare(double sample_rate, int bands)
+    {
+        num_bands = std::clamp(bands, 0, BAND_MAX_BANDS);
+
+        for (int s = 0; s < BAND_STAGES; ++s)
+            for (int j = 0; j < BAND_LANES; ++j)
+                setPassThrough(s, j);
+
+        for (int b = 0; b < num_bands; ++b)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                const int lane = b + ch * BAND_MAX_BANDS;
+
+                // lower edge, the first band reaches down to DC.
+                if (b > 0)
+                {
+                    setButterworth(0, lane, getCrossover(b - 1, num_bands), sample_rate, true);
+                    setButterworth(1, lane, getCrossover(b - 1, num_bands), sample_rate, true);
+                }
+
+                // upper edge, the last band reaches up to nyquist.
+                if (b < num_bands - 1)
+                {
+                    setButterworth(2, lane, getCrossover(b, num_bands), sample_rate, false);
+                    setButterworth(3, lane, getCrossover(b, num_bands), sample_rate, false);
+                }
+            }
+        }
+
+        reset();
+    }
+
+    void reset()
+    {
+        for (int s = 0; s < BAND_STAGES; ++s)
+            for (int j = 0; j < BAND_LANES; ++j)
+                z1[s][j] = z2[s][j] = 0.0;
+    }
+
+    int getNumBands() const { return num_bands; }
+
+    // upper edge of band `band` out of `bands`, in Hz.
+    static double getCrossover(int band, int bands)
+    {
+        return BAND_LOWEST_HZ * std::pow(BAND_HIGHEST_HZ / BAND_LOWEST_HZ, (double)(band + 1) / (double) bands);
+    }
+
+    // filters `num` samples and adds the per band products to `sums`.
+    void accumulate(const float* left, const float* right, int num, BandSums& sums)
+    {
+        if (num_bands == 0)
+            return;
+
+        double ll[BAND_MAX_BANDS] = {}, rr[BAND_MAX_BANDS] = {}, lr[BAND_MAX_BANDS] = {};
+
+        for (int i = 0; i < num; ++i)
+        {
+            double x[BAND_LANES];
+
+            for (int j = 0; j < BAND_MAX_BANDS; ++j)
+            {
+                x[j] = left[i];
+                x[j + BAND_MAX_BANDS] = right[i];
+            }
+
+            // transposed direct form II, every lane at once.
+            for (int s = 0; s < BAND_STAGES; ++s)
+            {
+                for (int j = 0; j < BAND_LANES; ++j)
+                {
+                    const double y = b0[s][j] * x[j] + z1[s][j];
+                    z1[s][j] = b1[s][j] * x[j] - a1[s][j] * y + z2[s][j];
+                    z2[s][j] = b2[s][j] * x[j] - a2[s][j] * y;
+                    x[j] = y;
+                }
+            }
+
+            for (int j = 0; j < BAND_MAX_BANDS; ++j)
+            {
+                const double l = x[j];
+                const double r = x[j + BAND_MAX_BANDS];
+
+                ll[j] += l * l;
+                rr[j] += r * r;
+                lr[j] += l * r;
+            }
+        }
+
+        for (int b = 0; b < num_bands; ++b)
+        {
+            sums.ll[b] += ll[b];
+            sums.rr[b] += rr[b];
+            sums.lr[b] += lr[b];
+        }
+    }
+
+private:
+
+    void setPassThrough(int stage, int lane)
+    {
+        b0[stage][lane] = 1.0;
+        b1[stage][lane] = b2[stage][lane] = 0.0;
+        a1[stage][lane] = a2[stage][lane] = 0.0;
+    }
+
+    // 2nd order butterworth (Q = 1/sqrt(2)), from the RBJ cookbook.
+    void setButterworth(int stage, int lane, double frequency, double sample_rate, bool highpass)
+    {
+        // a crossover at or above nyquist leaves the band open on that side.
+        if (frequency >= 0.49 * sample_rate)
+        {
+            if (highpass)
+            {
+                // nothing of the band is left.
+                b0[stage][lane] = b1[stage][lane] = b2[stage][lane] = 0.0;
+                a1[stage][lane] = a2[stage][lane] = 0.0;
+            }
+            else
+            {
+                setPassThrough(stage, lane);
+            }
+
+            return;
+        }
+
+        const double w0    = 2.0 * 3.14159265358979323846 * frequency / sample_rate;
+        const double cosw  = std::cos(w0);
+        const double alpha = std::sin(w0) / (2.0 * 0.70710678118654752440);
+        const double a0    = 1.0 + alpha;
+
+        if (highpass)
+        {
+            b0[stage][lane] =  (1.0 + cosw) * 0.5 / a0;
+            b1[stage][lane] = -(1.0 + cosw)       / a0;
+            b2[stage][lane] =  (1.0 + cosw) * 0.5 / a0;
+        }
+        else
+        {
+            b0[stage][lane] = (1.0 - cosw) * 0.5 / a0;
+            b1[stage][lane] = (1.0 - cosw)       / a0;
+            b2[stage][lane] = (1.0 - cosw) * 0.5 / a0;
+        }
+
+        a1[stage][lane] = -2.0 * cosw    / a0;
+        a2[stage][lane] = (1.0 - alpha) / a0;
+    }
+
+    int num_bands = 0;
+
+    double b0[BAND_STAGES][BAND_LANES], b1[BAND_STAGES][BAND_LANES], b2[BAND_STAGES][BAND_LANES];
+    double a1[BAND_STAGES][BAND_LANES], a2[BAND_STAGES][BAND_LANES];
+    double z1[BAND_STAGES][BAND_LANES], z2[BAND_STAGES][BAND_LANES];
+};
@@ -1,14 +1,23 @@
 #include "Correlation.h"
 
-PhaseCorrelationAnalyserComponent::PhaseCorrelationAnalyserComponent(AudioProcessorValueTreeState& apvts_reference)
+PhaseCorrelationAnalyserComponent::PhaseCorrelationAnalyserComponent(AudioProcessorValueTreeState& apvts_reference,
+                                                                     PerfCounters* perf_counters)
     :   apvts_ref(apvts_reference),
+        perf(perf_counters),
         correl_amnt_comp(String("-1"), String("+1")),
+        volume_meter_comp(level_meter),
         balance_amnt_comp(String("L"), String("R"))
 {
+    opengl_comp.perf = perf;
+
     addAndMakeVisible(opengl_comp);
     addAndMakeVisible(volume_meter_comp);
     addAndMakeVisible(correl_amnt_comp);
     addAndMakeVisible(balance_amnt_comp);
+    addAndMakeVisible(loudness_readout_comp);
+    addChildComponent(band_meter_comp);
+
+    loudness_readout_comp.onReset = [this] { loudness_reset = true; };
 
     startTimerHz(REFRESH_RATE_HZ);
 
@@ -34,6 +43,8 @@ void PhaseCorrelationAnalyserComponent::paint(Graphics& g)
     correl_amnt_comp.accent_colour = accentColour;
     volume_meter_comp.accent_colour = accentColour;
     balance_amnt_comp.accent_colour = accentColour;
+    band_meter_comp.accent_colour = accentColour;
+    loudness_readout_comp.accent_colour = accentColour;
 }
 
 void PhaseCorrelationAnalyserComponent::resized()
@@ -47,6 +58,16 @@ void PhaseCorrelationAnalyserComponent::resized()
     auto corell_amount_bounds = bounds.removeFromRight(vol_bounds_width);
     auto balance_amount_bounds = bounds.removeFromBottom(vol_bounds_width);
 
+    loudness_readout_comp.setBounds(bounds.removeFromTop(std::clamp<int>(getHeight() * 0.05, 12, 20)));
+
+    // the band meter takes the bottom of the graph area, a row per band.
+    shown_bands = band_meter_comp.getNumBands();
+    band_meter_comp.setVisible(shown_bands > 0);
+
+    if (shown_bands > 0)
+        band_meter_comp.setBounds(bounds.removeFromBottom(
+            std::max<int>(shown_bands * 12, bounds.getHeight() / 4)));
+
     // Now select the biggest square that you can make out of the 
     // remaining bounds justified center.
     int wid = bounds.getWidth();
@@ -76,13 +97,22 @@ void PhaseCorrelationAnalyserComponent::resized()
 
 void PhaseCorrelationAnalyserComponent::timerCallback()
 {
+    PerfScope timer_scope(perf, PerfTimerCallback);
+
+    if (band_meter_comp.getNumBands() != shown_bands)
+        resized();
+
     if (dirty) {
         opengl_comp.repaint();
 
         volume_meter_comp.repaint();
+        loudness_readout_comp.repaint();
         correl_amnt_comp.repaint();
         balance_amnt_comp.repaint();
 
+        if (shown_bands > 0)
+            band_meter_comp.repaint();
+
         dirty = false;
     }
 
@@ -92,15 +122,11 @@ void PhaseCorrelationAnalyserComponent::prepareToPlay(float SR, float block_size
 {
     sample_rate = SR;
 
-    sample_counter = 0;
+    // allocated for the longest window the `v_rms_time` parameter allows.
+    float max_rms_time = apvts_ref.getParameterRange("v_rms_time").end;
 
-    while (SquareQueLL.size()) SquareQueLL.pop();
-    while (SquareQueRR.size()) SquareQueRR.pop();
-    while (SquareQueLR.size()) SquareQueLR.pop();
-    
-    sumLL = 0.0f;
-    sumRR = 0.0f;
-    sumLR = 0.0f;
+    correlation_meter.prepare(SR, max_rms_time * 0.001, TARGET_TRIGGER_HZ);
+    level_meter.prepare(SR, max_rms_time * 0.001);
 
     zeroOutMeters();
 }
@@ -109,147 +135,101 @@ void PhaseCorrelationAnalyserComponent::zeroOutMeters()
 {
     opengl_comp.newDataPoint(0.5f, 0.5f);
     correl_amnt_comp.newPoint(0.5f);
-    volume_meter_comp.newPoint(0.0f, 0.0f);
     balance_amnt_comp.newPoint(0.5);
+    level_meter.reset();
     volume_meter_comp.zeroOut();
+    loudness_readout_comp.newReadings(LoudnessReadings());
 }
 
-void PhaseCorrelationAnalyserComponent::processBlock(AudioBuffer<float>& buffer)
+void PhaseCorrelationAnalyserComponent::newLoudnessReadings(const LoudnessReadings& readings)
 {
-    float new_rms_time = apvts_ref.getRawParameterValue("v_rms_time")->load();
-    int new_window_length = (int)(sample_rate * new_rms_time * 0.001f);
-    update_window_samples    = (int)(sample_rate / (float)TARGET_TRIGGER_HZ);
+    loudness_readout_comp.newReadings(readings);
+    volume_meter_comp.newTruePeak(readings.true_peak_max);
+}
 
-    if (new_window_length != window_length_samples && new_window_length > 0)
+// NaN -> 0, then clamped to [-1, 1].
+static void sanitise(float* dest, const float* src, int num)
+{
+    for (int i = 0; i < num; ++i)
     {
-        window_length_samples = new_window_length;
-        sample_counter = 0;
-        while (!SquareQueLL.empty()) SquareQueLL.pop();
-        while (!SquareQueRR.empty()) SquareQueRR.pop();
-        while (!SquareQueLR.empty()) SquareQueLR.pop();
-        sumLL = 0.0f;
-        sumRR = 0.0f;
-        sumLR = 0.0f;
+        const float v = src[i];
+        dest[i] = (v == v) ? v : 0.0f;
     }
 
-    if (window_length_samples <= 0)
-        return;
-
-    float* left_channel  = buffer.getWritePointer(0);
-    float* right_channel = buffer.getWritePointer(1);
-    int block_size = buffer.getNumSamples();
-
-    static int recalc_counter = 0;
-    const int RECALC_INTERVAL = 32768;
+    FloatVectorOperations::clip(dest, dest, -1.0f, 1.0f, num);
+}
 
-    for (int i = 0; i < block_size; ++i)
-    {
-        float left_sample  = std::isnan(left_channel[i])  ? 0.0f : std::clamp(left_channel[i],  -1.0f, 1.0f);
-        float right_sample = std::isnan(right_channel[i]) ? 0.0f : std::clamp(right_channel[i], -1.0f, 1.0f);
-        
-        // Send to opengl_comp every 3rd sample
-        
-        float xx = left_sample * 0.5f + 0.5f;
-        float yy = right_sample * 0.5f + 0.5f;
-        xx = jmap<float>(xx, 0.0f, 1.0f, 0.15f, 0.85f);
-        yy = jmap<float>(yy, 0.0f, 1.0f, 0.15f, 0.85f);
-        
-        const float centerX = 0.5f;
-        const float centerY = 0.5f;
-        float translatedX = xx - centerX;
-        float translatedY = yy - centerY;
-        const float cosAngle = 0.707107f;
-        const float sinAngle = 0.707107f;
-        float rotatedX = translatedX * cosAngle - translatedY * sinAngle;
-        float rotatedY = translatedX * sinAngle + translatedY * cosAngle;
-        float finalX = std::clamp(rotatedX + centerX, 0.0f, 1.0f);
-        float finalY = std::clamp(rotatedY + centerY, 0.0f, 1.0f);
-        
-        opengl_comp.newDataPoint(finalX, finalY);
-        
-        float LL = left_sample  * left_sample;
-        float RR = right_sample * right_sample;
-        float LR = left_sample  * right_sample;
+void PhaseCorrelationAnalyserComponent::processBlock(AudioBuffer<float>& buffer)
+{
+    opengl_comp.setDensityMode(apvts_ref.getRawParameterValue("v_gonio")->load() > 0.5f);
 
-        sumLL += LL;  sumRR += RR;  sumLR += LR;
-        
-        SquareQueLL.push(LL);
-        SquareQueRR.push(RR);
-        SquareQueLR.push(LR);
+    // the line covers a fixed duration whatever the sample rate,
+    // decimated so it fits in the ring.
+    float gonio_ms = apvts_ref.getRawParameterValue("v_gonio_ms")->load();
+    int history_samples = std::max((int)(sample_rate * gonio_ms * 0.001f), 2);
+    int decimation_step = (history_samples + RING_BUFFER_TEXEL_SIZE - 1) / RING_BUFFER_TEXEL_SIZE;
+    opengl_comp.setLineHistory(decimation_step, history_samples / decimation_step);
 
-        while ((int)SquareQueLL.size() > window_length_samples)
-        {
-            sumLL -= SquareQueLL.front();  
-            SquareQueLL.pop();
-
-            sumRR -= SquareQueRR.front();  
-            SquareQueRR.pop();
-            
-            sumLR -= SquareQueLR.front();  
-            SquareQueLR.pop();
-        }
+    // the window slides a whole chunk at a time, so its length is rounded to chunks.
+    float new_rms_time = apvts_ref.getRawParameterValue("v_rms_time")->load();
+    correlation_meter.setChunkRate(TARGET_TRIGGER_HZ / update_rate_divider.load());
+    correlation_meter.setWindow(new_rms_time * 0.001);
 
-        if (++recalc_counter >= RECALC_INTERVAL)
-        {
-            recalc_counter = 0;
-            recalculateSums();
-        }
+    int new_ballistics = jlimit(0, 3, (int) apvts_ref.getRawParameterValue("v_meter")->load());
+    level_meter.setBallistics((LevelMeter::Ballistics) new_ballistics);
+    level_meter.setRmsTime(new_rms_time * 0.001);
 
-        if (++sample_counter >= update_window_samples)
-        {
-            sample_counter = 0;
+    static const int bandsTable[] = { 0, 3, 5, 8 };
+    correlation_meter.setBands(bandsTable[jlimit(0, 3, (int) apvts_ref.getRawParameterValue("v_bands")->load())]);
 
-            float denom = std::sqrt(sumLL * sumRR);
-            if (denom < 1e-6f) denom = 1e-6f;
+    const float* left_channel  = buffer.getReadPointer(0);
+    const float* right_channel = buffer.getNumChannels() > 1 ? buffer.getReadPointer(1) : left_channel;
+    int block_size = buffer.getNumSamples();
 
-            float y_comp = sumLR / denom;
+    for (int offset = 0; offset < block_size; offset += CORRELATION_SCRATCH_SIZE)
+    {
+        const int num = std::min(CORRELATION_SCRATCH_SIZE, block_size - offset);
 
-            y_comp = y_comp * 0.5f + 0.5f;
-            y_comp = 1.0 - y_comp;
-            y_comp = std::clamp(y_comp, 0.0f, 1.0f);
+        sanitise(scratch_l, left_channel  + offset, num);
+        sanitise(scratch_r, right_channel + offset, num);
 
-            float rmsL = std::sqrt(sumLL / (float)window_length_samples);
-            float rmsR = std::sqrt(sumRR / (float)window_length_samples);
+        // lissajous points, the [0.15, 0.85] remap and the 45 degree rotation
+        // folded into x = 0.5 + k(l - r), y = 0.5 + k(l + r).
+        const float k = 0.35f * 0.707107f;
 
-            const float noiseGate = 5e-4f;
-            if (rmsL < noiseGate) rmsL = 0.0f;
-            if (rmsR < noiseGate) rmsR = 0.0f;
+        FloatVectorOperations::subtract(scratch_x, scratch_l, scratch_r, num);
+        FloatVectorOperations::multiply(scratch_x, k, num);
+        FloatVectorOperations::add(scratch_x, 0.5f, num);
+        FloatVectorOperations::clip(scratch_x, scratch_x, 0.0f, 1.0f, num);
 
-            float x_comp = 0.0f;
-            if (rmsL + rmsR > 1e-8f)
-                x_comp = (rmsR - rmsL) / (rmsL + rmsR);
+        FloatVectorOperations::add(scratch_y, scratch_l, scratch_r, num);
+        FloatVectorOperations::multiply(scratch_y, k, num);
+        FloatVectorOperations::add(scratch_y, 0.5f, num);
+        FloatVectorOperations::clip(scratch_y, scratch_y, 0.0f, 1.0f, num);
 
-            x_comp = x_comp * 0.5f + 0.5f;
-            x_comp = std::clamp(x_comp, 0.0f, 1.0f);
+        opengl_comp.newDataBlock(scratch_x, scratch_y, num);
 
-            correl_amnt_comp.newPoint(y_comp);
-            volume_meter_comp.newPoint(rmsL, rmsR);
-            balance_amnt_comp.newPoint(x_comp);
+        const float* level_channels[] = { scratch_l, scratch_r };
+        level_meter.process(level_channels, 2, num);
 
-            dirty = true;
-        }
+        correlation_meter.process(scratch_l, scratch_r, num,
+            [this](const CorrelationReadings& readings) { newCorrelationReadings(readings); });
     }
 }
 
-void PhaseCorrelationAnalyserComponent::recalculateSums()
+void PhaseCorrelationAnalyserComponent::newCorrelationReadings(const CorrelationReadings& readings)
 {
-    sumLL = 0.0f;
-    sumRR = 0.0f;
-    sumLR = 0.0f;
-    
-    std::queue<float> tempLL = SquareQueLL;
-    std::queue<float> tempRR = SquareQueRR;
-    std::queue<float> tempLR = SquareQueLR;
-    
-    while (!tempLL.empty())
-    {
-        sumLL += tempLL.front();
-        sumRR += tempRR.front();
-        sumLR += tempLR.front();
-        tempLL.pop();
-        tempRR.pop();
-        tempLR.pop();
-    }
+    if (readings.bands > 0 || band_meter_comp.getNumBands() != 0)
+        band_meter_comp.newPoints(readings.band_correlation, readings.band_balance, readings.bands);
+
+    // +1 at the top.
+    float y_comp = 1.0f - (readings.correlation * 0.5f + 0.5f);
+    float x_comp = readings.balance * 0.5f + 0.5f;
+
+    correl_amnt_comp.newPoint(std::clamp(y_comp, 0.0f, 1.0f));
+    balance_amnt_comp.newPoint(std::clamp(x_comp, 0.0f, 1.0f));
+
+    dirty = true;
 }
 
 PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
@@ -257,6 +237,9 @@ CorrelationOpenGLComponent()
 {
     setOpaque(true);
 
+    density.assign(GONIO_DENSITY_SIZE * GONIO_DENSITY_SIZE, 0.0f);
+    line_vertices.assign(RING_BUFFER_TEXEL_SIZE * 5, 0.0f);
+
     opengl_context.setOpenGLVersionRequired(OpenGLContext::OpenGLVersion::openGL3_2);
 
     opengl_context.setRenderer(this);
@@ -289,75 +272,203 @@ parameterValueChanged(int index, float newValue)
 {
     const float* clrs = getAccentColoursForCode((int)(newValue * 10));
     for (int i = 0; i < 6; ++i) colours[i] = clrs[i];
+
+    colour_map_code.store((int)(newValue * 10));
 }
 
 void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
 newDataPoint(float x, float y)
 {
+    newDataBlock(&x, &y, 1);
+}
 
-    // not locking as the contention is very low and 
-    // cannot even be seen.
+void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
+newDataBlock(const float* x, const float* y, int num)
+{
+    // every point goes to the density grid, whatever does not fit
+    // (nothing is drawing) is dropped.
+    if (density_mode.load())
+    {
+        int start1, size1, start2, size2;
+        xy_fifo.prepareToWrite(num, start1, size1, start2, size2);
 
-    int write_index = (ring_buf_read_index.load() + 1) % RING_BUFFER_TEXEL_SIZE;
+        FloatVectorOperations::copy(xy_fifo_data[0] + start1, x, size1);
+        FloatVectorOperations::copy(xy_fifo_data[1] + start1, y, size1);
 
-    ring_buffer[2 * write_index] = x;
-    ring_buffer[2 * write_index + 1] = y;
+        if (size2 > 0)
+        {
+            FloatVectorOperations::copy(xy_fifo_data[0] + start2, x + size1, size2);
+            FloatVectorOperations::copy(xy_fifo_data[1] + start2, y + size1, size2);
+        }
 
-    ring_buf_read_index.store(write_index);
+        xy_fifo.finishedWrite(size1 + size2);
+    }
+
+    // the kept samples of the block, every `decimation`th one of the stream.
+    int first = decimation_phase;
+    int kept = (first < num) ? (num - first + decimation - 1) / decimation : 0;
+    decimation_phase = first + kept * decimation - num;
+
+    // only the newest points fit.
+    if (kept > RING_BUFFER_TEXEL_SIZE)
+    {
+        first += (kept - RING_BUFFER_TEXEL_SIZE) * decimation;
+        kept = RING_BUFFER_TEXEL_SIZE;
+    }
+
+    // published once for the whole block.
+    const uint32 seq = ring_seq.load(std::memory_order_relaxed);
+    ring_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    int write_index = ring_buf_read_index;
+
+    for (int k = 0, i = first; k < kept; ++k, i += decimation)
+    {
+        if (++write_index == RING_BUFFER_TEXEL_SIZE) write_index = 0;
+
+        ring_buffer[2 * write_index] = x[i];
+        ring_buffer[2 * write_index + 1] = y[i];
+    }
+
+    ring_buf_read_index = write_index;
+    ring_visible = visible_points;
+
+    ring_seq.store(seq + 2, std::memory_order_release);
 
     dirty.store(true);
 }
 
 void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
-newOpenGLContextCreated()
+setLineHistory(int decimation_step, int points)
 {
+    decimation_step = jmax(1, decimation_step);
 
-    using namespace juce::gl;
-    createShaders();
+    if (decimation_step != decimation)
+    {
+        decimation = decimation_step;
+        decimation_phase = 0;
+    }
 
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    visible_points = jlimit(2, RING_BUFFER_TEXEL_SIZE, points);
+}
 
-    glGenTextures (1, &dataTexture);
-    glBindTexture (GL_TEXTURE_1D, dataTexture);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexImage1D(
-        GL_TEXTURE_1D,
-        0,
-        GL_RG32F,
-        RING_BUFFER_TEXEL_SIZE, // each texel is 2 floats.
-        0,
-        GL_RG,
-        GL_FLOAT,
-        ring_buffer);
-
-    ring_buf_read_index = 0;
+void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
+takeLineSnapshot()
+{
+    const int next = 1 - snapshot_current;
 
-    send_triggerRepaint = true;
-    //opengl_context.triggerRepaint();
+    // a few attempts, the writer holds the ring for a block's worth of copies at most.
+    for (int attempt = 0; attempt < 4; ++attempt)
+    {
+        const uint32 before = ring_seq.load(std::memory_order_acquire);
+        if (before & 1u)
+            continue;
+
+        std::memcpy(line_snapshot[next], ring_buffer, sizeof(ring_buffer));
+        const int newest  = ring_buf_read_index;
+        const int visible = ring_visible;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (ring_seq.load(std::memory_order_relaxed) == before)
+        {
+            snapshot_current = next;
+            snapshot_newest  = newest;
+            snapshot_visible = visible;
+            return;
+        }
+    }
+
+    // the writer kept us out, the previous snapshot is drawn again.
 }
 
-void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::renderOpenGL()
+void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
+accumulateDensity()
 {
+    const SpinLock::ScopedLockType lock(density_lock);
+
+    const int cells = GONIO_DENSITY_SIZE * GONIO_DENSITY_SIZE;
+
+    // exponential fade by the real time between frames, so the
+    // persistence does not depend on the frame rate.
+    const double now = Time::getMillisecondCounterHiRes();
+    const double elapsed = (last_fade_ms > 0.0) ? (now - last_fade_ms) * 0.001 : 0.0;
+    last_fade_ms = now;
+
+    FloatVectorOperations::multiply(density.data(), (float) std::exp(-elapsed / GONIO_PERSISTENCE_S), cells);
+
+    int start1, size1, start2, size2;
+    xy_fifo.prepareToRead(xy_fifo.getNumReady(), start1, size1, start2, size2);
+
+    splatPoints(xy_fifo_data[0] + start1, xy_fifo_data[1] + start1, size1);
+    if (size2 > 0)
+        splatPoints(xy_fifo_data[0] + start2, xy_fifo_data[1] + start2, size2);
+
+    xy_fifo.finishedRead(size1 + size2);
+
+    density_peak = jmax(FloatVectorOperations::findMaximum(density.data(), cells), GONIO_MIN_PEAK);
+}
+
+void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
+splatPoints(const float* x, const float* y, int num)
+{
+    const float scale = (float)(GONIO_DENSITY_SIZE - 1);
+    float* grid = density.data();
+
+    // bilinear splat, a point spreads over the 4 cells around it.
+    for (int i = 0; i < num; ++i)
+    {
+        const float gx = jlimit(0.0f, 1.0f, x[i]) * scale;
+        const float gy = jlimit(0.0f, 1.0f, y[i]) * scale;
+
+        const int ix = jmin((int) gx, GONIO_DENSITY_SIZE - 2);
+        const int iy = jmin((int) gy, GONIO_DENSITY_SIZE - 2);
+
+        const float fx = gx - (float) ix;
+        const float fy = gy - (float) iy;
+
+        float* cell = grid + iy * GONIO_DENSITY_SIZE + ix;
+
+        cell[0]                      += (1.0f - fx) * (1.0f - fy);
+        cell[1]                      += fx * (1.0f - fy);
+        cell[GONIO_DENSITY_SIZE]     += (1.0f - fx) * fy;
+        cell[GONIO_DENSITY_SIZE + 1] += fx * fy;
+    }
+}
+
+void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
+newOpenGLContextCreated()
+{
+
     using namespace juce::gl;
-    
-    if (!shader) return;
+    createShaders();
 
-    const float renderingScale = (float)opengl_context.getRenderingScale();
-    glViewport(0, 0, roundToInt(renderingScale * getWidth()), roundToInt(renderingScale * getHeight()));
+    if (!shader || !density_shader)
+    {
+        // no usable open gl, paint in software from now on.
+        software_fallback = true;
+
+        Component::SafePointer<CorrelationOpenGLComponent> safe_this(this);
+        MessageManager::callAsync([safe_this]
+        {
+            if (safe_this != nullptr)
+            {
+                safe_this->opengl_context.detach();
+                safe_this->repaint();
+            }
+        });
+
+        return;
+    }
+
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    // storage for the line, refilled with glBufferSubData every frame.
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, line_vertices.size() * sizeof(GLfloat), nullptr, GL_STREAM_DRAW);
 
-    OpenGLHelpers::clear(Colours::black);
-    
-    shader->use();
-    
-    int read_idx = ring_buf_read_index.load();
-    
-    // Build vertex buffer with positions and colors
-    std::vector<GLfloat> vertices;
-    vertices.reserve((RING_BUFFER_TEXEL_SIZE + 12) * 5); // Lissajous + grid lines
-    
     // Grid lines (diamond overlay)
     const float gridColor = 0.3f;
     GLfloat gridLines[] = {
@@ -376,69 +487,297 @@ void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::renderOpenGL
         0.25f, 0.25f, gridColor, gridColor, gridColor,
         0.75f, 0.75f, gridColor, gridColor, gridColor
     };
+
+    glGenBuffers(1, &gridVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(gridLines), gridLines, GL_STATIC_DRAW);
+
+    GLfloat quad[] = { 0.0f, 0.0f,  1.0f, 0.0f,  0.0f, 1.0f,  1.0f, 1.0f };
+
+    glGenBuffers(1, &quadVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+    glGenTextures(1, &densityTexture);
+    glBindTexture(GL_TEXTURE_2D, densityTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F,
+                 GONIO_DENSITY_SIZE, GONIO_DENSITY_SIZE,
+                 0, GL_RED, GL_FLOAT, nullptr);
+
+    glGenTextures(1, &colourMapTexture);
+    glBindTexture(GL_TEXTURE_1D, colourMapTexture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB32F,
+                 COLOUR_MAP_NUM_COLOURS, 0,
+                 GL_RGB, GL_FLOAT, getColourMapForCode(colour_map_code.load()));
+
+    send_triggerRepaint = true;
+    //opengl_context.triggerRepaint();
+}
+
+void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::renderOpenGL()
+{
+    using namespace juce::gl;
     
+    if (!shader || !density_shader) return;
+
+    PerfScope render_scope(perf, PerfGLRender);
+    size_t uploaded = 0;
+
+    const float renderingScale = (float)opengl_context.getRenderingScale();
+    glViewport(0, 0, roundToInt(renderingScale * getWidth()), roundToInt(renderingScale * getHeight()));
+
+    OpenGLHelpers::clear(Colours::black);
+
+    if (density_mode.load())
+        uploaded += renderDensity();
+
+    shader->use();
+
     // Draw grid
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(gridLines), gridLines, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
     glEnableVertexAttribArray(1);
     glLineWidth(1.5f * renderingScale);
     glDrawArrays(GL_LINES, 0, 12);
+
+    if (!density_mode.load())
+        uploaded += renderLines(renderingScale);
     
-    // Lissajous curve
-    for (int i = 0; i < RING_BUFFER_TEXEL_SIZE; ++i)
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+
+    if (perf) perf->record(PerfGLUpload, uploaded);
+}
+
+size_t PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
+renderLines(float renderingScale)
+{
+    using namespace juce::gl;
+
+    takeLineSnapshot();
+
+    const GLfloat* points = line_snapshot[snapshot_current];
+    const int visible = snapshot_visible;
+    const int oldest = snapshot_newest - visible + 1 + RING_BUFFER_TEXEL_SIZE;
+
+    // Lissajous curve, written in place into the persistent vertex array.
+    GLfloat* v = line_vertices.data();
+
+    for (int i = 0; i < visible; ++i)
     {
-        int idx = (read_idx + i) % RING_BUFFER_TEXEL_SIZE;
-        float x = ring_buffer[2 * idx];
-        float y = ring_buffer[2 * idx + 1];
+        int idx = (oldest + i) % RING_BUFFER_TEXEL_SIZE;
         
-        float t = (float)i / (float)(RING_BUFFER_TEXEL_SIZE - 1);
+        float t = (float)i / (float)(visible - 1);
         float r = colours[0] * (1.0f - t) + colours[3] * t;
         float g = colours[1] * (1.0f - t) + colours[4] * t;
         float b = colours[2] * (1.0f - t) + colours[5] * t;
         
-        vertices.push_back(x);
-        vertices.push_back(y);
-        vertices.push_back(r * t * t);
-        vertices.push_back(g * t * t);
-        vertices.push_back(b * t * t);
+        *v++ = points[2 * idx];
+        *v++ = points[2 * idx + 1];
+        *v++ = r * t * t;
+        *v++ = g * t * t;
+        *v++ = b * t * t;
     }
     
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, visible * 5 * sizeof(GLfloat), line_vertices.data());
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
     glLineWidth(2.0f * renderingScale);
-    glDrawArrays(GL_LINE_STRIP, 0, RING_BUFFER_TEXEL_SIZE);
-    
+    glDrawArrays(GL_LINE_STRIP, 0, visible);
+
+    return visible * 5 * sizeof(GLfloat);
+}
+
+size_t PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
+renderDensity()
+{
+    using namespace juce::gl;
+
+    accumulateDensity();
+
+    density_shader->use();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, densityTexture);
+
+    {
+        const SpinLock::ScopedLockType lock(density_lock);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+                        GONIO_DENSITY_SIZE, GONIO_DENSITY_SIZE,
+                        GL_RED, GL_FLOAT, density.data());
+
+        if (density_uniforms->densityScale)
+            density_uniforms->densityScale->set(1.0f / std::log(1.0f + density_peak));
+    }
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_1D, colourMapTexture);
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, COLOUR_MAP_NUM_COLOURS,
+                    GL_RGB, GL_FLOAT, getColourMapForCode(colour_map_code.load()));
+
+    if (density_uniforms->densityData)
+        density_uniforms->densityData->set(0);
+
+    if (density_uniforms->colourMapTex)
+        density_uniforms->colourMapTex->set(1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
+
+    glActiveTexture(GL_TEXTURE0);
+
+    return sizeof(float) * (GONIO_DENSITY_SIZE * GONIO_DENSITY_SIZE + 3 * COLOUR_MAP_NUM_COLOURS);
+}
+
+void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
+paint(Graphics& g)
+{
+    if (!software_fallback.load())
+        return;
+
+    paintSoftware(g);
+}
+
+void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
+paintSoftware(Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    auto bounds = getLocalBounds().toFloat();
+
+    // (0, 0) is the bottom left corner, like in the gl view.
+    auto toScreen = [&bounds](float x, float y)
+    {
+        return Point<float>(bounds.getX() + x * bounds.getWidth(),
+                            bounds.getBottom() - y * bounds.getHeight());
+    };
+
+    if (density_mode.load())
+    {
+        accumulateDensity();
+
+        if (!density_image.isValid())
+            density_image = Image(Image::RGB, GONIO_DENSITY_SIZE, GONIO_DENSITY_SIZE, true);
+
+        const float* cmap = getColourMapForCode(colour_map_code.load());
+
+        {
+            const SpinLock::ScopedLockType lock(density_lock);
+
+            const float density_scale = 1.0f / std::log(1.0f + density_peak);
+            Image::BitmapData pixels(density_image, Image::BitmapData::writeOnly);
+
+            for (int iy = 0; iy < GONIO_DENSITY_SIZE; ++iy)
+            {
+                const float* row = density.data() + iy * GONIO_DENSITY_SIZE;
+
+                for (int ix = 0; ix < GONIO_DENSITY_SIZE; ++ix)
+                {
+                    const float t = jlimit(0.0f, 1.0f, std::log(1.0f + row[ix]) * density_scale);
+
+                    // same lookup as the shader, linear between the colourmap entries.
+                    const float pos = t * (COLOUR_MAP_NUM_COLOURS - 1);
+                    const int c0 = jmin((int) pos, COLOUR_MAP_NUM_COLOURS - 2);
+                    const float f = pos - (float) c0;
+                    const float fade = jlimit(0.0f, 1.0f, t / 0.05f);
+
+                    auto channel = [&](int k)
+                    {
+                        const float v = (cmap[3 * c0 + k] * (1.0f - f) + cmap[3 * (c0 + 1) + k] * f) * fade;
+                        return (uint8) jlimit(0, 255, roundToInt(v * 255.0f));
+                    };
+
+                    pixels.setPixelColour(ix, GONIO_DENSITY_SIZE - 1 - iy,
+                                          Colour(channel(0), channel(1), channel(2)));
+                }
+            }
+        }
+
+        g.drawImage(density_image, bounds, RectanglePlacement::stretchToFit);
+    }
+
+    g.setColour(Colour::fromFloatRGBA(0.3f, 0.3f, 0.3f, 1.0f));
+
+    const float diamond[][4] = {
+        { 0.0f, 0.5f, 0.5f, 0.0f }, { 0.0f, 0.5f, 0.5f, 1.0f },
+        { 1.0f, 0.5f, 0.5f, 0.0f }, { 1.0f, 0.5f, 0.5f, 1.0f },
+        { 0.25f, 0.75f, 0.75f, 0.25f }, { 0.25f, 0.25f, 0.75f, 0.75f }
+    };
+
+    for (auto& l : diamond)
+        g.drawLine(Line<float>(toScreen(l[0], l[1]), toScreen(l[2], l[3])), 1.5f);
+
+    if (!density_mode.load())
+    {
+        takeLineSnapshot();
+
+        const GLfloat* points = line_snapshot[snapshot_current];
+        const int oldest = snapshot_newest - snapshot_visible + 1 + RING_BUFFER_TEXEL_SIZE;
+
+        Path path;
+        for (int i = 0; i < snapshot_visible; ++i)
+        {
+            int idx = (oldest + i) % RING_BUFFER_TEXEL_SIZE;
+            auto p = toScreen(points[2 * idx], points[2 * idx + 1]);
+
+            if (i == 0) path.startNewSubPath(p);
+            else        path.lineTo(p);
+        }
+
+        g.setColour(Colour::fromFloatRGBA(colours[3], colours[4], colours[5], 1.0f));
+        g.strokePath(path, PathStrokeType(1.5f));
+    }
 }
 
 void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
 openGLContextClosing()
 {
+    using namespace juce::gl;
+
     send_triggerRepaint = false;
     opengl_context.setContinuousRepainting(false);
 
 
     // Delete OpenGL buffers
-    if (VBO != 0)
+    for (GLuint* buffer : { &VBO, &EBO, &gridVBO, &quadVBO })
     {
-        opengl_context.extensions.glDeleteBuffers(1, &VBO);
-        VBO = 0;
+        if (*buffer != 0)
+        {
+            opengl_context.extensions.glDeleteBuffers(1, buffer);
+            *buffer = 0;
+        }
     }
-    if (EBO != 0)
+
+    for (GLuint* texture : { &densityTexture, &colourMapTexture })
     {
-        opengl_context.extensions.glDeleteBuffers(1, &EBO);
-        EBO = 0;
+        if (*texture != 0)
+        {
+            glDeleteTextures(1, texture);
+            *texture = 0;
+        }
     }
 
     // Delete shader program and uniforms
     shader.reset();
     shader_uniforms.reset();
 
+    density_shader.reset();
+    density_uniforms.reset();
 }
 
 void PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::
@@ -461,11 +800,28 @@ createShaders()
     {
         DBG(shaderProgramAttempt->getLastError());
     }
+
+    std::unique_ptr<OpenGLShaderProgram> densityAttempt = std::make_unique<OpenGLShaderProgram>(opengl_context);
+
+    if (densityAttempt->addVertexShader(OpenGLHelpers::translateVertexShaderToV3(densityVertexShader))
+        && densityAttempt->addFragmentShader(OpenGLHelpers::translateFragmentShaderToV3(densityFragmentShader))
+        && densityAttempt->link())
+    {
+        density_shader = std::move(densityAttempt);
+        density_uniforms.reset(new Uniforms(opengl_context, *density_shader));
+    }
+    else
+    {
+        DBG(densityAttempt->getLastError());
+    }
 }
 
 PhaseCorrelationAnalyserComponent::CorrelationOpenGLComponent::Uniforms::
 Uniforms(OpenGLContext& OpenGL_Context, OpenGLShaderProgram& shader_program)
 {
+    densityData.reset(createUniform(OpenGL_Context, shader_program, "densityData"));
+    colourMapTex.reset(createUniform(OpenGL_Context, shader_program, "colourMapTex"));
+    densityScale.reset(createUniform(OpenGL_Context, shader_program, "densityScale"));
 }
 
 OpenGLShaderProgram::Uniform* PhaseCorrelationAnalyserComponent::
@@ -608,125 +964,154 @@ void PhaseCorrelationAnalyserComponent::ValueMeterComponent::newPoint(float y_va
     pres_value.store(new_value);
 }
 
-PhaseCorrelationAnalyserComponent::VolumeMeterComponent::VolumeMeterComponent()
+PhaseCorrelationAnalyserComponent::LoudnessReadoutComponent::LoudnessReadoutComponent()
 {
+    newReadings(LoudnessReadings());
 }
 
-void PhaseCorrelationAnalyserComponent::VolumeMeterComponent::zeroOut()
+void PhaseCorrelationAnalyserComponent::LoudnessReadoutComponent::newReadings(const LoudnessReadings& readings)
 {
-    l_rms_vol.store(0.0f);
-    r_rms_vol.store(0.0f);
-
-    l_rms_vol_smoothed = 0.0f;
-    r_rms_vol_smoothed = 0.0f;
+    momentary.store(readings.momentary);
+    short_term.store(readings.short_term);
+    integrated.store(readings.integrated);
+    range.store(readings.range);
+    true_peak_max.store(readings.true_peak_max);
 }
 
-static float gain_to_db(float gain)
+void PhaseCorrelationAnalyserComponent::LoudnessReadoutComponent::mouseDown(const MouseEvent&)
 {
-    return 20.0 * log10f(gain);
+    if (onReset) onReset();
 }
 
-static float custom_remap(float vol_dB)
+static String loudness_to_text(float value)
 {
-    vol_dB = std::clamp<float>(vol_dB, -80.0, 0.0);
-    return jmap<float>(vol_dB, -80.0, 0.0, 0.0, 1.0);
+    return std::isfinite(value) ? String(value, 1) : String("-inf");
 }
 
-void PhaseCorrelationAnalyserComponent::VolumeMeterComponent::paint(Graphics& g)
+void PhaseCorrelationAnalyserComponent::LoudnessReadoutComponent::paint(Graphics& g)
 {
     g.fillAll(juce::Colours::black);
 
-    int padding = std::max(1.0, 0.1 * getWidth());
+    g.setColour(accent_colour);
+    g.fillRect(getLocalBounds().removeFromBottom(1));
 
-    auto bounds = getLocalBounds();
+    const float tp = true_peak_max.load();
 
-    auto right = bounds.removeFromRight(padding);
+    const String cells[] = {
+        "M "   + loudness_to_text(momentary.load()),
+        "S "   + loudness_to_text(short_term.load()),
+        "I "   + loudness_to_text(integrated.load()),
+        "LRA " + String(range.load(), 1),
+        "TP "  + loudness_to_text(tp)
+    };
 
-    g.setColour(accent_colour);
-    g.fillRect(right);
-
-    bounds.removeFromLeft(1);
-    bounds.removeFromRight(1);
-
-    auto center_line_bounds = bounds;
-    center_line_bounds.removeFromTop(bounds.getHeight() / 2);
-    center_line_bounds.removeFromBottom(bounds.getHeight() / 2 - 1);
-
-    float l_vol_frac = custom_remap(gain_to_db(
-        std::clamp<float>(l_rms_vol.load(), 0.0, 1.0)
-    ));
-    float r_vol_frac = custom_remap(gain_to_db(
-        std::clamp<float>(r_rms_vol.load(), 0.0, 1.0)
-    ));
-    float l_vol_frac_smooth = custom_remap(gain_to_db(
-        std::clamp<float>(l_rms_vol_smoothed, 0.0, 1.0)
-    ));
-    float r_vol_frac_smooth = custom_remap(gain_to_db(
-        std::clamp<float>(r_rms_vol_smoothed, 0.0, 1.0)
-    ));
-
-    auto left_bar_bounds = bounds.removeFromLeft(bounds.getWidth() / 2);
-    auto right_bar_bounds = bounds;
-
-    auto left_background_bar_bound = left_bar_bounds;
-    auto right_background_bar_bound = right_bar_bounds;
-
-    if (left_bar_bounds.getWidth() > 1 && right_bar_bounds.getWidth() > 1)
-    {
-        left_bar_bounds.removeFromRight(1);
-        left_background_bar_bound.removeFromRight(1);
-    }
+    auto bounds = getLocalBounds();
+    bounds.removeFromBottom(1);
 
-    int half_remove_left  = (1.0 - l_vol_frac) * bounds.getHeight() * 0.5;
-    int half_remove_right = (1.0 - r_vol_frac) * bounds.getHeight() * 0.5;
+    const int num_cells = (int) std::size(cells);
+    const int cell_width = bounds.getWidth() / num_cells;
 
-    int half_remove_left_smooth  = (1.0 - l_vol_frac_smooth) * bounds.getHeight() * 0.5;
-    int half_remove_right_smooth = (1.0 - r_vol_frac_smooth) * bounds.getHeight() * 0.5;
+    g.setFont(std::max(8.0f, bounds.getHeight() * 0.75f));
 
-    left_bar_bounds.removeFromTop(half_remove_left);
-    left_bar_bounds.removeFromBottom(half_remove_left);
+    for (int i = 0; i < num_cells; ++i)
+    {
+        auto cell = (i == num_cells - 1) ? bounds : bounds.removeFromLeft(cell_width);
 
-    right_bar_bounds.removeFromTop(half_remove_right);
-    right_bar_bounds.removeFromBottom(half_remove_right);
+        // over the usual -1 dBTP delivery ceiling.
+        bool over = (i == num_cells - 1) && tp > -1.0f;
+        g.setColour(over ? juce::Colours::red : juce::Colours::white);
 
-    left_background_bar_bound.removeFromTop(half_remove_left_smooth);
-    left_background_bar_bound.removeFromBottom(half_remove_left_smooth);
+        g.drawFittedText(cells[i], cell, Justification::centred, 1);
+    }
+}
 
-    right_background_bar_bound.removeFromTop(half_remove_right_smooth);
-    right_background_bar_bound.removeFromBottom(half_remove_right_smooth);
+void PhaseCorrelationAnalyserComponent::LoudnessReadoutComponent::resized()
+{
+}
+
+PhaseCorrelationAnalyserComponent::BandMeterComponent::BandMeterComponent()
+{
+    for (int b = 0; b < BAND_MAX_BANDS; ++b)
+    {
+        band_correlation[b].store(0.0f);
+        band_balance[b].store(0.0f);
+    }
+}
 
-    g.setColour(juce::Colours::darkgrey);
-    g.fillRect(left_background_bar_bound);
-    g.fillRect(right_background_bar_bound);
+void PhaseCorrelationAnalyserComponent::BandMeterComponent::newPoints(const float* correlation, const float* balance, int bands)
+{
+    for (int b = 0; b < bands; ++b)
+    {
+        // one pole smoothing filter.
+        float prev_corr = band_correlation[b].load();
+        float prev_bal  = band_balance[b].load();
 
-    g.setColour(juce::Colours::white);
-    g.fillRect(left_bar_bounds);
-    g.fillRect(right_bar_bounds);
+        band_correlation[b].store(prev_corr + (correlation[b] - prev_corr) * alpha);
+        band_balance[b].store(prev_bal + (balance[b] - prev_bal) * alpha);
+    }
 
-    g.setColour(juce::Colours::darkgrey.withAlpha(0.5f));
-    g.fillRect(center_line_bounds);
+    num_bands.store(bands);
 }
 
-void PhaseCorrelationAnalyserComponent::VolumeMeterComponent::resized()
+static String format_band_edge(double hz)
 {
+    if (hz < 1000.0) return String(roundToInt(hz));
+    return String(hz / 1000.0, 1) + "k";
 }
 
-void PhaseCorrelationAnalyserComponent::VolumeMeterComponent::newPoint(float l_vol, float r_vol)
+void PhaseCorrelationAnalyserComponent::BandMeterComponent::paint(Graphics& g)
 {
-    if (std::isnan(l_vol)) l_vol = 0.0f;
-    if (std::isnan(r_vol)) r_vol = 0.0f;
+    g.fillAll(juce::Colours::black);
+
+    const int bands = num_bands.load();
+    if (bands == 0)
+        return;
+
+    auto bounds = getLocalBounds().reduced(2);
+    const float row_height = (float) bounds.getHeight() / (float) bands;
+    const int label_width = std::max(30, bounds.getWidth() / 6);
 
-    float prev_l_vol = l_rms_vol_smoothed;
-    float prev_r_vol = r_rms_vol_smoothed;
+    g.setFont(std::min(row_height * 0.6f, 12.0f));
 
-    float new_l, new_r;
+    for (int b = 0; b < bands; ++b)
+    {
+        // lowest band at the bottom.
+        auto row = Rectangle<float>((float) bounds.getX(),
+                                    bounds.getBottom() - (b + 1) * row_height,
+                                    (float) bounds.getWidth(),
+                                    row_height).reduced(0.0f, 1.0f);
+
+        String label = (b == 0)         ? "<" + format_band_edge(BandSplitter::getCrossover(0, bands))
+                     : (b == bands - 1) ? ">" + format_band_edge(BandSplitter::getCrossover(b - 1, bands))
+                     : format_band_edge(BandSplitter::getCrossover(b - 1, bands)) + "-"
+                       + format_band_edge(BandSplitter::getCrossover(b, bands));
+
+        g.setColour(juce::Colours::darkgrey);
+        g.drawText(label, row.removeFromLeft((float) label_width), Justification::centredLeft);
 
-    if (l_vol > prev_l_vol) l_rms_vol_smoothed = l_vol;
-    else  l_rms_vol_smoothed = prev_l_vol + (l_vol - prev_l_vol) * alpha;
+        g.setColour(Colour(0xff1a1a1a));
+        g.fillRect(row);
 
-    if (r_vol > prev_r_vol) r_rms_vol_smoothed = r_vol;
-    else r_rms_vol_smoothed = prev_r_vol + (r_vol - prev_r_vol) * alpha;
+        const float centre = row.getCentreX();
+        const float half = row.getWidth() * 0.5f;
 
-    l_rms_vol.store(l_vol);
-    r_rms_vol.store(r_vol);
+        // correlation grows from the centre, out of phase goes left in red.
+        const float corr = band_correlation[b].load();
+        auto bar = row.withTrimmedBottom(row.getHeight() * 0.3f);
+        g.setColour(corr >= 0.0f ? accent_colour.brighter(0.6f) : juce::Colours::red);
+        if (corr >= 0.0f) g.fillRect(bar.withX(centre).withWidth(half * corr));
+        else              g.fillRect(bar.withX(centre + half * corr).withWidth(-half * corr));
+
+        // balance as a tick below the bar.
+        const float bal = band_balance[b].load();
+        g.setColour(juce::Colours::white);
+        g.fillRect(Rectangle<float>(centre + half * bal - 1.0f, bar.getBottom(), 2.0f, row.getBottom() - bar.getBottom()));
+
+        g.setColour(juce::Colours::darkgrey.withAlpha(0.5f));
+        g.fillRect(Rectangle<float>(centre - 0.5f, row.getY(), 1.0f, row.getHeight()));
+    }
+}
+
+void PhaseCorrelationAnalyserComponent::BandMeterComponent::resized()
+{
 }
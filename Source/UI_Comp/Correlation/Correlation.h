@@ -4,6 +4,10 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_opengl/juce_opengl.h>
 #include "../../ColourMaps.h"
+#include "CorrelationMeter.h"
+#include "../VolumeMeter/LoudnessMeter.h"
+#include "../VolumeMeter/Volume.h"
+#include "../../ds/PerfCounters.h"
 
 using namespace juce;
 
@@ -11,6 +15,15 @@ using namespace juce;
 #define RING_BUFFER_SIZE 4096
 #define RING_BUFFER_TEXEL_SIZE 2048
 #define REFRESH_RATE_HZ 60
+// blocks are processed in pieces of at most this many samples.
+#define CORRELATION_SCRATCH_SIZE 2048
+// density mode: points waiting for the renderer, the grid resolution,
+// how long a point stays visible (time constant of the fade) and the
+// lowest peak the log scale is normalised to, so silence stays dark.
+#define GONIO_FIFO_SIZE 32768
+#define GONIO_DENSITY_SIZE 256
+#define GONIO_PERSISTENCE_S 0.25
+#define GONIO_MIN_PEAK 4.0f
 
 class PhaseCorrelationAnalyserComponent 
     :   public Component,
@@ -20,7 +33,8 @@ class PhaseCorrelationAnalyserComponent
 public:
 
     PhaseCorrelationAnalyserComponent(
-        AudioProcessorValueTreeState& apvts_reference
+        AudioProcessorValueTreeState& apvts_reference,
+        PerfCounters* perf_counters = nullptr
     );
     ~PhaseCorrelationAnalyserComponent();
 
@@ -38,20 +52,38 @@ public:
     void zeroOutMeters();
 
     void processBlock(AudioBuffer<float>& buffer);
-    void recalculateSums();
+
+    // audio thread, from the processor's loudness meter, which runs whether
+    // the panel is shown or not.
+    void newLoudnessReadings(const LoudnessReadings& readings);
+    // audio thread, true once after a click on the readout.
+    bool takeLoudnessReset() { return loudness_reset.exchange(false); }
 
     const int TARGET_TRIGGER_HZ = 1200;
-    std::atomic<float> rms_time = 18; // in ms.
     std::atomic<float> sample_rate = 44100.0;
-    std::atomic<int> window_length_samples = sample_rate * rms_time;
-    std::atomic<int> update_window_samples = std::max<int>(sample_rate / (float)TARGET_TRIGGER_HZ, 2);
-    int sample_counter = 0;
 
-    // used to compute both the rms volume and the cosine similarity.
-    // a continuous sliding window is used based on the 
-    // window_length_samples and update_window_samples.
-    float sumLR = 0, sumLL = 0, sumRR = 0;
-    std::queue<float> SquareQueLR, SquareQueLL, SquareQueRR;
+    // the quality governor slows the meters down to TARGET_TRIGGER_HZ / this.
+    void setUpdateRateDivider(int divider) { update_rate_divider = jmax(1, divider); }
+    std::atomic<int> update_rate_divider = 1;
+
+    // correlation and balance over the `v_rms_time` window, the meters get
+    // a new point TARGET_TRIGGER_HZ times a second.
+    // multiband correlation is off unless `v_bands` asks for bands.
+    CorrelationMeter correlation_meter;
+
+    void newCorrelationReadings(const CorrelationReadings& readings);
+
+    // set by a click on the readout, picked up by the processor's next block.
+    std::atomic<bool> loudness_reset = false;
+
+    // the volume bars, ballistics from `v_meter`.
+    LevelMeter level_meter;
+
+    // sanitised input and the lissajous points of the present piece.
+    float scratch_l[CORRELATION_SCRATCH_SIZE] = {};
+    float scratch_r[CORRELATION_SCRATCH_SIZE] = {};
+    float scratch_x[CORRELATION_SCRATCH_SIZE] = {};
+    float scratch_y[CORRELATION_SCRATCH_SIZE] = {};
 
     class CorrelationOpenGLComponent 
         : public Component,
@@ -68,6 +100,16 @@ public:
         // called from the `PhaseCorrelationAnalyserComponent`,
         // triggers repaint for the open gl component.
         void newDataPoint(float x, float y);
+        // all the points of a block, the read index is published once.
+        void newDataBlock(const float* x, const float* y, int num);
+
+        // audio thread, the line keeps every `decimation_step`th sample
+        // and shows the newest `points` of them.
+        void setLineHistory(int decimation_step, int points);
+
+        // density mode splats every point into a fading grid instead of
+        // drawing the newest RING_BUFFER_TEXEL_SIZE points as a line.
+        void setDensityMode(bool enabled) { density_mode.store(enabled); }
 
         // ================================================
         void newOpenGLContextCreated() override;
@@ -75,13 +117,17 @@ public:
         void openGLContextClosing() override;
 
         // ================================================
-        void paint(Graphics& g) override {};
+        // only used when open gl is not available.
+        void paint(Graphics& g) override;
         void resized() override {
             if (send_triggerRepaint) opengl_context.triggerRepaint();
         };
 
         OpenGLContext opengl_context;
 
+        // render times and uploads, set once by the parent.
+        PerfCounters* perf = nullptr;
+
         float colours[6] = {
             0.0f, 0.0f, 1.0f,
             1.0f, 0.2f, 0.2f
@@ -89,11 +135,56 @@ public:
 
     private:
 
-        std::mutex ringBufferMutex;
-        GLfloat ring_buffer[RING_BUFFER_SIZE];
-        std::atomic<int> ring_buf_read_index = 0;
+        // ── line mode ────────────────────────────────────────────────────
+        // written by the audio thread once per block under a seqlock,
+        // `ring_seq` is odd while the ring is being written. Readers copy it
+        // into a snapshot and retry when the sequence moved in the meantime.
+        GLfloat ring_buffer[RING_BUFFER_SIZE] = {};
+        int ring_buf_read_index = 0;
+        int ring_visible = RING_BUFFER_TEXEL_SIZE;
+        std::atomic<uint32> ring_seq = 0;
         std::atomic<bool> dirty = false;
 
+        // audio thread only. `decimation_phase` is the number of samples
+        // to skip before the next kept one, carried over between blocks.
+        int decimation = 1;
+        int decimation_phase = 0;
+        int visible_points = RING_BUFFER_TEXEL_SIZE;
+
+        // reader side, double buffered so a failed copy never tears the one drawn.
+        GLfloat line_snapshot[2][RING_BUFFER_SIZE] = {};
+        int snapshot_current = 0;
+        int snapshot_newest = 0;
+        int snapshot_visible = RING_BUFFER_TEXEL_SIZE;
+
+        void takeLineSnapshot();
+
+        // ── density mode ─────────────────────────────────────────────────
+        // points travel from the audio thread through the fifo, whoever
+        // draws (the gl thread, or the message thread without gl) drains
+        // it into the grid under `density_lock`.
+        std::atomic<bool> density_mode = false;
+        std::atomic<int> colour_map_code = 0;
+
+        AbstractFifo xy_fifo { GONIO_FIFO_SIZE };
+        float xy_fifo_data[2][GONIO_FIFO_SIZE] = {};
+
+        SpinLock density_lock;
+        std::vector<float> density;
+        float density_peak = GONIO_MIN_PEAK;
+        double last_fade_ms = 0.0;
+
+        // fades the grid by the time since the last call and splats the new points.
+        void accumulateDensity();
+        void splatPoints(const float* x, const float* y, int num);
+
+        // set when the shaders could not be built, the component then
+        // detaches the context and paints itself.
+        std::atomic<bool> software_fallback = false;
+        Image density_image;
+
+        void paintSoftware(Graphics& g);
+
         const char* vertexShader =
         R"(
             attribute vec2 position;
@@ -113,6 +204,32 @@ public:
             gl_FragColor = vec4(vColor, 1.0);
         })";
 
+        const char* densityVertexShader =
+        R"(
+            attribute vec2 position;
+            varying vec2 uv;
+
+            void main() {
+                gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+                uv = position;
+            }
+        )";
+
+        // log compressed density through the colourmap.
+        const char* densityFragmentShader = R"(
+        varying vec2 uv;
+
+        uniform sampler2D densityData;
+        uniform sampler1D colourMapTex;
+        uniform float densityScale;
+
+        void main() {
+            float v = texture(densityData, uv).r;
+            float t = clamp(log(1.0 + v) * densityScale, 0.0, 1.0);
+            vec3 c = texture(colourMapTex, t).rgb * smoothstep(0.0, 0.05, t);
+            gl_FragColor = vec4(c, 1.0);
+        })";
+
         struct Uniforms
         {
         public:
@@ -121,6 +238,12 @@ public:
                 OpenGLContext& OpenGL_Context,
                 OpenGLShaderProgram& shader_program);
 
+            // only present in the density program.
+            std::unique_ptr<OpenGLShaderProgram::Uniform>
+                densityData,
+                colourMapTex,
+                densityScale;
+
         private:
 
             static OpenGLShaderProgram::Uniform* createUniform(
@@ -131,18 +254,31 @@ public:
 
         };
 
-        GLuint dataTexture;
-        GLuint VBO, EBO;
+        GLuint VBO = 0, EBO = 0;
+
+        // grid and density quad never change, uploaded once.
+        GLuint gridVBO = 0, quadVBO = 0;
+        GLuint densityTexture = 0, colourMapTexture = 0;
+
+        // interleaved x, y, r, g, b of the line, filled in place every frame.
+        std::vector<GLfloat> line_vertices;
 
         std::unique_ptr<OpenGLShaderProgram> shader;
         std::unique_ptr<Uniforms> shader_uniforms;
 
+        std::unique_ptr<OpenGLShaderProgram> density_shader;
+        std::unique_ptr<Uniforms> density_uniforms;
+
         // set to true in the newOpenGLContextCreated,
         // so that we do not trigger repaint before the shaders are done.
         std::atomic<bool> send_triggerRepaint = false;
 
         void createShaders();
 
+        // both return the bytes they uploaded.
+        size_t renderLines(float renderingScale);
+        size_t renderDensity();
+
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CorrelationOpenGLComponent)
     };
 
@@ -172,35 +308,61 @@ public:
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ValueMeterComponent)
     };
 
-    class VolumeMeterComponent
+    // momentary, short-term and integrated loudness, the loudness range
+    // and the held true peak. A click starts the integration over.
+    class LoudnessReadoutComponent
         : public Component
     {
     public:
-        VolumeMeterComponent();
+        LoudnessReadoutComponent();
 
         void paint(Graphics& g) override;
         void resized() override;
+        void mouseDown(const MouseEvent& event) override;
 
-        void newPoint(float l_vol, float r_vol);
+        void newReadings(const LoudnessReadings& readings);
 
-        void zeroOut();
+        std::function<void()> onReset;
+
+        juce::Colour accent_colour = juce::Colours::red;
+    private:
+
+        std::atomic<float> momentary, short_term, integrated, range, true_peak_max;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessReadoutComponent)
+    };
+
+    // correlation and balance per band, lowest band at the bottom.
+    class BandMeterComponent
+        : public Component
+    {
+    public:
+        BandMeterComponent();
+
+        void paint(Graphics& g) override;
+        void resized() override;
+
+        // correlation in [-1, 1] and balance in [-1 (L), 1 (R)] for every band.
+        void newPoints(const float* correlation, const float* balance, int bands);
+
+        int getNumBands() const { return num_bands.load(); }
 
         juce::Colour accent_colour = juce::Colours::red;
     private:
 
         // smoothing while updating values.
-        const float alpha = 0.001;
-        std::atomic<float> l_rms_vol = 0.0;
-        std::atomic<float> r_rms_vol = 0.0;
+        const float alpha = 0.1;
 
-        float l_rms_vol_smoothed = 0.0;
-        float r_rms_vol_smoothed = 0.0;
+        std::atomic<int> num_bands = 0;
+        std::atomic<float> band_correlation[BAND_MAX_BANDS];
+        std::atomic<float> band_balance[BAND_MAX_BANDS];
 
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VolumeMeterComponent)
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BandMeterComponent)
     };
 
 private:
     AudioProcessorValueTreeState& apvts_ref;
+    PerfCounters* perf;
 
     CorrelationOpenGLComponent opengl_comp;
 
@@ -209,5 +371,11 @@ private:
 
     VolumeMeterComponent volume_meter_comp;
 
+    LoudnessReadoutComponent loudness_readout_comp;
+
+    BandMeterComponent band_meter_comp;
+    // bands the layout was made for.
+    int shown_bands = 0;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PhaseCorrelationAnalyserComponent)
 };
\ No newline at end of file
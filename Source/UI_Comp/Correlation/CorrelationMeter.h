@@ -0,0 +1,294 @@
+#pragma once
+
+// Phase correlation and balance of a stereo signal over a sliding window,
+// broadband and (optionally) per band. Free of any juce dependency so it
+// runs the same in the plugin and in the offline command line tool.
+//
+// The window slides by whole chunks of samples. The sums of L*L, R*R and
+// L*R of every chunk in the window are kept in a ring, a new chunk is added
+// to the running sums and the one leaving the window subtracted, so the
+// cost per sample does not depend on the window length. The sums are kept
+// in double, the drift of adding and later subtracting the same chunk sums
+// stays far below what the meters can show, so they never need to be
+// recomputed from the window.
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "BandSplitter.h"
+
+struct CorrelationReadings
+{
+    // cosine similarity of L and R in [-1, 1].
+    float correlation = 0.0f;
+    // [-1 (all left), 1 (all right)], 0 when both are below the noise gate.
+    float balance = 0.0f;
+    float rms_left = 0.0f;
+    float rms_right = 0.0f;
+
+    int bands = 0;
+    float band_correlation[BAND_MAX_BANDS] = {};
+    float band_balance[BAND_MAX_BANDS] = {};
+};
+
+// sums of l*l, r*r and l*r in one pass, with independent lanes so it vectorizes.
+inline void accumulateProducts(const float* l, const float* r, int num,
+                               double& sum_ll, double& sum_rr, double& sum_lr)
+{
+    constexpr int LANES = 8;
+
+    float ll[LANES] = {}, rr[LANES] = {}, lr[LANES] = {};
+
+    int i = 0;
+    for (; i + LANES <= num; i += LANES)
+    {
+        for (int j = 0; j < LANES; ++j)
+        {
+            ll[j] += l[i + j] * l[i + j];
+            rr[j] += r[i + j] * r[i + j];
+            lr[j] += l[i + j] * r[i + j];
+        }
+    }
+
+    for (int j = 0; j < LANES; ++j)
+    {
+        sum_ll += ll[j];
+        sum_rr += rr[j];
+        sum_lr += lr[j];
+    }
+
+    for (; i < num; ++i)
+    {
+        sum_ll += l[i] * l[i];
+        sum_rr += r[i] * r[i];
+        sum_lr += l[i] * r[i];
+    }
+}
+
+class CorrelationMeter
+{
+public:
+
+    CorrelationMeter() { prepare(44100.0, 0.5, 1200); }
+
+    // the window slides `chunk_rate_hz` times a second and can be up to
+    // `max_window_s` long. Allocates, not for the audio thread.
+    void prepare(double sample_rate, double max_window_s, int chunk_rate_hz)
+    {
+        fs = sample_rate;
+        chunk_length = std::max((int) (sample_rate / (double) chunk_rate_hz), 1);
+        prepared_chunk_length = chunk_length;
+
+        const int max_window_length = (int) std::ceil(sample_rate * max_window_s);
+        const int capacity = max_window_length / chunk_length + 2;
+
+        chunkLL.assign(capacity, 0.0);
+        chunkRR.assign(capacity, 0.0);
+        chunkLR.assign(capacity, 0.0);
+        bandChunks.assign(capacity, BandSums());
+
+        band_splitter.prepare(sample_rate, band_splitter.getNumBands());
+
+        // recomputed by the next setWindow.
+        window_chunks = 1;
+        reset();
+    }
+
+    void reset()
+    {
+        sample_counter = 0;
+
+        chunk_write = 0;
+        chunks_filled = 0;
+
+        partialLL = partialRR = partialLR = 0.0;
+        sumLL = sumRR = sumLR = 0.0;
+
+        band_partial.clear();
+        band_sum.clear();
+        band_splitter.reset();
+    }
+
+    // rounded to whole chunks, the window starts over when it changes.
+    void setWindow(double seconds)
+    {
+        window_seconds = seconds;
+
+        const int capacity = (int) chunkLL.size();
+        const int length = (int) (fs * seconds);
+        const int chunks = std::clamp((length + chunk_length / 2) / chunk_length, 1, capacity - 1);
+
+        if (chunks != window_chunks)
+        {
+            window_chunks = chunks;
+            reset();
+        }
+    }
+
+    // slows the chunks down, never past the rate it was prepared with since
+    // the capacity only holds that many. Does not allocate.
+    void setChunkRate(int chunk_rate_hz)
+    {
+        const int length = std::max((int) (fs / (double) std::max(chunk_rate_hz, 1)), prepared_chunk_length);
+
+        if (length == chunk_length)
+            return;
+
+        chunk_length = length;
+        window_chunks = 0;
+        setWindow(window_seconds);
+    }
+
+    // 0 turns the bands off. Does not allocate.
+    void setBands(int bands)
+    {
+        if (bands == band_splitter.getNumBands())
+            return;
+
+        band_splitter.prepare(fs, bands);
+        reset();
+    }
+
+    int getBands() const { return band_splitter.getNumBands(); }
+    int getChunkLength() const { return chunk_length; }
+    int getWindowLength() const { return window_chunks * chunk_length; }
+
+    // NaN free input. `on_chunk(const CorrelationReadings&)` is called
+    // whenever a chunk completes, with the readings of the window.
+    template <typename OnChunk>
+    void process(const float* left, const float* right, int num, OnChunk&& on_chunk)
+    {
+        for (int pos = 0; pos < num; )
+        {
+            const int take = std::min(num - pos, chunk_length - sample_counter);
+
+            accumulateProducts(left + pos, right + pos, take, partialLL, partialRR, partialLR);
+            band_splitter.accumulate(left + pos, right + pos, take, band_partial);
+
+            pos += take;
+            sample_counter += take;
+
+            if (sample_counter == chunk_length)
+            {
+                sample_counter = 0;
+                pushChunk();
+                on_chunk(readings);
+            }
+        }
+    }
+
+    const CorrelationReadings& getReadings() const { return readings; }
+
+private:
+
+    void pushChunk()
+    {
+        const int capacity = (int) chunkLL.size();
+        const int bands = band_splitter.getNumBands();
+
+        // the window is full, the oldest chunk leaves it.
+        if (chunks_filled == window_chunks)
+        {
+            int oldest = chunk_write - window_chunks;
+            if (oldest < 0) oldest += capacity;
+
+            sumLL -= chunkLL[oldest];
+            sumRR -= chunkRR[oldest];
+            sumLR -= chunkLR[oldest];
+
+            for (int b = 0; b < bands; ++b)
+            {
+                band_sum.ll[b] -= bandChunks[oldest].ll[b];
+                band_sum.rr[b] -= bandChunks[oldest].rr[b];
+                band_sum.lr[b] -= bandChunks[oldest].lr[b];
+            }
+        }
+        else
+        {
+            ++chunks_filled;
+        }
+
+        chunkLL[chunk_write] = partialLL;
+        chunkRR[chunk_write] = partialRR;
+        chunkLR[chunk_write] = partialLR;
+
+        readings.bands = bands;
+
+        if (bands > 0)
+        {
+            bandChunks[chunk_write] = band_partial;
+
+            for (int b = 0; b < bands; ++b)
+            {
+                band_sum.ll[b] += band_partial.ll[b];
+                band_sum.rr[b] += band_partial.rr[b];
+                band_sum.lr[b] += band_partial.lr[b];
+
+                double ll = std::max(band_sum.ll[b], 0.0);
+                double rr = std::max(band_sum.rr[b], 0.0);
+
+                double denom = std::max(std::sqrt(ll * rr), 1e-9);
+                readings.band_correlation[b] = (float) std::clamp(band_sum.lr[b] / denom, -1.0, 1.0);
+
+                double rmsL = std::sqrt(ll), rmsR = std::sqrt(rr);
+                readings.band_balance[b] = (rmsL + rmsR > 1e-9) ? (float) ((rmsR - rmsL) / (rmsL + rmsR)) : 0.0f;
+            }
+
+            band_partial.clear();
+        }
+
+        if (++chunk_write == capacity) chunk_write = 0;
+
+        sumLL += partialLL;  sumRR += partialRR;  sumLR += partialLR;
+        partialLL = partialRR = partialLR = 0.0;
+
+        // rounding can leave a tiny negative sum after silence.
+        double windowLL = std::max(sumLL, 0.0);
+        double windowRR = std::max(sumRR, 0.0);
+
+        float denom = (float) std::sqrt(windowLL * windowRR);
+        if (denom < 1e-6f) denom = 1e-6f;
+
+        readings.correlation = std::clamp((float) sumLR / denom, -1.0f, 1.0f);
+
+        const double window_length = (double) getWindowLength();
+        float rmsL = (float) std::sqrt(windowLL / window_length);
+        float rmsR = (float) std::sqrt(windowRR / window_length);
+
+        const float noiseGate = 5e-4f;
+        if (rmsL < noiseGate) rmsL = 0.0f;
+        if (rmsR < noiseGate) rmsR = 0.0f;
+
+        readings.rms_left = rmsL;
+        readings.rms_right = rmsR;
+
+        readings.balance = 0.0f;
+        if (rmsL + rmsR > 1e-8f)
+            readings.balance = (rmsR - rmsL) / (rmsL + rmsR);
+    }
+
+    double fs = 44100.0;
+    int chunk_length = 1;
+    int prepared_chunk_length = 1;
+    int sample_counter = 0;
+    double window_seconds = 0.0;
+
+    double sumLR = 0, sumLL = 0, sumRR = 0;
+
+    // sums of the chunks in the window.
+    std::vector<double> chunkLL, chunkRR, chunkLR;
+    int chunk_write = 0;
+    int chunks_filled = 0;
+    int window_chunks = 1;
+
+    // sums of the chunk being filled.
+    double partialLL = 0, partialRR = 0, partialLR = 0;
+
+    // the per band sums slide along with the broadband ones.
+    BandSplitter band_splitter;
+    std::vector<BandSums> bandChunks;
+    BandSums band_partial, band_sum;
+
+    CorrelationReadings readings;
+};
@@ -0,0 +1,266 @@
+#include "AnalysisRecorder.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+bool AnalysisRecorder::open(const std::string& path, double sample_rate, int fft_size, int hop_size,
+                            bool half_precision, int meters)
+{
+    close();
+
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    int fft_order = 0;
+    while ((1 << fft_order) < fft_size) ++fft_order;
+
+    header = {};
+    std::memcpy(header.magic, "ANLTKS\0\0", 8);
+    header.version       = ANALYSIS_FILE_VERSION;
+    header.header_size   = sizeof(AnalysisFileHeader);
+    header.sample_rate   = sample_rate;
+    header.fft_order     = (uint32_t) fft_order;
+    header.hop_size      = (uint32_t) hop_size;
+    header.num_bins      = (uint32_t) (fft_size / 2 + 1);
+    header.sample_format = half_precision ? AnalysisFloat16 : AnalysisFloat32;
+    header.chunk_columns = ANALYSIS_CHUNK_COLUMNS;
+
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fflush(file);
+
+    sequence_started = false;
+    next_sequence = 0;
+    pending.clear();
+
+    spectrogram_chunk.assign((size_t) ANALYSIS_CHUNK_COLUMNS * header.num_bins, 0.0f);
+    spectrogram_filled = 0;
+    spectrogram_columns = 0;
+
+    ltas_power.assign(header.num_bins, 0.0);
+    ltas_count = 0;
+
+    meter_size = std::max(meters, 0);
+    meter_chunk.assign((size_t) ANALYSIS_CHUNK_COLUMNS * (meter_size + 1), 0.0f);
+    meter_filled = 0;
+    meter_columns = 0;
+
+    return true;
+}
+
+void AnalysisRecorder::close()
+{
+    if (file == nullptr)
+        return;
+
+    // whatever is still waiting for a batch that never came.
+    for (auto& batch : pending)
+        appendSpectrogramColumns(batch.second.data(), (int) batch.second.size());
+    pending.clear();
+
+    flushSpectrogram();
+    flushMeters();
+
+    if (ltas_count > 0)
+    {
+        std::vector<float> ltas(header.num_bins);
+
+        for (size_t bin = 0; bin < ltas.size(); ++bin)
+        {
+            double db = 10.0 * std::log10(ltas_power[bin] / (double) ltas_count + 1e-30);
+            ltas[bin] = (float) std::clamp((db + 80.0) / 80.0, 0.0, 1.0);
+        }
+
+        writeChunk(AnalysisLTAS, ltas.data(), 1, (int) header.num_bins, 0);
+    }
+
+    std::fclose(file);
+    file = nullptr;
+}
+
+void AnalysisRecorder::appendSpectrogram(uint64_t sequence, const std::vector<float>* columns, int num_columns)
+{
+    if (file == nullptr)
+        return;
+
+    if (!sequence_started)
+    {
+        sequence_started = true;
+        next_sequence = sequence;
+    }
+
+    // older than what was written already, it lost the race for good.
+    if (sequence < next_sequence)
+        return;
+
+    if (sequence > next_sequence)
+    {
+        pending[sequence].assign(columns, columns + num_columns);
+
+        // the batch that is due went missing, skip ahead.
+        if ((int) pending.size() <= ANALYSIS_MAX_PENDING)
+            return;
+
+        next_sequence = pending.begin()->first;
+    }
+    else
+    {
+        appendSpectrogramColumns(columns, num_columns);
+        ++next_sequence;
+    }
+
+    // everything that was only waiting for this one.
+    for (auto it = pending.begin(); it != pending.end() && it->first == next_sequence; it = pending.erase(it))
+    {
+        appendSpectrogramColumns(it->second.data(), (int) it->second.size());
+        ++next_sequence;
+    }
+}
+
+void AnalysisRecorder::appendSpectrogramColumns(const std::vector<float>* columns, int num_columns)
+{
+    const int num_bins = (int) header.num_bins;
+
+    for (int c = 0; c < num_columns; ++c)
+    {
+        // a column of another FFT size does not belong in this file.
+        if ((int) columns[c].size() < num_bins)
+            continue;
+
+        const float* column = columns[c].data();
+
+        std::copy(column, column + num_bins, spectrogram_chunk.begin() + (size_t) spectrogram_filled * num_bins);
+
+        for (int bin = 0; bin < num_bins; ++bin)
+            ltas_power[bin] += std::pow(10.0, (column[bin] * 80.0 - 80.0) / 10.0);
+        ++ltas_count;
+
+        if (++spectrogram_filled == ANALYSIS_CHUNK_COLUMNS)
+            flushSpectrogram();
+    }
+}
+
+void AnalysisRecorder::appendMeters(double time, const float* values)
+{
+    if (file == nullptr || meter_size == 0)
+        return;
+
+    float* column = meter_chunk.data() + (size_t) meter_filled * (meter_size + 1);
+    column[0] = (float) time;
+    std::copy(values, values + meter_size, column + 1);
+
+    if (++meter_filled == ANALYSIS_CHUNK_COLUMNS)
+        flushMeters();
+}
+
+void AnalysisRecorder::flushSpectrogram()
+{
+    if (spectrogram_filled == 0)
+        return;
+
+    writeChunk(AnalysisSpectrogram, spectrogram_chunk.data(), spectrogram_filled,
+               (int) header.num_bins, spectrogram_columns);
+
+    spectrogram_columns += (uint64_t) spectrogram_filled;
+    spectrogram_filled = 0;
+}
+
+void AnalysisRecorder::flushMeters()
+{
+    if (meter_filled == 0)
+        return;
+
+    writeChunk(AnalysisMeters, meter_chunk.data(), meter_filled, meter_size + 1, meter_columns);
+
+    meter_columns += (uint64_t) meter_filled;
+    meter_filled = 0;
+}
+
+void AnalysisRecorder::writeChunk(AnalysisChunkKind kind, const float* data, int num_columns,
+                                  int column_size, uint64_t first_column)
+{
+    const size_t num_values = (size_t) num_columns * (size_t) column_size;
+    const bool half = header.sample_format == AnalysisFloat16;
+    const size_t data_bytes = num_values * (half ? sizeof(uint16_t) : sizeof(float));
+    const size_t padded = (data_bytes + 15) & ~(size_t) 15;
+
+    AnalysisChunkHeader chunk = {};
+    std::memcpy(&chunk.magic, "CHNK", 4);
+    chunk.kind         = kind;
+    chunk.num_columns  = (uint32_t) num_columns;
+    chunk.column_size  = (uint32_t) column_size;
+    chunk.first_column = first_column;
+    chunk.data_bytes   = (uint32_t) data_bytes;
+
+    // the header and the data go out in one write, so a chunk is never half there
+    // for longer than the write itself takes.
+    write_buffer.assign(sizeof(chunk) + padded, 0);
+    std::memcpy(write_buffer.data(), &chunk, sizeof(chunk));
+
+    unsigned char* out = write_buffer.data() + sizeof(chunk);
+
+    if (half)
+    {
+        for (size_t i = 0; i < num_values; ++i)
+        {
+            const uint16_t h = floatToHalf(data[i]);
+            std::memcpy(out + 2 * i, &h, sizeof(h));
+        }
+    }
+    else
+    {
+        std::memcpy(out, data, data_bytes);
+    }
+
+    std::fwrite(write_buffer.data(), 1, write_buffer.size(), file);
+    std::fflush(file);
+}
+
+uint16_t AnalysisRecorder::floatToHalf(float value)
+{
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+
+    const uint32_t sign = (x >> 16) & 0x8000u;
+    const uint32_t exponent = (x >> 23) & 0xffu;
+    uint32_t mantissa = x & 0x7fffffu;
+
+    // NaN and inf.
+    if (exponent == 0xffu)
+        return (uint16_t) (sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+
+    const int e = (int) exponent - 127 + 15;
+
+    // too large, inf.
+    if (e >= 31)
+        return (uint16_t) (sign | 0x7c00u);
+
+    // subnormal or zero.
+    if (e <= 0)
+    {
+        if (e < -10)
+            return (uint16_t) sign;
+
+        mantissa |= 0x800000u;
+        const int shift = 14 - e;
+        uint32_t half_mantissa = mantissa >> shift;
+
+        // round to nearest even.
+        const uint32_t rest = mantissa & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half_mantissa & 1u)))
+            ++half_mantissa;
+
+        return (uint16_t) (sign | half_mantissa);
+    }
+
+    uint32_t half = sign | ((uint32_t) e << 10) | (mantissa >> 13);
+
+    // round to nearest even, a carry into the exponent is still right.
+    const uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+        ++half;
+
+    return (uint16_t) half;
+}
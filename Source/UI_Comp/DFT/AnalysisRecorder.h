@@ -0,0 +1,142 @@
+#pragma once
+
+// Writes spectrogram columns, the long term average spectrum (LTAS) and
+// meter timelines to a compact binary file other tools can mmap.
+// Free of any juce dependency, the offline command line tool uses it too.
+//
+// File layout (.anlt), little endian, every offset a multiple of 16 so a
+// reader can point straight into a mapping of the file:
+//
+//   AnalysisFileHeader   64 bytes
+//   chunk                AnalysisChunkHeader (32 bytes), then
+//                        num_columns * column_size values (float16 or float32,
+//                        column after column), zero padded to 16 bytes.
+//   chunk ...
+//
+// Spectrogram and LTAS values are the plugin's amplitude map, [0, 1] over
+// [-80, 0] dB, on linear bins (bin k is at k * sample_rate / 2^fft_order Hz).
+// A meter column is its time in seconds followed by the meter values.
+// Chunks are only ever appended whole, a reader of a file that is still
+// being written ignores a last chunk that runs past the end of the file.
+//
+// Not thread safe, the owner serialises the calls. Spectrogram batches may
+// arrive out of order though (several FFT workers), their sequence numbers
+// put them back in order.
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+#define ANALYSIS_FILE_VERSION 1
+#define ANALYSIS_CHUNK_COLUMNS 64
+// batches waiting for an earlier one before they are given up on.
+#define ANALYSIS_MAX_PENDING 16
+
+enum AnalysisChunkKind : uint32_t
+{
+    AnalysisSpectrogram = 1,
+    AnalysisLTAS        = 2,
+    AnalysisMeters      = 3
+};
+
+enum AnalysisSampleFormat : uint32_t
+{
+    AnalysisFloat16 = 1,
+    AnalysisFloat32 = 2
+};
+
+struct AnalysisFileHeader
+{
+    char     magic[8];          // "ANLTKS\0\0"
+    uint32_t version;
+    uint32_t header_size;       // sizeof(AnalysisFileHeader)
+    double   sample_rate;
+    uint32_t fft_order;
+    uint32_t hop_size;
+    uint32_t num_bins;
+    uint32_t bin_scale;         // 0, linear bins.
+    uint32_t value_scale;       // 0, [0, 1] over [-80, 0] dB.
+    uint32_t sample_format;     // AnalysisSampleFormat
+    uint32_t chunk_columns;     // spectrogram columns per full chunk.
+    uint32_t reserved[3];
+};
+
+struct AnalysisChunkHeader
+{
+    uint32_t magic;             // "CHNK"
+    uint32_t kind;              // AnalysisChunkKind
+    uint32_t num_columns;
+    uint32_t column_size;       // values per column.
+    uint64_t first_column;      // index among the columns of this kind.
+    uint32_t data_bytes;        // without the padding.
+    uint32_t reserved;
+};
+
+static_assert(sizeof(AnalysisFileHeader) == 64, "the header is part of the file format");
+static_assert(sizeof(AnalysisChunkHeader) == 32, "the chunk header is part of the file format");
+
+class AnalysisRecorder
+{
+public:
+
+    AnalysisRecorder() = default;
+    ~AnalysisRecorder() { close(); }
+
+    AnalysisRecorder(const AnalysisRecorder&)            = delete;
+    AnalysisRecorder& operator=(const AnalysisRecorder&) = delete;
+
+    // creates (or truncates) `path` and writes the header. `meter_size` values
+    // per meter column, 0 when there are none. False if the file cannot be written.
+    bool open(const std::string& path, double sample_rate, int fft_size, int hop_size,
+              bool half_precision, int meter_size = 0);
+
+    // writes what is still buffered and the LTAS.
+    void close();
+
+    bool isOpen() const { return file != nullptr; }
+    int getNumBins() const { return (int) header.num_bins; }
+    int getHopSize() const { return (int) header.hop_size; }
+    double getSampleRate() const { return header.sample_rate; }
+
+    // `num_columns` spectrogram columns of `getNumBins()` values,
+    // `sequence` counts the batches up from wherever the caller started.
+    void appendSpectrogram(uint64_t sequence, const std::vector<float>* columns, int num_columns);
+
+    // a meter column, its time in seconds and `meter_size` values.
+    void appendMeters(double time, const float* values);
+
+    static uint16_t floatToHalf(float value);
+
+private:
+
+    void appendSpectrogramColumns(const std::vector<float>* columns, int num_columns);
+    void writeChunk(AnalysisChunkKind kind, const float* data, int num_columns, int column_size, uint64_t first_column);
+    void flushSpectrogram();
+    void flushMeters();
+
+    std::FILE* file = nullptr;
+    AnalysisFileHeader header = {};
+
+    // batches that came before the one that is due.
+    bool sequence_started = false;
+    uint64_t next_sequence = 0;
+    std::map<uint64_t, std::vector<std::vector<float>>> pending;
+
+    std::vector<float> spectrogram_chunk;
+    int spectrogram_filled = 0;
+    uint64_t spectrogram_columns = 0;
+
+    // sums of the power of every bin.
+    std::vector<double> ltas_power;
+    uint64_t ltas_count = 0;
+
+    int meter_size = 0;
+    std::vector<float> meter_chunk;
+    int meter_filled = 0;
+    uint64_t meter_columns = 0;
+
+    // staging for the conversion and the padding of a chunk.
+    std::vector<unsigned char> write_buffer;
+};
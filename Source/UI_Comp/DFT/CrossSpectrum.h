@@ -0,0 +1,121 @@
+#pragma once
+
+// What the left and right channel have in common, bin by bin: the auto
+// spectra |L|^2 and |R|^2 and the cross spectrum L R*, summed over frames.
+// Coherence, phase difference and panning of any band follow from those
+// sums, so they come out of the spectra the analysis computes anyway.
+// With a system's output as the left and its input as the right spectrum
+// the same sums give the H1 estimate of its transfer function, L R* / |R|^2,
+// the coherence telling how much of the output it explains.
+// Free of any juce dependency.
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+// the time the averages forget over, each frame alone would be
+// fully coherent.
+#define CROSS_SPECTRUM_SECONDS 0.3
+
+struct CrossBand
+{
+    // 0..1, how much of R follows from L by a fixed gain and delay.
+    float coherence = 0.0f;
+    // of L against R in radians, positive when L leads.
+    float phase = 0.0f;
+    // -1 hard left, 0 centre, 1 hard right, from the energies.
+    float pan = 0.0f;
+    // |L R*| / |R|^2, the magnitude of H1 with R the reference.
+    float gain = 0.0f;
+};
+
+struct CrossSpectrum
+{
+    std::vector<float> ll, rr, lr_re, lr_im;
+
+    int getNumBins() const { return (int) ll.size(); }
+
+    void resize(int num_bins)
+    {
+        ll.assign(num_bins, 0.0f);
+        rr.assign(num_bins, 0.0f);
+        lr_re.assign(num_bins, 0.0f);
+        lr_im.assign(num_bins, 0.0f);
+    }
+
+    // one frame, ordered pffft output of both channels of `fft_size` points.
+    void accumulate(const float* left, const float* right, int fft_size)
+    {
+        const int num_bins = fft_size / 2 + 1;
+        if (getNumBins() != num_bins)
+            resize(num_bins);
+
+        // DC and nyquist are real, packed into the first two values.
+        add(0, left[0], 0.0f, right[0], 0.0f);
+        add(num_bins - 1, left[1], 0.0f, right[1], 0.0f);
+
+        for (int bin = 1; bin < num_bins - 1; ++bin)
+            add(bin, left[2 * bin], left[2 * bin + 1], right[2 * bin], right[2 * bin + 1]);
+    }
+
+    // this * keep + `other`, starting over from `other` when the bins changed.
+    void blend(const CrossSpectrum& other, float keep)
+    {
+        if (getNumBins() != other.getNumBins())
+        {
+            *this = other;
+            return;
+        }
+
+        for (int bin = 0; bin < getNumBins(); ++bin)
+        {
+            ll[bin]    = ll[bin]    * keep + other.ll[bin];
+            rr[bin]    = rr[bin]    * keep + other.rr[bin];
+            lr_re[bin] = lr_re[bin] * keep + other.lr_re[bin];
+            lr_im[bin] = lr_im[bin] * keep + other.lr_im[bin];
+        }
+    }
+
+    // bins `first` to `last`, both included.
+    CrossBand getBand(int first, int last) const
+    {
+        CrossBand band;
+
+        first = std::max(first, 0);
+        last = std::min(last, getNumBins() - 1);
+
+        double sum_ll = 0.0, sum_rr = 0.0, sum_re = 0.0, sum_im = 0.0;
+        for (int bin = first; bin <= last; ++bin)
+        {
+            sum_ll += ll[bin];
+            sum_rr += rr[bin];
+            sum_re += lr_re[bin];
+            sum_im += lr_im[bin];
+        }
+
+        const double energy = sum_ll + sum_rr;
+        if (energy <= 1e-20)
+            return band;
+
+        band.pan = (float) ((sum_rr - sum_ll) / energy);
+        band.phase = (float) std::atan2(sum_im, sum_re);
+
+        if (sum_rr > 1e-20)
+            band.gain = (float) (std::sqrt(sum_re * sum_re + sum_im * sum_im) / sum_rr);
+
+        if (sum_ll > 1e-20 && sum_rr > 1e-20)
+            band.coherence = (float) std::min(1.0, (sum_re * sum_re + sum_im * sum_im) / (sum_ll * sum_rr));
+
+        return band;
+    }
+
+private:
+
+    void add(int bin, float l_re, float l_im, float r_re, float r_im)
+    {
+        ll[bin]    += l_re * l_re + l_im * l_im;
+        rr[bin]    += r_re * r_re + r_im * r_im;
+        lr_re[bin] += l_re * r_re + l_im * r_im;
+        lr_im[bin] += l_im * r_re - l_re * r_im;
+    }
+};
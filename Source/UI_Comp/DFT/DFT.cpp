@@ -7,56 +7,101 @@ std::function<void(string)> callback =
     [](string msg) -> void { DBG(msg); };
 
 PFFFT::PFFFT(
-    AudioProcessorValueTreeState& apvts_reference)
-    :   spectral_analyser_component(std::make_unique<SpectrumAnalyserComponent>(apvts_reference, callback)),
-        spectrogram_component(std::make_unique<SpectrogramComponent>(apvts_reference)),
-        apvts_ref(apvts_reference)
+    AudioProcessorValueTreeState& apvts_reference, PerfCounters* perf_counters)
+    :   spectral_analyser_component(std::make_unique<SpectrumAnalyserComponent>(apvts_reference, callback, perf_counters)),
+        spectrogram_component(std::make_unique<SpectrogramComponent>(apvts_reference, perf_counters)),
+        apvts_ref(apvts_reference),
+        perf(perf_counters)
 {
 
     cout << "FFT Engine SIMD size : " + String(pffft_simd_size()) << "\n";
 
-    amplitude_buffer.resize(SUPER_SET_SIZE);
     ring_buffer.resize(INPUT_RING_BUFFER_SIZE);
+    ring_buffer_right.resize(INPUT_RING_BUFFER_SIZE);
+    ring_buffer_reference.resize(INPUT_RING_BUFFER_SIZE);
 
-    for (int i = 0; i < MAX_ACCUMULATED; ++i) {
-        processed_amplitude_data[i].resize(MAX_BUFFER_SIZE);
-    }
+    // only the order in use, the others when they are first picked.
+    updateTables();
+
+    startTimerHz(FPS);
+}
+
+PFFFT::~PFFFT()
+{
+    // fft_client goes first (declared last), it waits for this instance's
+    // running batches and drops the queued ones. The shared tables are freed
+    // with the last instance holding them.
+}
+
+int PFFFT::getActiveFFTIndex() const
+{
+    int FFT_order = apvts_ref.getRawParameterValue("gb_fft_ord")->load();
+    FFT_order = jmax(0, FFT_order - quality_order_drop.load());
+
+    auto it = SUPPPORTED_N_INDEX.find(FFT_order + 9);
+    return it != SUPPPORTED_N_INDEX.end() ? it->second : -1;
+}
+
+void PFFFT::updateTables()
+{
+    int fft_index = getActiveFFTIndex();
+    if (fft_index < 0)
+        return;
+
+    int   order  = SUPPORTED_N_VALUES[fft_index];
+    auto  window = (AnalysisWindowType) jlimit(0, NumWindowTypes - 1,
+                                               (int) apvts_ref.getRawParameterValue("gb_window")->load());
+    float beta   = window == WindowKaiser ? apvts_ref.getRawParameterValue("gb_kaiser_beta")->load() : 0.0f;
+    int   pad    = jlimit(0, FFT_MAX_ZERO_PAD_BITS, (int) apvts_ref.getRawParameterValue("gb_zero_pad")->load());
+    int   padded = powToTwo(jmin(order + pad, FFT_MAX_PADDED_ORDER));
 
-    // pre-size each result slot in the worker_buffers — nothing else needed,
-    // WorkerFFTBuffers allocates its own aligned memory on construction.
-    for (int n = 0; n < NUM_SUPPORTED_N; ++n)
+    auto matches = [&](const FFTTables* tables)
     {
-        if (!pffft_setups[n]) {
-            std::cerr << "FFT setup creation failed at index " << n << "\n";
-            std::exit(EXIT_FAILURE);
-        }
- 
-        windows.push_back(std::vector<float>());
-        windows[n].resize(SUPPORTED_FFT_SIZES[n]);
-
-        dsp::WindowingFunction<float>::fillWindowingTables(
-            windows[n].data(),
-            SUPPORTED_FFT_SIZES[n],
-            dsp::WindowingFunction<float>::hann,
-            true
-        );
+        return tables != nullptr
+            && tables->getFrameSize() == SUPPORTED_FFT_SIZES[fft_index]
+            && tables->getFFTSize() == padded
+            && tables->window->type == window
+            && (window != WindowKaiser || tables->window->kaiser_beta == beta);
+    };
+
+    if (matches(active_tables.load()))
+        return;
+
+    auto it = std::find_if(held_tables.begin(), held_tables.end(),
+                           [&](const auto& tables) { return matches(tables.get()); });
+
+    if (it == held_tables.end())
+    {
+        // built by the first instance, the others only take a reference.
+        auto tables = fft_client->getTables(order, window, beta, pad);
+
+        // a host must not go down with the analyser: the previous tables
+        // stay active, or processBlock keeps skipping frames without any.
+        if (!tables->plan->setup)
+            return;
+
+        held_tables.push_back(std::move(tables));
+        it = held_tables.end() - 1;
     }
 
-    startTimerHz(FPS);
+    active_tables.store(it->get());
 }
 
-PFFFT::~PFFFT()
+void PFFFT::releaseRetiredTables()
 {
-    // fft_worker_pool destructor joins all workers before we free anything below.
-    // Declaration order in the header guarantees fft_worker_pool is destroyed
-    // before pffft_setups, so no worker can be mid-transform when we free setups.
-
-    for (PFFFT_Setup* setup : pffft_setups)
-        pffft_destroy_setup(setup);
-    
-    pffft_aligned_free(pffft_input);
-    pffft_aligned_free(pffft_work);
-    pffft_aligned_free(pffft_output);
+    if (held_tables.size() < 2)
+        return;
+
+    // seq_cst against processBlock's: once it is seen not framing, it either
+    // submitted its batch (counted as pending) or reads the active tables.
+    // Retried on the next tick otherwise.
+    if (framing.load() || fft_client->getPending() > 0)
+        return;
+
+    const auto* active = active_tables.load();
+    held_tables.erase(std::remove_if(held_tables.begin(), held_tables.end(),
+                                     [&](const auto& tables) { return tables.get() != active; }),
+                      held_tables.end());
 }
 
 void PFFFT::play()
@@ -66,6 +111,13 @@ void PFFFT::play()
 
 void PFFFT::timerCallback()
 {
+    PerfScope timer_scope(perf, PerfTimerCallback);
+
+    // a new order (from the parameter or the quality governor) or window
+    // gets its tables here, the audio thread never allocates them.
+    updateTables();
+    releaseRetiredTables();
+
     // Drain the result queue on the UI/timer thread.
     // Workers push FFTResult objects here; we consume them all each tick.
     // The mutex is held only briefly per result — this never blocks the audio thread
@@ -80,23 +132,122 @@ void PFFFT::timerCallback()
             result_queue.pop_front();
         }
 
-        // These calls are safe here — we're on the UI thread i.e. message thread.
-        spectrogram_component->newDataBatch(
-            result.amplitude_data,
-            result.valid_frames,
-            result.num_bins,
-            result.bpm,
-            result.sample_rate,
-            result.N,
-            result.D
-        );
-
-        for (int i = 0; i < result.valid_frames; ++i)
-            spectral_analyser_component->newData(result.amplitude_data[i].data(), result.num_bins);
+        // two batches of this instance may run at once and finish the other
+        // way round, the later one waits for its predecessor.
+        if (result.sequence < next_result)
+            continue;
+
+        if (result.sequence > next_result)
+        {
+            held_results[result.sequence] = std::move(result);
+
+            // the batch that is due went missing, skip ahead.
+            if ((int) held_results.size() <= ANALYSIS_MAX_PENDING)
+                continue;
+
+            next_result = held_results.begin()->first;
+        }
+        else
+        {
+            showResult(result);
+            ++next_result;
+        }
+
+        // everything that was only waiting for this one.
+        for (auto it = held_results.begin(); it != held_results.end() && it->first == next_result;
+             it = held_results.erase(it))
+        {
+            showResult(it->second);
+            ++next_result;
+        }
     }
 
     spectral_analyser_component->timerCallback();
     spectrogram_component->timerCallback();
+
+    stopRecordingIfDisabled();
+}
+
+void PFFFT::showResult(const FFTResult& result)
+{
+    // These calls are safe here — we're on the UI thread i.e. message thread.
+    spectrogram_component->newDataBatch(
+        result.amplitude_data,
+        result.phase_data,
+        result.phase_view,
+        result.valid_frames,
+        result.num_bins,
+        result.bpm,
+        result.sample_rate,
+        result.N,
+        result.D,
+        result.hop_size
+    );
+
+    for (int i = 0; i < result.valid_frames; ++i)
+    {
+        const float* views[NumAnalysisViews];
+        for (int view = 0; view < NumAnalysisViews; ++view)
+            views[view] = result.amplitude_data[view][i].data();
+
+        spectral_analyser_component->newData(views, result.num_bins, result.sample_rate, result.window);
+    }
+
+    if (result.valid_frames > 0)
+        spectral_analyser_component->newCrossSpectrum(result.cross, result.valid_frames * result.hop_size,
+                                                      result.sample_rate);
+
+    if (result.valid_frames > 0 && result.transfer.getNumBins() > 0)
+        spectral_analyser_component->newTransfer(result.transfer, result.valid_frames * result.hop_size,
+                                                 result.sample_rate);
+}
+
+void PFFFT::recordResult(const FFTResult& result)
+{
+    if (apvts_ref.getRawParameterValue("gb_record")->load() < 0.5f)
+        return;
+
+    std::lock_guard<std::mutex> lock(recorder_mutex);
+
+    const int view = jlimit(0, NumAnalysisViews - 1, (int) apvts_ref.getRawParameterValue("gb_chnl")->load());
+
+    // the header describes one FFT size, hop and rate, a file holds one view.
+    if (recorder.isOpen() && (recorder.getNumBins() != result.num_bins
+                              || recorder.getHopSize() != result.hop_size
+                              || recorder.getSampleRate() != result.sample_rate
+                              || recorded_view != view))
+        recorder.close();
+
+    if (!recorder.isOpen())
+    {
+        static const char* view_names[NumAnalysisViews] = { "mid", "left", "right", "side" };
+
+        File folder = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("Analytiks");
+        folder.createDirectory();
+
+        File file = folder.getNonexistentChildFile(
+            "analysis-" + Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + "-" + view_names[view],
+            ".anlt", false);
+
+        if (!recorder.open(file.getFullPathName().toStdString(), result.sample_rate,
+                           (result.num_bins - 1) * 2, result.hop_size, true))
+            return;
+
+        recorded_view = view;
+    }
+
+    recorder.appendSpectrogram(result.sequence, result.amplitude_data[view].data(), result.valid_frames);
+}
+
+void PFFFT::stopRecordingIfDisabled()
+{
+    if (apvts_ref.getRawParameterValue("gb_record")->load() >= 0.5f)
+        return;
+
+    std::lock_guard<std::mutex> lock(recorder_mutex);
+
+    if (recorder.isOpen())
+        recorder.close();
 }
 
 std::array<Component*, 2> PFFFT::getSpectrogramAndAnalyser()
@@ -108,6 +259,17 @@ std::array<Component*, 2> PFFFT::getSpectrogramAndAnalyser()
     return arr;
 }
 
+void PFFFT::setQuality(int hop_multiplier, int order_drop)
+{
+    quality_hop_multiplier = jmax(1, hop_multiplier);
+
+    // the spectrogram's columns do not mix FFT sizes.
+    if (quality_order_drop.exchange(jmax(0, order_drop)) != order_drop)
+        spectrogram_component->parameterChanged("", 0.0f);
+
+    updateTables();
+}
+
 void PFFFT::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
     spectral_analyser_component->prepareToPlay(sampleRate, samplesPerBlock);
@@ -115,41 +277,109 @@ void PFFFT::prepareToPlay(double sampleRate, int samplesPerBlock)
 
 void PFFFT::cleanAllContainers()
 {
-    for (auto& value : ring_buffer)   value = 0.0;
-    for (auto& value : amplitude_buffer) value = 0.0;
+    for (auto& value : ring_buffer)         value = 0.0;
+    for (auto& value : ring_buffer_right)   value = 0.0;
+    for (auto& value : ring_buffer_reference)   value = 0.0;
 }
 
-void PFFFT::processBlock(const float* input, int numSamples, float bpm, float SR, int N, int D)
+void PFFFT::processBlock(const float* left, const float* right, int numSamples, float bpm, float SR, int N, int D,
+                         const float* reference_left, const float* reference_right)
 {
-    int FFT_order = apvts_ref.getRawParameterValue("gb_fft_ord")->load();
-
-    auto it = SUPPPORTED_N_INDEX.find(FFT_order + 9);
-    if (it == SUPPPORTED_N_INDEX.end()) {
-        std::cout << "Unsupported FFT order requested : " << FFT_order << "\n";
+    int fft_index = getActiveFFTIndex();
+    // an unsupported order, nothing to frame.
+    if (fft_index < 0)
         return;
-    }
 
-    int          fft_index       = it->second;
     int          fft_size        = SUPPORTED_FFT_SIZES[fft_index];
-    PFFFT_Setup* setup           = pffft_setups[fft_index];
-    auto&        windowing_array = windows[fft_index];
-    int          hop_size        = overlap_samples;
-    int          num_bins        = (fft_size / 2) + 1;
+    int          hop_size        = (int)overlap_samples * quality_hop_multiplier.load();
+
+    // the lowest rate that still holds the widest range, the same for any zoom.
+    int factor = 1;
+    if (apvts_ref.getRawParameterValue("gb_decimate")->load() >= 0.5f)
+        factor = Decimator::chooseFactor(SR);
+
+    if (factor != decimator.getFactor())
+    {
+        decimator.setFactor(factor);
+        decimator_right.setFactor(factor);
+        decimator_reference.setFactor(factor);
+        // what is unread is at the old rate, the next frame starts afresh.
+        ReadIndex = WriteIndex;
+    }
+
+    // unread frames have no reference, or a stale one.
+    const bool transfer = reference_left != nullptr && reference_right != nullptr;
+    if (transfer != transfer_active)
+    {
+        transfer_active = transfer;
+        // all in the same phase, a sample of skew would show as delay.
+        decimator.reset();
+        decimator_right.reset();
+        decimator_reference.reset();
+        ReadIndex = WriteIndex;
+    }
+
+    float analysis_rate = SR / (float)factor;
 
-    // Write new samples into the ring buffer — audio thread only, no lock needed.
-    for (int i = 0; i < numSamples; ++i)
+    // frames the writer is about to overwrite before they were read.
+    if (perf)
     {
-        ring_buffer[WriteIndex] = input[i];
-        WriteIndex = (WriteIndex + 1) % ring_buffer.size();
+        int unread = (WriteIndex - ReadIndex + (int)ring_buffer.size()) % (int)ring_buffer.size();
+        int overrun = unread + numSamples / factor - ((int)ring_buffer.size() - 1);
+        if (overrun > 0)
+            perf->add(PerfFramesDropped, (overrun + hop_size - 1) / hop_size);
     }
 
+    // Write new samples into the ring buffers — audio thread only, no lock needed.
+    for (int start = 0; start < numSamples; start += DECIMATION_CHUNK)
+    {
+        int num = jmin(DECIMATION_CHUNK, numSamples - start);
+        const float* samples_left  = left + start;
+        const float* samples_right = right + start;
+
+        // the reference's mid, measured against the main input's.
+        if (transfer)
+        {
+            for (int i = 0; i < num; ++i)
+                reference_mix[i] = (reference_left[start + i] + reference_right[start + i]) * 0.5f;
+
+            decimator_reference.process(reference_mix.data(), reference_mix.data(), num);
+        }
+
+        if (decimator.getFactor() > 1)
+        {
+            decimator_right.process(samples_right, decimated_right.data(), num);
+            num = decimator.process(samples_left, decimated.data(), num);
+            samples_left  = decimated.data();
+            samples_right = decimated_right.data();
+        }
+
+        for (int i = 0; i < num; ++i)
+        {
+            ring_buffer[WriteIndex]           = samples_left[i];
+            ring_buffer_right[WriteIndex]     = samples_right[i];
+            ring_buffer_reference[WriteIndex] = transfer ? reference_mix[i] : 0.0f;
+            WriteIndex = (WriteIndex + 1) % ring_buffer.size();
+        }
+    }
+
+    // kept from releaseRetiredTables until the batch is submitted.
+    framing.store(true);
+    const auto* tables = active_tables.load();
+
+    // the order was just changed, its tables come with the next timer tick.
+    if (tables == nullptr || tables->getFrameSize() != fft_size)
+    {
+        framing.store(false);
+        return;
+    }
+
+    const float* windowing_array = tables->window->data;
+    int          num_bins        = tables->getNumBins();
+
     // Collect all available frames from the ring buffer into a local snapshot.
     // We do the ring buffer reads here on the audio thread (cheap), then hand
     // the raw samples to the worker thread for the actual FFT + amplitude math.
-    struct FrameSnapshot {
-        std::vector<float> samples; // windowed samples, fft_size long
-    };
-
     std::vector<FrameSnapshot> frames;
     frames.reserve(MAX_ACCUMULATED);
 
@@ -162,101 +392,169 @@ void PFFFT::processBlock(const float* input, int numSamples, float bpm, float SR
         if (available < fft_size) break;
 
         FrameSnapshot snap;
-        snap.samples.resize(fft_size);
+        snap.samples.resize((transfer ? 3 : 2) * fft_size);
 
         for (int i = 0; i < fft_size; ++i)
         {
             int idx = (ReadIndex + i) % ring_buffer.size();
-            snap.samples[i] = ring_buffer[idx] * windowing_array[i];
+            snap.samples[i]            = ring_buffer[idx] * windowing_array[i];
+            snap.samples[fft_size + i] = ring_buffer_right[idx] * windowing_array[i];
         }
 
+        if (transfer)
+            for (int i = 0; i < fft_size; ++i)
+                snap.samples[2 * fft_size + i] = ring_buffer_reference[(ReadIndex + i) % ring_buffer.size()]
+                                               * windowing_array[i];
+
         frames.push_back(std::move(snap));
         ReadIndex = (ReadIndex + hop_size) % ring_buffer.size();
     }
 
-    if (frames.empty()) return;
-
-    // Submit all the FFT work to the pool.
-    // The lambda captures by value everything the worker needs:
-    //   - frames        : the windowed sample data (moved in)
-    //   - setup         : read-only PFFFT_Setup*, safe across threads
-    //   - fft_size/bins : plain ints
-    //   - bpm/SR/N/D    : plain values for result metadata
-    //   - this          : to access worker_buffers and push to result_queue
-    //
-    // worker_id is received via the task_init_callback to index worker_buffers.
-    // We use a shared_ptr<int> to pass the worker_id into the lambda because
-    // we can't capture it directly before submission.
-
-    // Round-robin worker buffer selection — audio thread is the only submitter,
-    // so this counter has no race.
-    static int buffer_index = 0;
-    int buf_idx = buffer_index % 2;
-    buffer_index++;
-
-    // Capture everything by value. frames is moved in to avoid a copy.
-    fft_worker_pool.submit_work([
-        this,
-        frames      = std::move(frames),
-        setup,
-        fft_size,
-        num_bins,
-        buf_idx,
-        bpm, SR, N, D
-    ]() mutable
+    if (frames.empty())
     {
-        WorkerFFTBuffers& bufs = worker_buffers[buf_idx];
+        framing.store(false);
+        return;
+    }
 
-        FFTResult result;
-        result.num_bins     = num_bins;
-        result.bpm          = bpm;
-        result.sample_rate  = SR;
-        result.N            = N;
-        result.D            = D;
+    // Hand the frames to the shared workers. The batch carries everything
+    // the worker needs by value (the frames are moved in), the tables stay
+    // held by this instance while it is pending. The transform runs in the worker thread's own
+    // buffers, whichever worker of the pool takes the batch.
+    FFTBatch batch;
+    batch.frames      = std::move(frames);
+    batch.tables      = tables;
+    batch.num_bins    = num_bins;
+    batch.sequence    = batch_sequence++;
+    batch.hop_size    = hop_size;
+    batch.bpm         = bpm;
+    batch.sample_rate = analysis_rate;
+    batch.N           = N;
+    batch.D           = D;
+
+    // the phase plane costs an atan2 per bin, only computed while it is shown.
+    batch.phase_view = (int) apvts_ref.getRawParameterValue("sg_phase")->load();
+
+    batch.submitted_at = PerfCounters::now();
+    if (perf)
+    {
+        perf->record(PerfFFTQueueDepth, (uint64_t) fft_client->getPending());
+    }
 
-        for (int i = 0; i < MAX_ACCUMULATED; ++i)
-            result.amplitude_data[i].resize(num_bins);
+    // the workers are SHARED_CLIENT_QUEUE_SIZE batches behind, these frames are lost.
+    if (!fft_client->submit(std::move(batch)))
+    {
+        // no gap for timerCallback to wait on.
+        --batch_sequence;
+        if (perf)
+            perf->add(PerfFramesDropped, batch.frames.size());
+    }
 
-        int indx = 0;
-        for (auto& frame : frames)
-        {
-            // copy windowed samples into this worker's own input buffer
-            std::memcpy(bufs.input, frame.samples.data(), fft_size * sizeof(float));
+    framing.store(false);
+}
 
-            pffft_transform_ordered(setup, bufs.input, bufs.output, bufs.work, PFFFT_FORWARD);
+void PFFFT::runBatch(FFTBatch& batch)
+{
+    WorkerFFTBuffers& bufs = SharedAnalysisEngine::getWorkerBuffers();
 
-            calculateAmplitudesFromFFT(bufs.output, result.amplitude_data[indx].data(), fft_size);
+    FFTResult result;
+    result.num_bins     = batch.num_bins;
+    result.bpm          = batch.bpm;
+    result.sample_rate  = batch.sample_rate;
+    result.N            = batch.N;
+    result.D            = batch.D;
+    result.sequence     = batch.sequence;
+    result.hop_size     = batch.hop_size;
+    result.phase_view   = batch.phase_view;
+    result.window       = batch.tables->window;
 
-            indx++;
-        }
+    transformBatch(batch.frames, *batch.tables, bufs, result);
 
-        result.valid_frames = indx;
+    if (perf) perf->record(PerfFFTLatency, PerfCounters::microsecondsSince(batch.submitted_at));
 
-        // Push to result queue — timerCallback drains this on the UI thread.
-        {
-            std::lock_guard<std::mutex> lock(result_mutex);
-            result_queue.push_back(std::move(result));
-        }
-    });
+    // written here rather than on the UI thread, disk writes must not hold up drawing.
+    recordResult(result);
+
+    // Push to result queue — timerCallback drains this on the UI thread.
+    {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        result_queue.push_back(std::move(result));
+    }
 }
 
-void PFFFT::calculateAmplitudesFromFFT(float* input, float* output, int numSamples)
+void PFFFT::transformBatch(const std::vector<FrameSnapshot>& frames, const FFTTables& tables,
+                           WorkerFFTBuffers& bufs, FFTResult& result)
 {
-    int num_bins = (numSamples / 2) + 1;
-    output[0] = std::abs(input[0]);            // DC
-    output[num_bins - 1] = std::abs(input[1]); // Nyquist
-    for (int bin = 1; bin < num_bins - 1; ++bin) {
-        float real = input[2 * bin];
-        float imag = input[2 * bin + 1];
-        output[bin] = std::sqrt(real * real + imag * imag);
-    }
+    int frame_size = tables.getFrameSize();
+    int fft_size   = tables.getFFTSize();
+    int num_bins   = tables.getNumBins();
+
+    // the padding stays zero, only the frame is copied in.
+    bufs.reserve(fft_size);
+    std::fill(bufs.input + frame_size, bufs.input + fft_size, 0.0f);
+
+    const float scale = tables.window->amplitude_scale;
+
+    for (int view = 0; view < NumAnalysisViews; ++view)
+        for (int i = 0; i < (int)frames.size(); ++i)
+            result.amplitude_data[view][i].resize(num_bins);
+
+    result.cross.resize(num_bins);
+
+    const bool with_phase = result.phase_view != PhaseOff;
+    if (with_phase)
+        for (int i = 0; i < (int)frames.size(); ++i)
+            result.phase_data[i].resize(num_bins);
+
+    // frames with a third plane, the reference, see processBlock.
+    const bool with_transfer = !frames.empty() && (int)frames[0].samples.size() >= 3 * frame_size;
+    if (with_transfer)
+        result.transfer.resize(num_bins);
 
-    for (int bin = 0; bin < num_bins; ++bin) {
-        output[bin] /= (float)numSamples;
-        output[bin] = 
-            jmap<float>(
-                20.0f * log10f(std::clamp<float>(output[bin], 0.0, 1.0) + 1e-4f),
-                -80, 0, 0, 1
-            );
+    int indx = 0;
+    for (auto& frame : frames)
+    {
+        // both channels through the same setup, into this worker's own buffers.
+        std::memcpy(bufs.input, frame.samples.data(), frame_size * sizeof(float));
+        pffft_transform_ordered(tables.plan->setup, bufs.input, bufs.output, bufs.work, PFFFT_FORWARD);
+
+        std::memcpy(bufs.input, frame.samples.data() + frame_size, frame_size * sizeof(float));
+        pffft_transform_ordered(tables.plan->setup, bufs.input, bufs.output_right, bufs.work, PFFFT_FORWARD);
+
+        calculateAmplitudesFromFFT(bufs.output, result.amplitude_data[ViewLeft][indx].data(), fft_size, scale);
+        calculateAmplitudesFromFFT(bufs.output_right, result.amplitude_data[ViewRight][indx].data(), fft_size, scale);
+
+        // the transform is linear, mid and side are sums of the two spectra.
+        for (int i = 0; i < fft_size; ++i)
+            bufs.mix[i] = (bufs.output[i] + bufs.output_right[i]) * 0.5f;
+        calculateAmplitudesFromFFT(bufs.mix, result.amplitude_data[ViewMid][indx].data(), fft_size, scale);
+
+        // the mid against the reference's, for H1 = S_xy / S_xx.
+        if (with_transfer)
+        {
+            std::memcpy(bufs.input, frame.samples.data() + 2 * frame_size, frame_size * sizeof(float));
+            pffft_transform_ordered(tables.plan->setup, bufs.input, bufs.output_reference, bufs.work, PFFFT_FORWARD);
+
+            result.transfer.accumulate(bufs.mix, bufs.output_reference, fft_size);
+        }
+
+        for (int i = 0; i < fft_size; ++i)
+            bufs.mix[i] = (bufs.output[i] - bufs.output_right[i]) * 0.5f;
+        calculateAmplitudesFromFFT(bufs.mix, result.amplitude_data[ViewSide][indx].data(), fft_size, scale);
+
+        result.cross.accumulate(bufs.output, bufs.output_right, fft_size);
+
+        if (with_phase)
+            computePhasePlane(bufs.output, bufs.output_right, fft_size, (PhaseView) result.phase_view,
+                              result.sample_rate, bufs.mix, result.phase_data[indx].data());
+
+        indx++;
     }
-}
\ No newline at end of file
+
+    result.valid_frames = indx;
+}
+
+void PFFFT::calculateAmplitudesFromFFT(float* input, float* output, int numSamples, float amplitude_scale)
+{
+    // shared with the offline tool, so both produce the same amplitudes.
+    SpectrumEngine::amplitudesFromFFT(input, output, numSamples, amplitude_scale);
+}
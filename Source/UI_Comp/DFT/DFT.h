@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include <mutex>
 #include <deque>
+#include <map>
 
 #include "../../../pfft/fftpack.h"
 #include "../../../pfft/pffft.h"
@@ -17,49 +18,73 @@
 #include "../Analyser/Analyser.h"
 #include "../Spectrogram/Spectrogram.h"
 
-#include "../../ds/dataStructure.h"
+#include "../../ds/PerfCounters.h"
 
 #include "../../../rwqueue/readerwritercircularbuffer.h"
 
 #include "../util.h"
-#include "workerpool.h"
+#include "SharedAnalysisEngine.h"
+#include "SpectrumEngine.h"
+#include "Decimator.h"
+#include "CrossSpectrum.h"
+#include "PhaseSpectrum.h"
+#include "AnalysisRecorder.h"
 
 using namespace juce;
 
 #define FPS 60
-#define MAX_BUFFER_SIZE 8192
 #define INPUT_RING_BUFFER_SIZE 8192 * 4
 #define MAX_ACCUMULATED 32
+// samples decimated at once, into a fixed scratch.
+#define DECIMATION_CHUNK 1024
+
+// One frame taken from the ring buffer on the audio thread.
+struct FrameSnapshot {
+    // windowed samples, fft_size of L then fft_size of R, then fft_size of
+    // the reference's mid in transfer mode.
+    std::vector<float> samples;
+};
 
-// One per worker thread — each worker gets its own aligned FFT buffers
-// so pffft_transform_ordered is never called with shared memory across threads.
-struct WorkerFFTBuffers {
-    float* input  = (float*)pffft_aligned_malloc(sizeof(float) * 8192);
-    float* work   = (float*)pffft_aligned_malloc(sizeof(float) * 8192);
-    float* output = (float*)pffft_aligned_malloc(sizeof(float) * 8192);
-
-    WorkerFFTBuffers() = default;
-
-    // not copyable — these are raw heap allocations
-    WorkerFFTBuffers(const WorkerFFTBuffers&)            = delete;
-    WorkerFFTBuffers& operator=(const WorkerFFTBuffers&) = delete;
-
-    ~WorkerFFTBuffers() {
-        pffft_aligned_free(input);
-        pffft_aligned_free(work);
-        pffft_aligned_free(output);
-    }
+// the frames processBlock collected and what the worker needs with them,
+// moved through the instance's client queue.
+struct FFTBatch {
+    std::vector<FrameSnapshot> frames;
+    // read only, held by the instance until no batch is pending.
+    const FFTTables* tables = nullptr;
+    int      num_bins   = 0;
+    uint64_t sequence   = 0;
+    int      hop_size   = HOP_SIZE;
+    int      phase_view = PhaseOff;
+    float    bpm        = 0.0f;
+    float    sample_rate = 0.0f;
+    int      N          = 0;
+    int      D          = 0;
+    PerfCounters::Clock::time_point submitted_at;
 };
 
 // Result of one processed FFT batch, passed from worker thread to UI thread.
 struct FFTResult {
-    std::array<std::vector<float>, MAX_ACCUMULATED> amplitude_data;
+    // [view][frame], every view of every frame, see AnalysisView.
+    std::array<std::array<std::vector<float>, MAX_ACCUMULATED>, NumAnalysisViews> amplitude_data;
+    // of L and R, summed over the batch's frames.
+    CrossSpectrum cross;
+    // of the mid (measured) and the reference, summed over the batch's
+    // frames. Empty outside transfer mode.
+    CrossSpectrum transfer;
+    // [frame], the plane of "sg_phase" at submission, empty while it is off.
+    std::array<std::vector<float>, MAX_ACCUMULATED> phase_data;
+    int    phase_view   = PhaseOff;
     int    valid_frames = 0;
     int    num_bins     = 0;
     float  bpm          = 0.0f;
     float  sample_rate  = 0.0f;
     int    N            = 0;
     int    D            = 0;
+    int    hop_size     = HOP_SIZE;
+    // of the frames, for the analyser's peak fit.
+    std::shared_ptr<const WindowTable> window;
+    // submission order, workers may finish out of it.
+    uint64_t sequence   = 0;
 };
 
 // pfft wrapper to be used in this project.
@@ -72,7 +97,7 @@ public:
 
     // callback happens when a new frame of data is available.
     // send back the calculated amplitudes, with the number of bins.
-    PFFFT(AudioProcessorValueTreeState& apvts_reference);
+    PFFFT(AudioProcessorValueTreeState& apvts_reference, PerfCounters* perf_counters = nullptr);
     ~PFFFT();
 
     void play();
@@ -85,45 +110,102 @@ public:
     void cleanAllContainers();
 
     // automatically triggers the spectogram's and the analysers
-    // repaint methods.
-    void processBlock(const float* input, int numSamples, float bpm, float SR, int N, int D);
-
-    static void calculateAmplitudesFromFFT(float* input, float* output, int numSamples);
+    // repaint methods. Both channels are analysed at once, every view
+    // ("gb_chnl") is computed from their spectra, so switching is instant.
+    // `right` may be `left` on a mono bus. With a reference (the sidechain,
+    // both the same when mono) its mid is the input of a system whose output
+    // is the mid of `left` and `right`, and the batches carry the spectra
+    // of the transfer function, see SpectrumAnalyserComponent::newTransfer.
+    void processBlock(const float* left, const float* right, int numSamples, float bpm, float SR, int N, int D,
+                      const float* reference_left = nullptr, const float* reference_right = nullptr);
+
+    // `amplitude_scale` is the window's, see WindowTable.
+    static void calculateAmplitudesFromFFT(float* input, float* output, int numSamples, float amplitude_scale);
+
+    // the worker side of a batch: FFT and amplitudes of every frame into
+    // `result`, using only `bufs` for scratch.
+    static void transformBatch(const std::vector<FrameSnapshot>& frames, const FFTTables& tables,
+                               WorkerFFTBuffers& bufs, FFTResult& result);
 
     int getHeight() { return spectrogram_component->getHeight(); }
+
+    // set by the quality governor on the message thread: a hop `hop_multiplier`
+    // times longer and an FFT `order_drop` orders below "gb_fft_ord" (9 at least),
+    // picked up by the next block.
+    void setQuality(int hop_multiplier, int order_drop);
    
 private:
 
-    // ── worker pool ──────────────────────────────────────────────────────────
-    // 2 workers: one for spectrogram, one for analyser frames.
-    // More than 2 rarely helps since timerCallback is the bottleneck.
-    VoidVoidWorkerPool fft_worker_pool { 2 };
-
-    // Per-worker FFT buffers — indexed by worker_id (0 or 1).
-    // Constructed once, never resized, so the pointer is stable.
-    std::array<WorkerFFTBuffers, 2> worker_buffers;
+    // a worker's: the batch's FFTs into an FFTResult for the result queue.
+    void runBatch(FFTBatch& batch);
+
+    // appends a batch to the analysis file while "gb_record" is on,
+    // called from the worker threads.
+    void recordResult(const FFTResult& result);
+    // message thread, hands a batch to the spectrogram and the analyser.
+    void showResult(const FFTResult& result);
+    void stopRecordingIfDisabled();
+
+    // index into SUPPORTED_N_VALUES of the order processBlock runs at,
+    // -1 when "gb_fft_ord" holds an unsupported one.
+    int getActiveFFTIndex() const;
+    // message thread, publishes the tables of that order, the "gb_window"
+    // window and the "gb_zero_pad" padding, built (or shared) the first
+    // time they are used.
+    void updateTables();
+    // message thread, lets go of the tables that are no longer active once
+    // nothing uses them anymore.
+    void releaseRetiredTables();
+
+    // ── analysis recording ───────────────────────────────────────────────────
+    // a new file every time recording starts, the FFT order or the "gb_chnl"
+    // view changes, named after the view it holds.
+    AnalysisRecorder recorder;
+    std::mutex       recorder_mutex;
+    int              recorded_view = ViewMid;
+    uint64_t         batch_sequence = 0;
 
     // Result queue — worker threads push, timerCallback drains on UI thread.
     // Protected by result_mutex.
     std::deque<FFTResult> result_queue;
     std::mutex            result_mutex;
 
-    // ── original members ─────────────────────────────────────────────────────
-    std::array<std::vector<float>, MAX_ACCUMULATED> processed_amplitude_data;
+    // message thread only, the results that came before the one due, by
+    // sequence, ANALYSIS_MAX_PENDING at most.
+    std::map<uint64_t, FFTResult> held_results;
+    uint64_t                      next_result = 0;
 
+    // ── original members ─────────────────────────────────────────────────────
     std::unique_ptr<SpectrogramComponent>     spectrogram_component;
     std::unique_ptr<SpectrumAnalyserComponent> spectral_analyser_component;
 
-    std::vector<float> ring_buffer;
+    // same indices for both channels.
+    std::vector<float> ring_buffer, ring_buffer_right;
     int ReadIndex = 0, WriteIndex = 0;
 
+    // audio thread only. With "gb_decimate" on, everything from the ring
+    // buffers on runs at the sample rate over the decimators' factor.
+    Decimator decimator, decimator_right;
+    std::array<float, DECIMATION_CHUNK> decimated, decimated_right;
+
+    // transfer mode, audio thread only. The reference is mixed and
+    // decimated in place, written to its ring at the main input's indices.
+    std::vector<float> ring_buffer_reference;
+    Decimator decimator_reference;
+    std::array<float, DECIMATION_CHUNK> reference_mix;
+    bool transfer_active = false;
+
     AudioProcessorValueTreeState& apvts_ref;
+    PerfCounters* perf;
 
     int tick = 0;
     static std::function<int(int)> powToTwo;
 
     float overlap_samples = HOP_SIZE;
 
+    std::atomic<int> quality_hop_multiplier { 1 };
+    std::atomic<int> quality_order_drop { 0 };
+
     const int NUM_SUPPORTED_N = 5;
 
     const std::unordered_map<int, int> SUPPPORTED_N_INDEX
@@ -153,25 +235,21 @@ private:
         powToTwo(SUPPORTED_N_VALUES[4])
     };
 
-    // Setups can be safely used from multiple threads — they are read only.
-    const std::vector<PFFFT_Setup*> pffft_setups
-    {
-        pffft_new_setup(powToTwo(SUPPORTED_N_VALUES[0]), PFFFT_REAL),
-        pffft_new_setup(powToTwo(SUPPORTED_N_VALUES[1]), PFFFT_REAL),
-        pffft_new_setup(powToTwo(SUPPORTED_N_VALUES[2]), PFFFT_REAL),
-        pffft_new_setup(powToTwo(SUPPORTED_N_VALUES[3]), PFFFT_REAL),
-        pffft_new_setup(powToTwo(SUPPORTED_N_VALUES[4]), PFFFT_REAL)
-    };
-
-    std::vector<std::vector<float>> windows;
-
-    int SUPER_SET_SIZE = powToTwo(SUPPORTED_N_VALUES[4]);
-
-    // These are now only used for the ring buffer read on the audio thread.
-    // Per-worker transform buffers live in worker_buffers above.
-    float* pffft_input  = (float*)pffft_aligned_malloc(sizeof(float) * SUPER_SET_SIZE);
-    float* pffft_work   = (float*)pffft_aligned_malloc(sizeof(float) * SUPER_SET_SIZE);
-    float* pffft_output = (float*)pffft_aligned_malloc(sizeof(float) * SUPER_SET_SIZE);
-
-    std::vector<float> amplitude_buffer;
+    // the active setup and window and the ones retired since, shared with
+    // the other instances, read only so safe from multiple threads. Acquired
+    // on the message thread, the retired ones are dropped once processBlock
+    // is not framing and no batch is pending, so one in flight never loses
+    // them. processBlock only reads the published one and skips framing
+    // until it has the order asked for.
+    std::vector<std::shared_ptr<const FFTTables>> held_tables;
+    std::atomic<const FFTTables*> active_tables { nullptr };
+    // set by processBlock before it reads active_tables, until its batch is
+    // submitted.
+    std::atomic<bool> framing { false };
+
+    // ── workers ──────────────────────────────────────────────────────────────
+    // this instance's queue into the process wide pool. Declared last, so
+    // its batches are done before anything they touch is destroyed.
+    std::unique_ptr<SharedAnalysisEngine::TaskClient<FFTBatch>> fft_client =
+        SharedAnalysisEngine::connect<FFTBatch>([this] (FFTBatch& batch) { runBatch(batch); });
 };
\ No newline at end of file
@@ -0,0 +1,167 @@
+#pragma once
+
+// Lowers the rate ahead of the FFT, so a fixed FFT size spends its bins on
+// the band the display can show: at 192 kHz, 8192 points at a quarter of
+// the rate give 5.9 Hz bins instead of 23 Hz, from a quarter of the frames.
+// The factor follows the sample rate only. A new factor starts the frames
+// over, so zooming the range must not pick it.
+// Free of any juce dependency, like the correlation's BandSplitter.
+//
+// A kaiser windowed sinc low pass in polyphase form: only the outputs that
+// are kept get computed, one dot product over the last factor *
+// DECIMATOR_TAPS_PER_PHASE samples every factor-th input, so the cost per
+// input sample does not grow with the factor. The dot product runs over
+// DECIMATOR_LANES partial sums, a fixed length loop the compiler
+// vectorizes. The filters of every factor are designed up front, nothing
+// allocates afterwards.
+
+#include <cmath>
+#include <algorithm>
+
+#include "FFTTables.h"
+
+#define DECIMATOR_MAX_FACTOR 8
+#define DECIMATOR_NUM_FACTORS 4
+#define DECIMATOR_TAPS_PER_PHASE 64
+#define DECIMATOR_MAX_TAPS (DECIMATOR_MAX_FACTOR * DECIMATOR_TAPS_PER_PHASE)
+#define DECIMATOR_LANES 8
+// share of the decimated nyquist that is kept flat. The transition band
+// above it is as wide again, so whatever aliases lands above the range.
+#define DECIMATOR_PASSBAND 0.92
+// about 80 dB down in the stop band, the bottom of the display.
+#define DECIMATOR_KAISER_BETA 8.0
+// share of the decimated nyquist the sinc is cut at. Cut at the nyquist
+// itself the shortest filter (factor 2) is only 79.5 dB down from
+// 2 - DECIMATOR_PASSBAND of it, a hair under gives 81.
+#define DECIMATOR_CUTOFF 0.998
+// the top of "sp_rng_max", the band every factor has to hold.
+#define DECIMATOR_MAX_FREQUENCY 20000.0
+
+class Decimator
+{
+public:
+
+    Decimator()
+    {
+        const double pi = 3.14159265358979323846;
+
+        for (int f = 0; f < DECIMATOR_NUM_FACTORS; ++f)
+        {
+            const int factor = 1 << f;
+            const int taps = factor * DECIMATOR_TAPS_PER_PHASE;
+            const double cutoff = DECIMATOR_CUTOFF * 0.5 / factor;   // of the input rate.
+            const double centre = 0.5 * (taps - 1);
+            const double norm = 1.0 / besselI0(DECIMATOR_KAISER_BETA);
+
+            double sum = 0.0;
+            for (int n = 0; n < taps; ++n)
+            {
+                const double t = n - centre;
+                const double sinc = 2.0 * cutoff * (t == 0.0 ? 1.0 : std::sin(2.0 * pi * cutoff * t) / (2.0 * pi * cutoff * t));
+                const double r = t / centre;
+                const double w = besselI0(DECIMATOR_KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) * norm;
+
+                coefficients[f][n] = (float) (sinc * w);
+                sum += sinc * w;
+            }
+
+            // unity gain at DC.
+            for (int n = 0; n < taps; ++n)
+                coefficients[f][n] = (float) (coefficients[f][n] / sum);
+        }
+
+        reset();
+    }
+
+    // the largest power of two whose band still holds DECIMATOR_MAX_FREQUENCY:
+    // 4 at 176.4 and 192 kHz, 2 at 88.2 and 96 kHz, none below.
+    static int chooseFactor(double sample_rate)
+    {
+        int factor = 1;
+        while (factor < DECIMATOR_MAX_FACTOR
+               && DECIMATOR_MAX_FREQUENCY <= DECIMATOR_PASSBAND * sample_rate / (4.0 * factor))
+            factor *= 2;
+        return factor;
+    }
+
+    int getFactor() const { return factor; }
+
+    // a power of two up to DECIMATOR_MAX_FACTOR, starts over from silence
+    // when it changes. Does not allocate.
+    void setFactor(int new_factor)
+    {
+        new_factor = std::clamp(new_factor, 1, DECIMATOR_MAX_FACTOR);
+        if (new_factor == factor)
+            return;
+
+        factor = new_factor;
+        factor_index = 0;
+        while ((1 << factor_index) < factor)
+            ++factor_index;
+
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(history, history + 2 * DECIMATOR_MAX_TAPS, 0.0f);
+        write_pos = 0;
+        phase = 0;
+    }
+
+    // `num` samples in, about num / factor out, returns how many were written.
+    // `output` may be `input`, no output is written ahead of what was read.
+    int process(const float* input, float* output, int num)
+    {
+        if (factor == 1)
+        {
+            if (output != input) std::copy(input, input + num, output);
+            return num;
+        }
+
+        const int taps = factor * DECIMATOR_TAPS_PER_PHASE;
+        const float* h = coefficients[factor_index];
+        int written = 0;
+
+        for (int i = 0; i < num; ++i)
+        {
+            // written twice so the last `taps` samples are always contiguous.
+            history[write_pos] = input[i];
+            history[write_pos + taps] = input[i];
+            if (++write_pos == taps) write_pos = 0;
+
+            if (++phase < factor)
+                continue;
+            phase = 0;
+
+            // the filter is symmetric, so it runs forward over oldest to newest.
+            output[written++] = dot(h, history + write_pos, taps);
+        }
+
+        return written;
+    }
+
+private:
+
+    static float dot(const float* a, const float* b, int num)
+    {
+        float lanes[DECIMATOR_LANES] = {};
+
+        for (int i = 0; i < num; i += DECIMATOR_LANES)
+            for (int j = 0; j < DECIMATOR_LANES; ++j)
+                lanes[j] += a[i + j] * b[i + j];
+
+        float sum = 0.0f;
+        for (int j = 0; j < DECIMATOR_LANES; ++j)
+            sum += lanes[j];
+        return sum;
+    }
+
+    alignas(16) float coefficients[DECIMATOR_NUM_FACTORS][DECIMATOR_MAX_TAPS] = {};
+    alignas(16) float history[2 * DECIMATOR_MAX_TAPS] = {};
+
+    int factor = 1;
+    int factor_index = 0;
+    int write_pos = 0;
+    int phase = 0;
+};
@@ -0,0 +1,84 @@
+#include "FFTTables.h"
+
+#include <algorithm>
+#include <cmath>
+
+FFTPlan::FFTPlan(int fft_order)
+    :   fft_size(1 << fft_order),
+        setup(pffft_new_setup(1 << fft_order, PFFFT_REAL))
+{
+}
+
+FFTPlan::~FFTPlan()
+{
+    if (setup) pffft_destroy_setup(setup);
+}
+
+double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    const double quarter_x2 = 0.25 * x * x;
+
+    for (int k = 1; k < 64 && term > sum * 1e-12; ++k)
+    {
+        term *= quarter_x2 / ((double) k * (double) k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+WindowTable::WindowTable(int size, AnalysisWindowType window_type, float beta)
+    :   fft_size(size),
+        type(window_type),
+        kaiser_beta(std::max(beta, 0.0f)),
+        data((float*)pffft_aligned_malloc(sizeof(float) * size))
+{
+    const double pi = 3.14159265358979323846;
+    const double span = (double) std::max(fft_size - 1, 1);
+
+    // cosine sums, symmetric like juce's tables.
+    auto cosineSum = [&](const double* a, int terms, int n)
+    {
+        double value = 0.0, sign = 1.0;
+        for (int k = 0; k < terms; ++k, sign = -sign)
+            value += sign * a[k] * std::cos(2.0 * pi * k * n / span);
+        return value;
+    };
+
+    static const double hann[]            = { 0.5, 0.5 };
+    static const double blackman_harris[] = { 0.35875, 0.48829, 0.14128, 0.01168 };
+    static const double flat_top[]        = { 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368 };
+
+    const double kaiser_norm = 1.0 / besselI0(kaiser_beta);
+    double sum = 0.0;
+
+    for (int n = 0; n < fft_size; ++n)
+    {
+        double w;
+
+        switch (type)
+        {
+            case WindowBlackmanHarris: w = cosineSum(blackman_harris, 4, n); break;
+            case WindowFlatTop:        w = cosineSum(flat_top, 5, n);        break;
+            case WindowKaiser:
+            {
+                const double r = 2.0 * n / span - 1.0;
+                w = besselI0(kaiser_beta * std::sqrt(std::max(0.0, 1.0 - r * r))) * kaiser_norm;
+                break;
+            }
+            default:                   w = cosineSum(hann, 2, n);            break;
+        }
+
+        data[n] = (float) w;
+        sum += w;
+    }
+
+    coherent_gain = sum / (double) fft_size;
+    amplitude_scale = (float) (2.0 / std::max(sum, 1e-12));
+}
+
+WindowTable::~WindowTable()
+{
+    pffft_aligned_free(data);
+}
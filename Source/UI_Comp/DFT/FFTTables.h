@@ -0,0 +1,82 @@
+#pragma once
+
+// The read only tables an FFT frame needs: the pffft setup of its order,
+// and the analysis window with the gain that puts a tone's peak back at
+// its amplitude. Built once and safe to use from any thread.
+//
+// The setup may be of a larger order than the window: the frame is then
+// zero padded, which interpolates the same spectrum on a denser bin grid
+// without a longer (slower to react) window.
+//
+// Free of any juce dependency.
+
+#include <memory>
+
+#include "../../../pfft/pffft.h"
+
+enum AnalysisWindowType
+{
+    WindowHann,
+    WindowBlackmanHarris,   // 4 term, -92 dB side lobes.
+    WindowFlatTop,          // 5 term, < 0.01 dB scalloping, for level readings.
+    WindowKaiser,           // side lobes from its beta.
+    NumWindowTypes
+};
+
+#define WINDOW_DEFAULT_KAISER_BETA 9.0f
+
+// zero padding of 2^bits, the padded transform is 2^FFT_MAX_PADDED_ORDER at
+// most: its bins have to fit the analyser's texture.
+#define FFT_MAX_ZERO_PAD_BITS 2
+#define FFT_MAX_PADDED_ORDER 14
+
+// zeroth order modified bessel function of the first kind, its power
+// series. The kaiser window's, also used by the Decimator's filters.
+double besselI0(double x);
+
+// the pffft setup of one order.
+struct FFTPlan
+{
+    explicit FFTPlan(int fft_order);
+    ~FFTPlan();
+
+    FFTPlan(const FFTPlan&)            = delete;
+    FFTPlan& operator=(const FFTPlan&) = delete;
+
+    int fft_size;
+    PFFFT_Setup* setup;
+};
+
+// one window of `fft_size` points, 16 byte aligned like the pffft buffers.
+struct WindowTable
+{
+    WindowTable(int fft_size, AnalysisWindowType type, float kaiser_beta = WINDOW_DEFAULT_KAISER_BETA);
+    ~WindowTable();
+
+    WindowTable(const WindowTable&)            = delete;
+    WindowTable& operator=(const WindowTable&) = delete;
+
+    int fft_size;
+    AnalysisWindowType type;
+    float kaiser_beta;
+
+    float* data;
+
+    // mean of the window, what it takes off a tone's peak.
+    double coherent_gain;
+    // |X[k]| * this is the amplitude of a tone in bin k, coherent gain and
+    // the energy of the negative frequencies folded in. Halve it for DC and Nyquist.
+    float amplitude_scale;
+};
+
+struct FFTTables
+{
+    std::shared_ptr<const FFTPlan> plan;
+    std::shared_ptr<const WindowTable> window;
+
+    // the transform, zero padding included.
+    int getFFTSize() const { return plan->fft_size; }
+    int getNumBins() const { return plan->fft_size / 2 + 1; }
+    // the samples of a frame, the window's length.
+    int getFrameSize() const { return window->fft_size; }
+};
@@ -0,0 +1,215 @@
+#include "PeakEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+PeakEstimator::PeakEstimator(const WindowTable& window, int size)
+    :   fft_size(size)
+{
+    const double pi = 3.14159265358979323846;
+    const int window_size = window.fft_size;
+
+    spread = std::clamp(fft_size / std::max(window_size, 1), 1, PEAK_MAX_SPREAD);
+
+    const double table_end = (double) PEAK_KERNEL_BINS * fft_size / window_size;
+    const int count = (int) (table_end * PEAK_KERNEL_STEPS) + 2;
+
+    values.resize(count);
+    slopes.resize(count);
+
+    double sum = 0.0;
+    for (int n = 0; n < window_size; ++n)
+        sum += window.data[n];
+
+    // the window is symmetric about its centre, its transform is real
+    // there: a sum of cosines over one half, the rotation stepped along.
+    const double centre = 0.5 * (window_size - 1);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const double step = 2.0 * pi * i / ((double) PEAK_KERNEL_STEPS * fft_size);
+        const double step_re = std::cos(step), step_im = std::sin(step);
+        double re = std::cos(step * centre), im = -std::sin(step * centre);
+        double value = 0.0, slope = 0.0;
+
+        for (int n = 0; n < window_size / 2; ++n)
+        {
+            const double distance = n - centre;
+
+            value += window.data[n] * re;
+            slope -= window.data[n] * im * distance;
+
+            const double next_re = re * step_re - im * step_im;
+            im = re * step_im + im * step_re;
+            re = next_re;
+        }
+
+        values[i] = 2.0 * value / sum;
+        slopes[i] = 2.0 * slope * 2.0 * pi / fft_size / sum;
+    }
+}
+
+double PeakEstimator::kernel(double bins, double& slope) const
+{
+    const double sign = bins < 0.0 ? -1.0 : 1.0;
+    const double at = std::fabs(bins) * PEAK_KERNEL_STEPS;
+    const int i = (int) at;
+
+    if (i + 1 >= (int) values.size())
+    {
+        slope = 0.0;
+        return 0.0;
+    }
+
+    // cubic hermite between the points, its values and slopes both exact.
+    const double t = at - i, h = 1.0 / PEAK_KERNEL_STEPS;
+    const double p0 = values[i], p1 = values[i + 1];
+    const double m0 = slopes[i] * h, m1 = slopes[i + 1] * h;
+    const double t2 = t * t, t3 = t2 * t;
+
+    slope = sign * ((6.0 * t2 - 6.0 * t) * (p0 - p1) + (3.0 * t2 - 4.0 * t + 1.0) * m0
+                    + (3.0 * t2 - 2.0 * t) * m1) / h;
+
+    return (2.0 * t3 - 3.0 * t2 + 1.0) * p0 + (t3 - 2.0 * t2 + t) * m0
+         + (-2.0 * t3 + 3.0 * t2) * p1 + (t3 - t2) * m1;
+}
+
+double PeakEstimator::estimate(const float* amplitudes, int num_bins, int peak_bin, float& amplitude) const
+{
+    const double pi = 3.14159265358979323846;
+
+    amplitude = amplitudes[peak_bin];
+    if (peak_bin < 1 || peak_bin > num_bins - 2)
+        return peak_bin;
+
+    // back to magnitudes, relative to the peak bin's. Flat or clamped at the
+    // -80 dB floor, nothing to fit.
+    const float left = amplitudes[peak_bin - 1], centre = amplitudes[peak_bin], right = amplitudes[peak_bin + 1];
+    const float curvature = left - 2.0f * centre + right;
+    if (!(curvature < 0.0f && left > 0.0f && right > 0.0f))
+        return peak_bin;
+
+    // a bin of the unpadded window each side: padded bins lie too close
+    // together to tell the image from a shift of the tone.
+    const int first = std::max(1, peak_bin - spread), last = std::min(num_bins - 2, peak_bin + spread);
+    const int count = last - first + 1;
+
+    double measured[2 * PEAK_MAX_SPREAD + 1] = {};
+    for (int j = 0; j < count; ++j)
+        measured[j] = std::max(std::pow(10.0, 4.0 * (amplitudes[first + j] - 1.0)) - 1e-4, 0.0);
+
+    const double peak = measured[peak_bin - first];
+    for (int j = 0; j < count; ++j)
+        measured[j] /= peak;
+
+    // the parabola through the dB values to start from.
+    const double start = peak_bin + std::clamp(0.5 * (left - right) / curvature, -0.5, 0.5);
+
+    // |X(k)| = gain |K(k - f) + e^(i turn) K(k + f)|, the tone at f and its
+    // image at -f, `turn` from the tone's phase.
+    auto model = [&](int j, double position, double turn, double& by_position, double& by_turn)
+    {
+        const double bin = first + j;
+        double u_slope, v_slope;
+        const double u = kernel(bin - position, u_slope);
+        const double v = kernel(bin + position, v_slope);
+        u_slope = -u_slope;
+
+        const double c = std::cos(turn), s = std::sin(turn);
+        const double magnitude = std::sqrt(std::max(u * u + v * v + 2.0 * u * v * c, 1e-30));
+
+        by_position = (u * u_slope + v * v_slope + c * (u_slope * v + u * v_slope)) / magnitude;
+        by_turn = -u * v * s / magnitude;
+        return magnitude;
+    };
+
+    double best_position = start, best_gain = 1.0, best_error = 1e30;
+
+    // the turn is unknown, the fit starts from each quadrant.
+    for (int quadrant = 0; quadrant < 4; ++quadrant)
+    {
+        double position = start, turn = 0.5 * pi * quadrant, gain = 1.0;
+        double d_position, d_turn;
+        gain = 1.0 / model(peak_bin - first, position, turn, d_position, d_turn);
+
+        double error = 0.0;
+
+        for (int iteration = 0; iteration < 16; ++iteration)
+        {
+            double jacobian[2 * PEAK_MAX_SPREAD + 1][3], residual[2 * PEAK_MAX_SPREAD + 1];
+            error = 0.0;
+
+            for (int j = 0; j < count; ++j)
+            {
+                const double magnitude = model(j, position, turn, d_position, d_turn);
+                residual[j] = gain * magnitude - measured[j];
+                jacobian[j][0] = magnitude;
+                jacobian[j][1] = gain * d_position;
+                jacobian[j][2] = gain * d_turn;
+                error += residual[j] * residual[j];
+            }
+
+            // gauss newton, damped a little: with the image out of reach
+            // the turn does nothing and its equation is empty.
+            double normal[3][4];
+            for (int a = 0; a < 3; ++a)
+            {
+                for (int b = 0; b < 3; ++b)
+                {
+                    normal[a][b] = 0.0;
+                    for (int j = 0; j < count; ++j)
+                        normal[a][b] += jacobian[j][a] * jacobian[j][b];
+                }
+
+                normal[a][3] = 0.0;
+                for (int j = 0; j < count; ++j)
+                    normal[a][3] -= jacobian[j][a] * residual[j];
+
+                normal[a][a] += 1e-9 * normal[a][a] + 1e-20;
+            }
+
+            for (int a = 0; a < 3; ++a)
+                for (int b = a + 1; b < 3; ++b)
+                {
+                    const double factor = normal[b][a] / normal[a][a];
+                    for (int c = a; c < 4; ++c)
+                        normal[b][c] -= factor * normal[a][c];
+                }
+
+            double step[3];
+            for (int a = 2; a >= 0; --a)
+            {
+                double value = normal[a][3];
+                for (int b = a + 1; b < 3; ++b)
+                    value -= normal[a][b] * step[b];
+                step[a] = value / normal[a][a];
+            }
+
+            gain += step[0];
+            position = std::clamp(position + step[1], (double) first, (double) last);
+            turn += step[2];
+
+            if (std::fabs(step[1]) < 1e-9)
+                break;
+        }
+
+        error = 0.0;
+        for (int j = 0; j < count; ++j)
+        {
+            const double residual = gain * model(j, position, turn, d_position, d_turn) - measured[j];
+            error += residual * residual;
+        }
+
+        if (error < best_error)
+        {
+            best_error = error;
+            best_position = position;
+            best_gain = gain;
+        }
+    }
+
+    const double tone = std::clamp(best_gain * peak, 0.0, 1.0);
+    amplitude = (float) ((20.0 * std::log10(tone + 1e-4) + 80.0) / 80.0);
+
+    return best_position;
+}
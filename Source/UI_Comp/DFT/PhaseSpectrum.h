@@ -0,0 +1,112 @@
+#pragma once
+
+// The phase the amplitudes throw away, as a second plane for the
+// spectrogram ("sg_phase"): the phase of L against R per bin, or its slope
+// over frequency, the delay of R behind L per bin (the group delay of the
+// channel difference). Both come from the spectra the worker already has,
+// nothing runs while the plane is off.
+// Free of any juce dependency.
+//
+// The bins' arguments go through fastAtan2, a polynomial over contiguous
+// arrays, about 1e-5 rad off. The loops vectorize without -ffast-math:
+// quadrants and wraps are picked by arithmetic on the sign and magnitude
+// bits rather than float compares, which the compiler may not speculate.
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+enum PhaseView
+{
+    PhaseOff,
+    PhaseDifference,
+    PhaseGroupDelay,
+    NumPhaseViews
+};
+
+// the group delays mapped to the plane, the spectrogram clips beyond it.
+#define PHASE_GROUP_DELAY_RANGE_MS 2.0
+
+inline uint32_t floatBits(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// atan2 without branches, the same result for every input sign.
+inline float fastAtan2(float y, float x)
+{
+    const float pi = 3.14159265358979f;
+
+    // positive floats order like their bits.
+    const uint32_t bits_x = floatBits(x), bits_y = floatBits(y);
+    const float steep = (float) ((bits_y & 0x7fffffffu) > (bits_x & 0x7fffffffu));
+    const float left  = (float) (bits_x >> 31);
+
+    const float ax = std::fabs(x), ay = std::fabs(y);
+    // the smaller over the larger magnitude. Only a zero larger one is
+    // guarded, an offset would bend the ratio of tiny ones.
+    const float a = (ay + steep * (ax - ay)) / std::max(ax + steep * (ay - ax), FLT_MIN);
+    const float s = a * a;
+
+    float r = ((((0.0208351f * s - 0.085133f) * s + 0.180141f) * s - 0.3302995f) * s + 0.999866f) * a;
+    r += steep * (0.5f * pi - 2.0f * r);
+    r += left * (pi - 2.0f * r);
+    return std::copysign(r, y);
+}
+
+// one frame of ordered pffft output of both channels of `fft_size` points
+// into fft_size / 2 + 1 values in `output`: the phase of L R* from -pi to
+// pi as 0 to 1, or the group delay at `sample_rate` with
+// -PHASE_GROUP_DELAY_RANGE_MS to PHASE_GROUP_DELAY_RANGE_MS as 0 to 1.
+// 0.5 is none for both.
+// `scratch` holds as many values.
+inline void computePhasePlane(const float* left, const float* right, int fft_size, PhaseView view,
+                              float sample_rate, float* scratch, float* output)
+{
+    const float pi = 3.14159265358979f;
+    const int num_bins = fft_size / 2 + 1;
+
+    // real and imaginary part of L R*, DC and nyquist are real.
+    output[0] = left[0] * right[0];
+    scratch[0] = 0.0f;
+    output[num_bins - 1] = left[1] * right[1];
+    scratch[num_bins - 1] = 0.0f;
+
+    for (int bin = 1; bin < num_bins - 1; ++bin)
+    {
+        const float l_re = left[2 * bin], l_im = left[2 * bin + 1];
+        const float r_re = right[2 * bin], r_im = right[2 * bin + 1];
+
+        output[bin]  = l_re * r_re + l_im * r_im;
+        scratch[bin] = l_im * r_re - l_re * r_im;
+    }
+
+    for (int bin = 0; bin < num_bins; ++bin)
+        output[bin] = fastAtan2(scratch[bin], output[bin]);
+
+    if (view == PhaseGroupDelay)
+    {
+        // a delay of d samples turns the phase by 2 pi d / fft_size per bin.
+        const float to_plane = (float) (fft_size / (2.0 * pi) * 1000.0 / sample_rate
+                                        / (2.0 * PHASE_GROUP_DELAY_RANGE_MS));
+
+        for (int bin = 0; bin < num_bins - 1; ++bin)
+        {
+            // from -2 pi to 2 pi, the turns rounded away by truncating a positive value.
+            const float step = output[bin + 1] - output[bin];
+            const float turns = (float) (int) (step * (0.5f / pi) + 1.5f) - 1.0f;
+
+            output[bin] = 0.5f + (step - turns * 2.0f * pi) * to_plane;
+        }
+
+        output[num_bins - 1] = output[num_bins - 2];
+        return;
+    }
+
+    for (int bin = 0; bin < num_bins; ++bin)
+        output[bin] = 0.5f + output[bin] * (0.5f / pi);
+}
@@ -0,0 +1,274 @@
+#include "SharedAnalysisEngine.h"
+
+#include <algorithm>
+#include <bit>
+#include <thread>
+
+// one core is left to the audio and message threads.
+static size_t sharedWorkerCount()
+{
+    const int cores = (int) std::thread::hardware_concurrency();
+    return (size_t) std::clamp(cores - 1, 1, SHARED_MAX_WORKERS);
+}
+
+SharedAnalysisEngine::SharedAnalysisEngine()
+    :   num_workers((int) sharedWorkerCount()),
+        pool((size_t) num_workers)
+{
+    // the pool's threads stay in these loops until the engine goes.
+    for (int worker = 0; worker < num_workers; ++worker)
+        pool.submit_work([this, worker] { workerLoop(worker); });
+}
+
+SharedAnalysisEngine::~SharedAnalysisEngine()
+{
+    stopping.store(true);
+
+    for (int worker = 0; worker < num_workers; ++worker)
+        wake[worker].signal();
+
+    // the pool joins the loops as it goes.
+}
+
+std::shared_ptr<SharedAnalysisEngine> SharedAnalysisEngine::getInstance()
+{
+    static std::mutex instance_mutex;
+    static std::weak_ptr<SharedAnalysisEngine> instance;
+
+    std::lock_guard<std::mutex> lock(instance_mutex);
+
+    std::shared_ptr<SharedAnalysisEngine> engine = instance.lock();
+    if (!engine)
+    {
+        engine = std::shared_ptr<SharedAnalysisEngine>(new SharedAnalysisEngine());
+        instance = engine;
+    }
+
+    return engine;
+}
+
+WorkerFFTBuffers& SharedAnalysisEngine::getWorkerBuffers()
+{
+    thread_local WorkerFFTBuffers buffers;
+    return buffers;
+}
+
+void SharedAnalysisEngine::attach(Client* client)
+{
+    std::lock_guard<std::mutex> lock(slots_mutex);
+
+    for (int slot = 0; slot < SHARED_MAX_CLIENTS; ++slot)
+    {
+        if (slots[slot].load() != nullptr)
+            continue;
+
+        client->slot = slot;
+        slots[slot].store(client);
+
+        if (slot >= num_slots.load())
+            num_slots.store(slot + 1);
+
+        // it may have been given tasks already.
+        if (client->isRunnable())
+            wakeWorker();
+
+        return;
+    }
+}
+
+void SharedAnalysisEngine::detach(Client* client)
+{
+    if (client->slot < 0)
+        return;
+
+    // the slot stays taken until its last user is out.
+    std::lock_guard<std::mutex> lock(slots_mutex);
+
+    slots[client->slot].store(nullptr);
+
+    while (slot_users[client->slot].load() > 0)
+        std::this_thread::yield();
+
+    client->slot = -1;
+}
+
+template <typename Visit>
+bool SharedAnalysisEngine::visitClients(int first, Visit&& visit)
+{
+    const int count = num_slots.load();
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int slot = (first + i) % count;
+
+        // a cheap look first, most slots are empty.
+        if (slots[slot].load(std::memory_order_relaxed) == nullptr)
+            continue;
+
+        slot_users[slot].fetch_add(1);
+
+        Client* client = slots[slot].load();
+        const bool done = client != nullptr && visit(client);
+
+        slot_users[slot].fetch_sub(1);
+
+        if (done)
+            return true;
+    }
+
+    return false;
+}
+
+bool SharedAnalysisEngine::runOneQueued()
+{
+    const int count = num_slots.load();
+    if (count == 0)
+        return false;
+
+    const int first = (int) (next_slot.fetch_add(1, std::memory_order_relaxed) % (unsigned) count);
+
+    return visitClients(first, [] (Client* client) { return client->tryRun(); });
+}
+
+bool SharedAnalysisEngine::anyRunnable()
+{
+    return visitClients(0, [] (Client* client) { return client->isRunnable(); });
+}
+
+void SharedAnalysisEngine::workerLoop(int worker)
+{
+    const uint32_t bit = 1u << worker;
+
+    while (!stopping.load())
+    {
+        if (runOneQueued())
+            continue;
+
+        // announced before the last look, a task queued after it sees the bit.
+        sleeping.fetch_or(bit);
+
+        if (anyRunnable() || stopping.load())
+        {
+            sleeping.fetch_and(~bit);
+            continue;
+        }
+
+        wake[worker].wait();
+    }
+}
+
+void SharedAnalysisEngine::wakeWorker()
+{
+    uint32_t asleep = sleeping.load();
+
+    while (asleep != 0)
+    {
+        const int worker = std::countr_zero(asleep);
+
+        if (sleeping.compare_exchange_weak(asleep, asleep & ~(1u << worker)))
+        {
+            wake[worker].signal();
+            return;
+        }
+    }
+}
+
+SharedAnalysisEngine::Client::Client(std::shared_ptr<SharedAnalysisEngine> shared_engine)
+    :   engine(std::move(shared_engine))
+{
+}
+
+SharedAnalysisEngine::Client::~Client()
+{
+    // the last client stops the workers here, detach already ran.
+    engine.reset();
+}
+
+void SharedAnalysisEngine::Client::taskQueued()
+{
+    pending.fetch_add(1, std::memory_order_relaxed);
+
+    // counted before looking for a sleeper, see workerLoop.
+    queued.fetch_add(1);
+    engine->wakeWorker();
+}
+
+void SharedAnalysisEngine::Client::detach()
+{
+    engine->detach(this);
+}
+
+bool SharedAnalysisEngine::Client::isRunnable() const
+{
+    return queued.load() > 0 && running.load() < SHARED_CLIENT_MAX_RUNNING;
+}
+
+bool SharedAnalysisEngine::Client::tryRun()
+{
+    if (queued.load() <= 0)
+        return false;
+
+    int now_running = running.load();
+    do
+    {
+        if (now_running >= SHARED_CLIENT_MAX_RUNNING)
+            return false;
+    }
+    while (!running.compare_exchange_weak(now_running, now_running + 1));
+
+    // one worker pops at a time, the queue has a single consumer.
+    bool ran = false;
+    if (!consuming.exchange(true, std::memory_order_acquire))
+    {
+        queued.fetch_sub(1);
+        ran = runNext();
+
+        // counted out of the queue before it was seen empty, put back.
+        if (!ran)
+            queued.fetch_add(1);
+    }
+
+    running.fetch_sub(1);
+
+    if (ran)
+        pending.fetch_sub(1, std::memory_order_release);
+
+    return ran;
+}
+
+std::shared_ptr<const FFTTables> SharedAnalysisEngine::Client::getTables(int fft_order, AnalysisWindowType window,
+                                                                          float kaiser_beta, int zero_pad_bits)
+{
+    fft_order = std::clamp(fft_order, SHARED_MIN_ORDER, SHARED_MAX_ORDER);
+    if (window != WindowKaiser) kaiser_beta = 0.0f;
+
+    const int padded_order = std::clamp(fft_order + zero_pad_bits, fft_order, FFT_MAX_PADDED_ORDER);
+
+    std::lock_guard<std::mutex> lock(engine->tables_mutex);
+
+    auto tables = std::make_shared<FFTTables>();
+
+    auto& plan = engine->plans[padded_order - SHARED_MIN_ORDER];
+    tables->plan = plan.lock();
+    if (!tables->plan)
+    {
+        tables->plan = std::make_shared<const FFTPlan>(padded_order);
+        plan = tables->plan;
+    }
+
+    auto& windows = engine->windows;
+
+    // the ones nobody holds anymore.
+    for (auto it = windows.begin(); it != windows.end(); )
+        it = it->second.expired() ? windows.erase(it) : std::next(it);
+
+    auto& table = windows[{ fft_order, (int) window, kaiser_beta }];
+    tables->window = table.lock();
+    if (!tables->window)
+    {
+        tables->window = std::make_shared<const WindowTable>(1 << fft_order, window, kaiser_beta);
+        table = tables->window;
+    }
+
+    return tables;
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+// What every PFFFT in the process shares, whatever number of plugin
+// instances the host loads: one worker pool sized to the cores instead of
+// two threads per instance, and one PFFFT setup per FFT order (padded
+// ones included) and one table per window, alive only while an instance
+// holds them.
+//
+// Each instance submits through its own Client, a fixed size single
+// producer queue its audio thread pushes to without a lock or an
+// allocation. The workers serve the clients in turn, so a busy instance
+// cannot starve a quiet one, and run at most SHARED_CLIENT_MAX_RUNNING
+// batches of one instance at once. They find work by polling the clients'
+// atomic counts and sleep on a semaphore of their own when there is none,
+// a submission wakes one of them.
+//
+// Free of any juce dependency.
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "../../../pfft/pffft.h"
+#include "../../../rwqueue/readerwriterqueue.h"
+#include "FFTTables.h"
+#include "workerpool.h"
+
+#define SHARED_MAX_WORKERS 8
+#define SHARED_CLIENT_MAX_RUNNING 2
+// instances served at once, the ones beyond never get their tasks run.
+#define SHARED_MAX_CLIENTS 256
+// batches an instance may have queued, a full queue drops the next ones.
+#define SHARED_CLIENT_QUEUE_SIZE 64
+#define SHARED_MIN_ORDER 9
+#define SHARED_MAX_ORDER 13
+
+// aligned FFT scratch, one per worker thread so pffft_transform_ordered
+// never shares memory across threads. `output` and `output_right` hold the
+// spectra of both channels of a frame, `mix` the ones derived from them,
+// `output_reference` the sidechain's in transfer mode.
+struct WorkerFFTBuffers {
+    float* input        = (float*)pffft_aligned_malloc(sizeof(float) * 8192);
+    float* work         = (float*)pffft_aligned_malloc(sizeof(float) * 8192);
+    float* output       = (float*)pffft_aligned_malloc(sizeof(float) * 8192);
+    float* output_right = (float*)pffft_aligned_malloc(sizeof(float) * 8192);
+    float* mix          = (float*)pffft_aligned_malloc(sizeof(float) * 8192);
+    float* output_reference = (float*)pffft_aligned_malloc(sizeof(float) * 8192);
+    int    size         = 8192;
+
+    WorkerFFTBuffers() = default;
+
+    // grown for the zero padded transforms the first time one comes.
+    void reserve(int fft_size) {
+        if (fft_size <= size) return;
+
+        release();
+
+        input        = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+        work         = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+        output       = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+        output_right = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+        mix          = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+        output_reference = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+        size         = fft_size;
+    }
+
+    // not copyable — these are raw heap allocations
+    WorkerFFTBuffers(const WorkerFFTBuffers&)            = delete;
+    WorkerFFTBuffers& operator=(const WorkerFFTBuffers&) = delete;
+
+    ~WorkerFFTBuffers() { release(); }
+
+private:
+    void release() {
+        pffft_aligned_free(input);
+        pffft_aligned_free(work);
+        pffft_aligned_free(output);
+        pffft_aligned_free(output_right);
+        pffft_aligned_free(mix);
+        pffft_aligned_free(output_reference);
+    }
+};
+
+class SharedAnalysisEngine
+{
+public:
+
+    // an instance's queue into the shared workers, see TaskClient for the
+    // queue itself. Destroying it drops what is still queued and waits for
+    // its running tasks, so everything they touch can go right after.
+    class Client
+    {
+    public:
+        virtual ~Client();
+
+        Client(const Client&)            = delete;
+        Client& operator=(const Client&) = delete;
+
+        // queued and running, at any time. Once 0, whatever the finished
+        // tasks read may go.
+        int getPending() const { return pending.load(std::memory_order_acquire); }
+
+        // the window of `fft_order` (SHARED_MIN_ORDER - SHARED_MAX_ORDER) and
+        // the setup of that order plus `zero_pad_bits` (FFT_MAX_PADDED_ORDER
+        // at most), each built by the first instance that asks for it.
+        // `kaiser_beta` only matters to WindowKaiser.
+        // Allocates, not for the audio thread.
+        std::shared_ptr<const FFTTables> getTables(int fft_order, AnalysisWindowType window,
+                                                   float kaiser_beta = WINDOW_DEFAULT_KAISER_BETA,
+                                                   int zero_pad_bits = 0);
+
+    protected:
+
+        explicit Client(std::shared_ptr<SharedAnalysisEngine> shared_engine);
+
+        // the producer's, after a push: counts the task and wakes a worker.
+        void taskQueued();
+
+        // off the workers' list, returns once none of them is in this
+        // client anymore. The derived destructor calls it before its queue goes.
+        void detach();
+
+        // a worker's, under the consumer flag: pops the next task, clears
+        // `consuming` and runs it. False when the queue was empty.
+        virtual bool runNext() = 0;
+
+        std::atomic<bool> consuming { false };
+
+    private:
+        friend class SharedAnalysisEngine;
+
+        // a worker's, one task if the running limit and the consumer flag let it.
+        bool tryRun();
+
+        // a worker may start one of its tasks.
+        bool isRunnable() const;
+
+        std::shared_ptr<SharedAnalysisEngine> engine;
+        int slot = -1;
+
+        std::atomic<int> queued  { 0 };
+        std::atomic<int> running { 0 };
+        std::atomic<int> pending { 0 };
+    };
+
+    // the queue of one instance, moved `Task`s run by `run` on the workers.
+    template <typename Task>
+    class TaskClient : public Client
+    {
+    public:
+        ~TaskClient() override { detach(); }
+
+        // the instance's audio thread, the only producer. Neither locks nor
+        // allocates, false (and `task` untouched) when the queue is full.
+        bool submit(Task&& task)
+        {
+            if (!queue.try_enqueue(std::move(task)))
+                return false;
+
+            taskQueued();
+            return true;
+        }
+
+    private:
+        friend class SharedAnalysisEngine;
+
+        TaskClient(std::shared_ptr<SharedAnalysisEngine> shared_engine, std::function<void(Task&)> run_task)
+            : Client(std::move(shared_engine)),
+              queue(SHARED_CLIENT_QUEUE_SIZE),
+              run(std::move(run_task))
+        {
+        }
+
+        bool runNext() override
+        {
+            Task task;
+            const bool popped = queue.try_dequeue(task);
+            consuming.store(false, std::memory_order_release);
+
+            if (popped)
+                run(task);
+
+            return popped;
+        }
+
+        moodycamel::ReaderWriterQueue<Task> queue;
+        std::function<void(Task&)> run;
+    };
+
+    // starts the engine with the first client, stops it with the last one.
+    // `run_task` is called on a worker for every submitted task.
+    // Allocates, not for the audio thread.
+    template <typename Task>
+    static std::unique_ptr<TaskClient<Task>> connect(std::function<void(Task&)> run_task)
+    {
+        std::unique_ptr<TaskClient<Task>> client(new TaskClient<Task>(getInstance(), std::move(run_task)));
+
+        // only once it is whole, a worker may call into it from here on.
+        client->engine->attach(client.get());
+        return client;
+    }
+
+    // scratch of the calling worker thread.
+    static WorkerFFTBuffers& getWorkerBuffers();
+
+    ~SharedAnalysisEngine();
+
+private:
+
+    SharedAnalysisEngine();
+
+    static std::shared_ptr<SharedAnalysisEngine> getInstance();
+
+    void attach(Client* client);
+    void detach(Client* client);
+
+    // a worker's life: runs the clients' tasks, sleeps while there are none.
+    void workerLoop(int worker);
+
+    // one task of the next client in round robin that may run one, false
+    // when none could.
+    bool runOneQueued();
+    bool anyRunnable();
+
+    // wakes one sleeping worker, if any, without locking.
+    void wakeWorker();
+
+    // `visit(client)` for every attached client, the slot is held meanwhile
+    // so its client cannot go. Stops at the first visit that returns true.
+    template <typename Visit>
+    bool visitClients(int first, Visit&& visit);
+
+    // written under slots_mutex, read by the workers without it. A worker
+    // counts itself into the slot's users before reading the pointer, a
+    // client that leaves clears it and waits for the users to be gone.
+    std::mutex slots_mutex;
+    std::array<std::atomic<Client*>, SHARED_MAX_CLIENTS> slots {};
+    std::array<std::atomic<int>, SHARED_MAX_CLIENTS> slot_users {};
+    std::atomic<int> num_slots { 0 };
+    std::atomic<unsigned> next_slot { 0 };
+
+    int num_workers = 1;
+    std::atomic<bool> stopping { false };
+    // a bit per worker that is going to sleep or sleeps on its semaphore.
+    std::atomic<uint32_t> sleeping { 0 };
+    std::array<moodycamel::spsc_sema::LightweightSemaphore, SHARED_MAX_WORKERS> wake;
+
+    std::mutex tables_mutex;
+    std::array<std::weak_ptr<const FFTPlan>, FFT_MAX_PADDED_ORDER - SHARED_MIN_ORDER + 1> plans;
+    // by order, type and beta.
+    std::map<std::tuple<int, int, float>, std::weak_ptr<const WindowTable>> windows;
+
+    // declared last, runs the worker loops and joins them before the rest goes.
+    VoidVoidWorkerPool pool;
+};
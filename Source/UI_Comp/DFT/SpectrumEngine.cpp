@@ -0,0 +1,65 @@
+#include "SpectrumEngine.h"
+
+#include <cmath>
+#include <cstring>
+
+SpectrumEngine::SpectrumEngine(int fft_order, int hop, AnalysisWindowType window_type, float kaiser_beta)
+    :   fft_size(1 << fft_order),
+        hop_size(std::max(hop, 1)),
+        plan(fft_order),
+        window(1 << fft_order, window_type, kaiser_beta)
+{
+    input  = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+    work   = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+    output = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+
+    history.resize(2 * fft_size);
+    amplitudes.resize(getNumBins());
+
+    reset();
+}
+
+SpectrumEngine::~SpectrumEngine()
+{
+    pffft_aligned_free(input);
+    pffft_aligned_free(work);
+    pffft_aligned_free(output);
+}
+
+void SpectrumEngine::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+    write_pos = 0;
+    filled = 0;
+    since_frame = 0;
+}
+
+void SpectrumEngine::transformFrame(const float* frame)
+{
+    for (int i = 0; i < fft_size; ++i)
+        input[i] = frame[i] * window.data[i];
+
+    pffft_transform_ordered(plan.setup, input, output, work, PFFFT_FORWARD);
+
+    amplitudesFromFFT(output, amplitudes.data(), fft_size, window.amplitude_scale);
+}
+
+void SpectrumEngine::amplitudesFromFFT(const float* fft, float* output, int fft_size, float amplitude_scale)
+{
+    int num_bins = (fft_size / 2) + 1;
+    // DC and Nyquist have no negative frequency twin.
+    output[0] = std::abs(fft[0]) * amplitude_scale * 0.5f;
+    output[num_bins - 1] = std::abs(fft[1]) * amplitude_scale * 0.5f;
+    for (int bin = 1; bin < num_bins - 1; ++bin) {
+        float real = fft[2 * bin];
+        float imag = fft[2 * bin + 1];
+        output[bin] = std::sqrt(real * real + imag * imag) * amplitude_scale;
+    }
+
+    for (int bin = 0; bin < num_bins; ++bin) {
+        float amplitude = std::clamp<float>(output[bin], 0.0, 1.0);
+        float db = 20.0f * log10f(amplitude + 1e-4f);
+        // [-80, 0] dB -> [0, 1], the same map the plugin's jmap did.
+        output[bin] = (db + 80.0f) / 80.0f;
+    }
+}
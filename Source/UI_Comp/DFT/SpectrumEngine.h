@@ -0,0 +1,80 @@
+#pragma once
+
+// Framing, windowing and the FFT of one channel, turned into the
+// normalised amplitudes the spectrogram and the analyser draw.
+// Free of any GUI (and juce) dependency, so the offline command line tool
+// produces exactly what the plugin shows.
+
+#include <vector>
+
+#include "../../../pfft/pffft.h"
+#include "../util.h"
+#include "FFTTables.h"
+
+class SpectrumEngine
+{
+public:
+
+    // 2^fft_order point real FFT, a frame every `hop_size` samples.
+    SpectrumEngine(int fft_order, int hop_size = HOP_SIZE, AnalysisWindowType window_type = WindowHann,
+                   float kaiser_beta = WINDOW_DEFAULT_KAISER_BETA);
+    ~SpectrumEngine();
+
+    SpectrumEngine(const SpectrumEngine&)            = delete;
+    SpectrumEngine& operator=(const SpectrumEngine&) = delete;
+
+    int getFFTSize() const { return fft_size; }
+    int getNumBins() const { return fft_size / 2 + 1; }
+    int getHopSize() const { return hop_size; }
+
+    void reset();
+
+    // `on_frame(const float* amplitudes, int num_bins)` is called for every
+    // complete frame, the first one once `fft_size` samples went in.
+    template <typename OnFrame>
+    void process(const float* x, int num, OnFrame&& on_frame)
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            // written twice so the last `fft_size` samples are always contiguous.
+            history[write_pos] = x[i];
+            history[write_pos + fft_size] = x[i];
+            if (++write_pos == fft_size) write_pos = 0;
+
+            if (filled < fft_size) ++filled;
+
+            if (++since_frame >= hop_size && filled == fft_size)
+            {
+                since_frame = 0;
+                transformFrame(history.data() + write_pos);
+                on_frame(amplitudes.data(), getNumBins());
+            }
+        }
+    }
+
+    // ordered pffft output of `fft_size` points -> amplitudes of its bins,
+    // mapped from [-80, 0] dB to [0, 1]. `amplitude_scale` is the window's,
+    // see WindowTable, a full scale tone reads 0 dB.
+    static void amplitudesFromFFT(const float* fft, float* output, int fft_size, float amplitude_scale);
+
+private:
+
+    void transformFrame(const float* frame);
+
+    int fft_size;
+    int hop_size;
+
+    FFTPlan plan;
+    WindowTable window;
+
+    float* input  = nullptr;
+    float* work   = nullptr;
+    float* output = nullptr;
+
+    std::vector<float> history;
+    std::vector<float> amplitudes;
+
+    int write_pos = 0;
+    int filled = 0;
+    int since_frame = 0;
+};
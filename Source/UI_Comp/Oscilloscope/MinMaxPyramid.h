@@ -0,0 +1,347 @@
+#pragma once
+
+// Streaming multi-resolution min/max/sum-of-squares history of one channel.
+// Deliberately free of any juce dependency so it can be used (and tested) offline.
+//
+// Level 0 holds buckets of `PYRAMID_BASE_BUCKET` samples, every level above
+// aggregates `PYRAMID_FACTOR` buckets of the level below. Each level is a ring
+// of `PYRAMID_LEVEL_CAPACITY` buckets, so coarse levels reach much further back
+// in time than fine ones. The last `PYRAMID_RAW_CAPACITY` raw samples are kept
+// as well for views that are zoomed in below the base bucket size.
+//
+// Bucket boundaries are absolute sample positions (bucket i of level k covers
+// samples [i * size_k, (i + 1) * size_k)), so a column built from them never
+// shifts around when new data comes in.
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+#define PYRAMID_BASE_BUCKET 16
+#define PYRAMID_FACTOR 4
+// buckets of 16, 64, 256, 1024, 4096 and 16384 samples.
+#define PYRAMID_LEVELS 6
+// a level is only ever picked when its bucket size is <= the samples per column
+// and the next level's is not, 4 * 2000 columns therefore always fit.
+#define PYRAMID_LEVEL_CAPACITY 8192
+#define PYRAMID_RAW_CAPACITY 65536
+
+struct MinMaxBucket
+{
+    // an empty bucket has min > max, the oscilloscope shader draws nothing for it.
+    float min   =  std::numeric_limits<float>::max();
+    float max   = -std::numeric_limits<float>::max();
+    float sumsq = 0.0f;
+    // samples that went into it, for the mean square.
+    uint32_t count = 0;
+
+    bool isEmpty() const { return min > max; }
+
+    float rms() const { return count > 0 ? std::sqrt(sumsq / (float) count) : 0.0f; }
+
+    void merge(const MinMaxBucket& other)
+    {
+        min    = std::min(min, other.min);
+        max    = std::max(max, other.max);
+        sumsq += other.sumsq;
+        count += other.count;
+    }
+};
+
+// min, max and sum of squares of `n` samples in a single pass.
+// Written with independent lanes so the compiler turns the main loop into
+// packed min/max/fma instructions (SSE/AVX/NEON) without intrinsics.
+inline MinMaxBucket reduceSpan(const float* x, int n)
+{
+    constexpr int LANES = 8;
+
+    float mn[LANES], mx[LANES], sq[LANES];
+    for (int j = 0; j < LANES; ++j)
+    {
+        mn[j] =  std::numeric_limits<float>::max();
+        mx[j] = -std::numeric_limits<float>::max();
+        sq[j] = 0.0f;
+    }
+
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (int j = 0; j < LANES; ++j)
+        {
+            const float v = x[i + j];
+            mn[j] = v < mn[j] ? v : mn[j];
+            mx[j] = v > mx[j] ? v : mx[j];
+            sq[j] += v * v;
+        }
+    }
+
+    MinMaxBucket out;
+    for (int j = 0; j < LANES; ++j)
+    {
+        out.min = std::min(out.min, mn[j]);
+        out.max = std::max(out.max, mx[j]);
+        out.sumsq += sq[j];
+    }
+
+    for (; i < n; ++i)
+    {
+        const float v = x[i];
+        out.min = std::min(out.min, v);
+        out.max = std::max(out.max, v);
+        out.sumsq += v * v;
+    }
+
+    out.count = (uint32_t) n;
+    return out;
+}
+
+// index i of the last rising crossing (x[i] < level <= x[i + 1]) in x[0, n), -1 if there is none.
+// Scans backwards in blocks of lanes, a block is only inspected sample by sample
+// once the branch free (vectorizable) test says it contains a crossing.
+inline int findLastRisingEdge(const float* x, int n, float level)
+{
+    constexpr int LANES = 8;
+
+    int i = n - 1; // pairs (i - 1, i) are tested, going down.
+
+    while (i - LANES >= 0)
+    {
+        const float* lo = x + i - LANES;
+
+        int hit = 0;
+        for (int j = 0; j < LANES; ++j)
+            hit |= (int)(lo[j] < level) & (int)(lo[j + 1] >= level);
+
+        if (hit)
+        {
+            for (int j = LANES - 1; j >= 0; --j)
+                if (lo[j] < level && lo[j + 1] >= level)
+                    return (int)(lo - x) + j;
+        }
+
+        i -= LANES;
+    }
+
+    for (; i >= 1; --i)
+        if (x[i - 1] < level && x[i] >= level)
+            return i - 1;
+
+    return -1;
+}
+
+class MinMaxPyramid
+{
+public:
+
+    MinMaxPyramid()
+        : raw(PYRAMID_RAW_CAPACITY, 0.0f)
+    {
+        for (auto& level : levels)
+            level.resize(PYRAMID_LEVEL_CAPACITY);
+
+        clear();
+    }
+
+    void clear()
+    {
+        total_samples = 0;
+
+        for (int k = 0; k < PYRAMID_LEVELS; ++k)
+        {
+            level_count[k] = 0;
+            partial[k] = MinMaxBucket();
+            partial_count[k] = 0;
+        }
+    }
+
+    // appends `n` samples, amortised O(1) per sample.
+    void push(const float* x, int n)
+    {
+        int pos = 0;
+
+        while (pos < n)
+        {
+            // raw ring, in contiguous pieces.
+            const int raw_pos = (int)(total_samples % PYRAMID_RAW_CAPACITY);
+
+            // fill the base bucket up to its boundary, never across it.
+            int span = std::min(n - pos, PYRAMID_BASE_BUCKET - partial_count[0]);
+            span = std::min(span, PYRAMID_RAW_CAPACITY - raw_pos);
+
+            std::copy(x + pos, x + pos + span, raw.begin() + raw_pos);
+
+            partial[0].merge(reduceSpan(x + pos, span));
+            partial_count[0] += span;
+
+            total_samples += (uint64_t)span;
+            pos += span;
+
+            if (partial_count[0] == PYRAMID_BASE_BUCKET)
+                commit(0);
+        }
+    }
+
+    uint64_t getTotalSamples() const { return total_samples; }
+
+    static int64_t bucketSize(int level)
+    {
+        int64_t size = PYRAMID_BASE_BUCKET;
+        for (int k = 0; k < level; ++k) size *= PYRAMID_FACTOR;
+        return size;
+    }
+
+    // -1 means raw samples, otherwise the coarsest level whose bucket still fits in a column.
+    static int levelForSamplesPerColumn(double samples_per_column)
+    {
+        if (samples_per_column < (double)PYRAMID_BASE_BUCKET)
+            return -1;
+
+        int level = 0;
+        while (level + 1 < PYRAMID_LEVELS && (double)bucketSize(level + 1) <= samples_per_column)
+            ++level;
+
+        return level;
+    }
+
+    // aggregate of the samples in [begin, end) using the given level.
+    // A bucket is counted for the range its first sample falls in, so adjacent
+    // ranges never share a bucket. Samples that are not (or no longer)
+    // available are simply skipped.
+    MinMaxBucket query(int64_t begin, int64_t end, int level) const
+    {
+        MinMaxBucket out;
+
+        if (end <= begin)
+            return out;
+
+        if (level < 0)
+        {
+            const int64_t first = std::max<int64_t>(begin, (int64_t)total_samples - PYRAMID_RAW_CAPACITY);
+            const int64_t last  = std::min<int64_t>(end, (int64_t)total_samples);
+
+            for (int64_t i = std::max<int64_t>(first, 0); i < last; ++i)
+            {
+                const float v = raw[(size_t)(i % PYRAMID_RAW_CAPACITY)];
+                out.min = std::min(out.min, v);
+                out.max = std::max(out.max, v);
+                out.sumsq += v * v;
+                out.count += 1;
+            }
+
+            return out;
+        }
+
+        const int64_t size  = bucketSize(level);
+        const int64_t count = (int64_t)level_count[level];
+
+        int64_t first = (begin + size - 1) / size;
+        int64_t last  = (end   + size - 1) / size;
+
+        // range narrower than a bucket, use the one it lies in.
+        if (last <= first)
+        {
+            first = begin / size;
+            last  = first + 1;
+        }
+
+        first = std::max<int64_t>(first, count - PYRAMID_LEVEL_CAPACITY);
+        first = std::max<int64_t>(first, 0);
+        last  = std::min<int64_t>(last, count);
+
+        const auto& ring = levels[level];
+        for (int64_t i = first; i < last; ++i)
+            out.merge(ring[(size_t)(i % PYRAMID_LEVEL_CAPACITY)]);
+
+        return out;
+    }
+
+    // the raw sample at an absolute position, 0 if it is not available.
+    float sampleAt(int64_t position) const
+    {
+        if (position < 0
+            || position >= (int64_t)total_samples
+            || position < (int64_t)total_samples - PYRAMID_RAW_CAPACITY)
+            return 0.0f;
+
+        return raw[(size_t)(position % PYRAMID_RAW_CAPACITY)];
+    }
+
+    // absolute position p of the last rising crossing (raw[p] < level <= raw[p + 1])
+    // with begin <= p and p + 1 < end, -1 if there is none in the raw history.
+    int64_t findLastRisingEdge(int64_t begin, int64_t end, float level) const
+    {
+        begin = std::max<int64_t>(begin, (int64_t)total_samples - PYRAMID_RAW_CAPACITY);
+        begin = std::max<int64_t>(begin, 0);
+        end   = std::min<int64_t>(end, (int64_t)total_samples);
+
+        if (end - begin < 2)
+            return -1;
+
+        // the range is at most two contiguous pieces of the ring, newest first.
+        const int64_t wrap = ((end - 1) / PYRAMID_RAW_CAPACITY) * PYRAMID_RAW_CAPACITY;
+        const int64_t split = std::max(begin, wrap);
+
+        if (end - split >= 2)
+        {
+            const int found = ::findLastRisingEdge(raw.data() + (split % PYRAMID_RAW_CAPACITY),
+                                                   (int)(end - split), level);
+            if (found >= 0)
+                return split + found;
+        }
+
+        if (split > begin)
+        {
+            // the pair straddling the wrap point.
+            if (end > split && raw[(size_t)((split - 1) % PYRAMID_RAW_CAPACITY)] < level
+                            && raw[(size_t)(split % PYRAMID_RAW_CAPACITY)] >= level)
+                return split - 1;
+
+            const int found = ::findLastRisingEdge(raw.data() + (begin % PYRAMID_RAW_CAPACITY),
+                                                   (int)(split - begin), level);
+            if (found >= 0)
+                return begin + found;
+        }
+
+        return -1;
+    }
+
+private:
+
+    // pushes the finished partial bucket of `level` into its ring and up the pyramid.
+    void commit(int level)
+    {
+        for (int k = level; k < PYRAMID_LEVELS; ++k)
+        {
+            const MinMaxBucket done = partial[k];
+
+            levels[k][(size_t)(level_count[k] % PYRAMID_LEVEL_CAPACITY)] = done;
+            ++level_count[k];
+
+            partial[k] = MinMaxBucket();
+            partial_count[k] = 0;
+
+            if (k + 1 >= PYRAMID_LEVELS)
+                break;
+
+            partial[k + 1].merge(done);
+            partial_count[k + 1] += 1;
+
+            if (partial_count[k + 1] < PYRAMID_FACTOR)
+                break;
+        }
+    }
+
+    std::vector<float> raw;
+    std::vector<MinMaxBucket> levels[PYRAMID_LEVELS];
+
+    uint64_t level_count[PYRAMID_LEVELS] = {};
+
+    // bucket under construction per level, counted in samples for level 0
+    // and in buckets of the level below for the rest.
+    MinMaxBucket partial[PYRAMID_LEVELS];
+    int partial_count[PYRAMID_LEVELS] = {};
+
+    uint64_t total_samples = 0;
+};
@@ -1,15 +1,18 @@
 #include "Oscilloscope.h"
 
-OscilloscopeComponent::OscilloscopeComponent(AudioProcessorValueTreeState& apvts_reference)
-    : apvts_ref(apvts_reference)
+OscilloscopeComponent::OscilloscopeComponent(AudioProcessorValueTreeState& apvts_reference, PerfCounters* perf_counters)
+    : apvts_ref(apvts_reference),
+      perf(perf_counters)
 {
     setOpaque(true);
+    resetBeatColumns(0);
 
     apvts_ref.addParameterListener("gb_vw_mde", this);
     apvts_ref.addParameterListener("gb_chnl", this);
     apvts_ref.addParameterListener("gb_fft_ord", this);
     apvts_ref.addParameterListener("sp_measure", this);
     apvts_ref.addParameterListener("sp_multiple", this);
+    apvts_ref.addParameterListener("os_trig", this);
 
     opengl_context.setOpenGLVersionRequired(OpenGLContext::OpenGLVersion::openGL3_2);
     opengl_context.setRenderer(this);
@@ -30,28 +33,78 @@ OscilloscopeComponent::~OscilloscopeComponent()
     apvts_ref.removeParameterListener("gb_fft_ord", this);
     apvts_ref.removeParameterListener("sp_measure", this);
     apvts_ref.removeParameterListener("sp_multiple", this);
+    apvts_ref.removeParameterListener("os_trig", this);
 
     opengl_context.detach();
 }
 
 void OscilloscopeComponent::timerCallback()
 {
-    if (trigger_repaint && new_data_flag)
-        opengl_context.triggerRepaint();
+    PerfScope timer_scope(perf, PerfTimerCallback);
+
+    bool cleared = clear_requested.exchange(false);
+
+    if (cleared)
+        resetColumns();
+
+    bool reduced = drainAudioFifo();
+    bool rebuild = rebuild_requested.exchange(false);
+
+    if (cleared || reduced || rebuild)
+    {
+        rebuildColumns();
+        publishSnapshot();
+
+        if (trigger_repaint)
+            opengl_context.triggerRepaint();
+    }
 }
 
 void OscilloscopeComponent::parameterChanged(const String& parameterID, float)
 {
-    new_data_flag = true;
-    clearData();
+    // the history is kept at every resolution, so changing how much of it
+    // is shown (or how) only needs the columns to be rebuilt.
+    if (parameterID == "gb_chnl")
+    {
+        clearData();
+    }
+    else if (parameterID.isEmpty())
+    {
+        // the transport (re)started, the triggered modes lock onto
+        // the history instead of accumulating it again.
+        if ((int) apvts_ref.getRawParameterValue("os_trig")->load() == 0)
+            clearData();
+        else
+            rebuild_requested.store(true);
+    }
+    else
+    {
+        rebuild_requested.store(true);
+    }
+}
+
+void OscilloscopeComponent::setResolutionDivider(int divider)
+{
+    const int columns = OSC_MAX_WIDTH / jmax(1, divider);
+
+    if (max_columns.exchange(columns) != columns)
+        rebuild_requested.store(true);
 }
 
 void OscilloscopeComponent::clearData()
 {
-    writeIndex.store(0);
-    accumulator = 0.0;
-    validColumnsInData.store(1);
-    totalSamplesWritten = 0;
+    // can be called from the audio thread (on play), the columns are
+    // owned by the timer so it does the actual clearing.
+    clear_requested.store(true);
+}
+
+void OscilloscopeComponent::resetColumns()
+{
+    writeIndex = 0;
+    validColumnsInData = 1;
+
+    pyramid[0].clear();
+    pyramid[1].clear();
 
     for (int c = 0; c < OSC_MAX_WIDTH; ++c)
     {
@@ -62,129 +115,423 @@ void OscilloscopeComponent::clearData()
 
         oscSample[0][c] = 0.0f;
         oscSample[1][c] = 0.0f;
+
+        oscRms[0][c] = 0.0f;
+        oscRms[1][c] = 0.0f;
     }
 
-    new_data_flag = true;
+    resetBeatColumns(beat_columns);
+}
 
-    if (trigger_repaint)
-        opengl_context.triggerRepaint();
+void OscilloscopeComponent::resetBeatColumns(int numColumns)
+{
+    beat_columns = numColumns;
+    beat_last_column = -1;
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int c = 0; c < OSC_MAX_WIDTH; ++c)
+        {
+            beatColumn[ch][c] = MinMaxBucket();
+            beatSample[ch][c] = 0.0f;
+        }
+    }
 }
 
 void OscilloscopeComponent::newAudioBatch(const float* left, const float* right, int numSamples,
-                                         float bpm, float sample_rate, int N)
+                                         float bpm, float sample_rate, int N, int D,
+                                         double ppq, bool ppq_valid)
 {
-    static const float measureTable[] = {
-        1.0f / 4.0f,
-        1.0f / 3.0f,
-        1.0f / 7.0f,
-        1.0f / 5.0f
+    if (numSamples <= 0)
+        return;
+
+    if (block_fifo.getFreeSpace() < 1
+        || sample_fifo.getFreeSpace() < numSamples)
+    {
+        if (perf) perf->add(PerfScopeBlocksDropped);
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    sample_fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    auto copyChannel = [&](float* dest, const float* src)
+    {
+        if (src)
+        {
+            FloatVectorOperations::copy(dest + start1, src, size1);
+            if (size2 > 0) FloatVectorOperations::copy(dest + start2, src + size1, size2);
+        }
+        else
+        {
+            FloatVectorOperations::clear(dest + start1, size1);
+            if (size2 > 0) FloatVectorOperations::clear(dest + start2, size2);
+        }
     };
 
-    float osc_measure  = apvts_ref.getRawParameterValue("sp_measure")->load();
-    float osc_multiple = apvts_ref.getRawParameterValue("sp_multiple")->load();
+    copyChannel(sample_fifo_data[0], left);
+    copyChannel(sample_fifo_data[1], right);
 
-    float barsPerWindow   = measureTable[(int) osc_measure] * osc_multiple;
-    float secondsPerBar   = (60.0f / bpm) * N;
-    float historySeconds  = barsPerWindow * secondsPerBar;
+    sample_fifo.finishedWrite(size1 + size2);
+
+    block_fifo.prepareToWrite(1, start1, size1, start2, size2);
+    block_fifo_data[start1] = { numSamples, bpm, sample_rate, N, jmax(1, D), ppq, ppq_valid };
+    block_fifo.finishedWrite(1);
+}
+
+bool OscilloscopeComponent::drainAudioFifo()
+{
+    bool reduced_any = false;
+
+    while (block_fifo.getNumReady() > 0)
+    {
+        int start1, size1, start2, size2;
+
+        block_fifo.prepareToRead(1, start1, size1, start2, size2);
+        const BlockInfo info = block_fifo_data[start1];
+        block_fifo.finishedRead(1);
+
+        for (int done = 0; done < info.numSamples; )
+        {
+            const int n = std::min(OSC_SCRATCH_SIZE, info.numSamples - done);
 
-    float totalSamplesForHistory = historySeconds * sample_rate;
+            sample_fifo.prepareToRead(n, start1, size1, start2, size2);
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                FloatVectorOperations::copy(fifo_scratch[ch], sample_fifo_data[ch] + start1, size1);
+                if (size2 > 0)
+                    FloatVectorOperations::copy(fifo_scratch[ch] + size1, sample_fifo_data[ch] + start2, size2);
+            }
 
-    int numColumnsNeeded = jlimit(1, OSC_MAX_WIDTH, (int)totalSamplesForHistory);
-    validColumnsInData.store(numColumnsNeeded, std::memory_order_relaxed);
+            sample_fifo.finishedRead(size1 + size2);
 
-    float samples_per_column = totalSamplesForHistory / (float) numColumnsNeeded;
+            BlockInfo piece = info;
+            piece.numSamples = size1 + size2;
+            piece.ppq = info.ppq + (double) done * info.bpm / (60.0 * info.sample_rate);
 
-    bool zoomedIn = (samples_per_column <= 25.0f);
-    renderMode.store(zoomedIn ? 1 : 0, std::memory_order_relaxed);
+            reduceBlock(fifo_scratch[0], fifo_scratch[1], piece);
 
+            done += n;
+        }
+
+        reduced_any = true;
+    }
+
+    return reduced_any;
+}
+
+void OscilloscopeComponent::reduceBlock(const float* left, const float* right, const BlockInfo& info)
+{
     int mode = (int) apvts_ref.getRawParameterValue("gb_chnl")->load();
 
-    for (int id = 0; id < numSamples; ++id)
+    // L+R shows both channels, every other mode collapses into channel 0.
+    const int numChannels = (mode == 0) ? 2 : 1;
+    const int numSamples = info.numSamples;
+
+    const double ppqPerSample = (double) info.bpm / (60.0 * (double) info.sample_rate);
+
+    // the block is processed in pieces that fit the scratch buffers,
+    // the clamping and the channel selection happen once per piece.
+    for (int offset = 0; offset < numSamples; offset += OSC_SCRATCH_SIZE)
     {
-        float L = left  ? left[id]  : 0.0f;
-        float R = right ? right[id] : 0.0f;
+        const int n = std::min(OSC_SCRATCH_SIZE, numSamples - offset);
 
-        L = jlimit(-1.0f, 1.0f, L);
-        R = jlimit(-1.0f, 1.0f, R);
+        prepareChannels(left  ? left  + offset : nullptr,
+                        right ? right + offset : nullptr,
+                        n, mode);
 
-        int wi = writeIndex.load(std::memory_order_relaxed);
+        for (int ch = 0; ch < numChannels; ++ch)
+            pyramid[ch].push(channel_scratch[ch], n);
 
-        if (zoomedIn)
+        // kept up to date while the transport runs, whatever the trigger mode,
+        // so switching to it shows the last pass right away.
+        if (info.ppq_valid)
         {
-            if (mode == 0)
-            {
-                oscSample[0][wi] = L;
-                oscSample[1][wi] = R;
-            }
-            else if (mode == 1)
+            BlockInfo piece = info;
+            piece.ppq = info.ppq + (double) offset * ppqPerSample;
+
+            reduceBeatLocked(n, numChannels, piece);
+        }
+    }
+
+    last_block = info;
+}
+
+void OscilloscopeComponent::reduceBeatLocked(int numSamples, int numChannels, const BlockInfo& info)
+{
+    // in quarter notes like the ppq, a bar is N beats of a 1/D note.
+    const double windowBeats  = (double) getBarsPerWindow() * info.N * 4.0 / info.D;
+    const double ppqPerSample = (double) info.bpm / (60.0 * (double) info.sample_rate);
+
+    if (windowBeats <= 0.0 || ppqPerSample <= 0.0)
+        return;
+
+    const double windowSamples = windowBeats / ppqPerSample;
+    const int columns = jlimit(1, max_columns.load(), (int) windowSamples);
+
+    // a different window (or tempo) maps the columns to other positions.
+    if (columns != beat_columns || windowBeats != beat_window)
+    {
+        resetBeatColumns(columns);
+        beat_window = windowBeats;
+    }
+
+    beat_zoomed = (windowSamples / (double) columns) <= 25.0;
+
+    double ppq = info.ppq;
+
+    // the piece is split where the transport crosses into the next column,
+    // each span is reduced in one go.
+    for (int pos = 0; pos < numSamples; )
+    {
+        const double lap    = std::floor(ppq / windowBeats);
+        const double phase  = ppq / windowBeats - lap;
+        const int    column = jlimit(0, columns - 1, (int) (phase * columns));
+
+        const double boundary = (lap + (double) (column + 1) / (double) columns) * windowBeats;
+        const int span = jlimit(1, numSamples - pos, (int) std::ceil((boundary - ppq) / ppqPerSample));
+
+        // entering a column (after a jump, or on the next pass) overwrites it.
+        if (column != beat_last_column || lap != beat_last_lap)
+        {
+            for (int ch = 0; ch < 2; ++ch)
             {
-                oscSample[0][wi] = L;
+                beatColumn[ch][column] = MinMaxBucket();
+                beatSample[ch][column] = 0.0f;
             }
-            else if (mode == 2)
+
+            beat_last_column = column;
+            beat_last_lap = lap;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* src = channel_scratch[ch] + pos;
+
+            if (beat_zoomed)
             {
-                oscSample[0][wi] = R;
+                beatSample[ch][column] = src[span - 1];
+                beatColumn[ch][column] = reduceSpan(src + span - 1, 1);
             }
             else
             {
-                float S = jlimit(-1.0f, 1.0f, L - R);
-                oscSample[0][wi] = S;
+                beatColumn[ch][column].merge(reduceSpan(src, span));
             }
-
-            // keep min/max consistent
-            oscMin[0][wi] = oscMax[0][wi] = oscSample[0][wi];
-            oscMin[1][wi] = oscMax[1][wi] = oscSample[1][wi];
         }
-        else
-        {
-            if (mode == 0)
-            {
-                oscMin[0][wi] = std::min(oscMin[0][wi], L);
-                oscMax[0][wi] = std::max(oscMax[0][wi], L);
 
-                oscMin[1][wi] = std::min(oscMin[1][wi], R);
-                oscMax[1][wi] = std::max(oscMax[1][wi], R);
-            }
-            else if (mode == 1)
+        pos += span;
+        ppq += (double) span * ppqPerSample;
+    }
+}
+
+float OscilloscopeComponent::getBarsPerWindow() const
+{
+    static const float measureTable[] = {
+        1.0f / 4.0f,
+        1.0f / 3.0f,
+        1.0f / 7.0f,
+        1.0f / 5.0f
+    };
+
+    float osc_measure  = apvts_ref.getRawParameterValue("sp_measure")->load();
+    float osc_multiple = apvts_ref.getRawParameterValue("sp_multiple")->load();
+
+    return measureTable[(int) osc_measure] * osc_multiple;
+}
+
+void OscilloscopeComponent::rebuildColumns()
+{
+    SR = last_block.sample_rate;
+
+    const int trigger = (int) apvts_ref.getRawParameterValue("os_trig")->load();
+
+    if (trigger == 1)
+    {
+        copyBeatColumns();
+        return;
+    }
+
+    float barsPerWindow   = getBarsPerWindow();
+    float secondsPerBar   = (60.0f / last_block.bpm) * last_block.N * 4.0f / last_block.D;
+    float historySeconds  = barsPerWindow * secondsPerBar;
+
+    double totalSamplesForHistory = (double) historySeconds * last_block.sample_rate;
+
+    int numColumnsNeeded = jlimit(1, max_columns.load(), (int)totalSamplesForHistory);
+    validColumnsInData = numColumnsNeeded;
+
+    double samples_per_column = jmax(1.0, totalSamplesForHistory / (double) numColumnsNeeded);
+
+    bool zoomedIn = (samples_per_column <= 25.0);
+    renderMode = zoomedIn ? 1 : 0;
+
+    const int level = MinMaxPyramid::levelForSamplesPerColumn(samples_per_column);
+
+    const int64_t total = (int64_t) pyramid[0].getTotalSamples();
+
+    auto fillColumn = [&](int slot, int64_t begin, int64_t end)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            if (begin < 0)
             {
-                oscMin[0][wi] = std::min(oscMin[0][wi], L);
-                oscMax[0][wi] = std::max(oscMax[0][wi], L);
+                oscMin[ch][slot] = oscMax[ch][slot] = oscSample[ch][slot] = oscRms[ch][slot] = 0.0f;
+                continue;
             }
-            else if (mode == 2)
+
+            if (zoomedIn)
             {
-                oscMin[0][wi] = std::min(oscMin[0][wi], R);
-                oscMax[0][wi] = std::max(oscMax[0][wi], R);
+                // one column holds (less than) a handful of samples, the latest one wins.
+                oscSample[ch][slot] = pyramid[ch].sampleAt(jmin(end, total) - 1);
+                oscMin[ch][slot] = oscMax[ch][slot] = oscSample[ch][slot];
+                oscRms[ch][slot] = std::abs(oscSample[ch][slot]);
             }
             else
             {
-                float S = jlimit(-1.0f, 1.0f, L - R);
-                oscMin[0][wi] = std::min(oscMin[0][wi], S);
-                oscMax[0][wi] = std::max(oscMax[0][wi], S);
+                const MinMaxBucket bucket = pyramid[ch].query(begin, end, level);
+
+                oscMin[ch][slot]    = bucket.min;
+                oscMax[ch][slot]    = bucket.max;
+                oscRms[ch][slot]    = bucket.rms();
+                oscSample[ch][slot] = 0.0f;
             }
         }
+    };
+
+    const int64_t origin = (trigger == 2)
+        ? findEdgeTrigger((int64_t) std::ceil(totalSamplesForHistory))
+        : -1;
+
+    if (origin >= 0)
+    {
+        // triggered, the window starts at the crossing and does not scroll.
+        for (int i = 0; i < numColumnsNeeded; ++i)
+            fillColumn(i,
+                       origin + (int64_t) std::floor((double) i * samples_per_column),
+                       origin + (int64_t) std::floor((double) (i + 1) * samples_per_column));
+
+        writeIndex = 0;
+        return;
+    }
+
+    // columns live on an absolute grid, column `a` covers samples
+    // [a * samples_per_column, (a + 1) * samples_per_column), the one
+    // holding the newest sample is still being filled.
+    const int64_t current = (int64_t) std::floor((double) total / samples_per_column);
+
+    for (int i = 0; i < numColumnsNeeded; ++i)
+    {
+        const int64_t column = current - numColumnsNeeded + 1 + i;
+        const int slot = (int) (((column % numColumnsNeeded) + numColumnsNeeded) % numColumnsNeeded);
 
-        accumulator += 1.0;
+        if (column < 0)
+            fillColumn(slot, -1, -1);
+        else
+            fillColumn(slot,
+                       (int64_t) std::floor((double) column * samples_per_column),
+                       (int64_t) std::floor((double) (column + 1) * samples_per_column));
+    }
+
+    // the scrolling view starts right after the newest column, i.e. at the oldest one.
+    writeIndex = (int) ((current + 1) % numColumnsNeeded);
+}
+
+void OscilloscopeComponent::copyBeatColumns()
+{
+    const int numColumns = jmax(1, beat_columns);
 
-        if (accumulator >= samples_per_column)
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int c = 0; c < numColumns; ++c)
         {
-            accumulator -= samples_per_column;
+            oscMin[ch][c] = beatColumn[ch][c].min;
+            oscMax[ch][c] = beatColumn[ch][c].max;
+            oscRms[ch][c] = beatColumn[ch][c].rms();
+        }
+
+        std::copy(beatSample[ch], beatSample[ch] + numColumns, oscSample[ch]);
+    }
+
+    // column 0 is always the start of the window, nothing scrolls.
+    validColumnsInData = numColumns;
+    renderMode = beat_zoomed ? 1 : 0;
+    writeIndex = 0;
+}
+
+int64_t OscilloscopeComponent::findEdgeTrigger(int64_t windowLength) const
+{
+    const int64_t total = (int64_t) pyramid[0].getTotalSamples();
+
+    // the crossing has to be in the raw history and the whole window after it
+    // already there, so the picture does not grow while it is shown.
+    const int64_t latest = total - windowLength - 1;
 
-            int maxCols = validColumnsInData.load(std::memory_order_relaxed);
-            int next = (wi + 1) % maxCols;
+    if (latest < 0 || windowLength + 1 >= PYRAMID_RAW_CAPACITY)
+        return -1;
 
-            oscMin[0][next] =  0.0f;
-            oscMax[0][next] =  0.0f;
-            oscMin[1][next] =  0.0f;
-            oscMax[1][next] =  0.0f;
+    const int64_t earliest = latest - jmax<int64_t>(windowLength, OSC_EDGE_SEARCH);
+    const int64_t found = pyramid[0].findLastRisingEdge(earliest, latest + 2, 0.0f);
 
-            oscSample[0][next] = 0.0f;
-            oscSample[1][next] = 0.0f;
+    return found >= 0 ? found + 1 : -1;
+}
 
-            writeIndex.store(next, std::memory_order_relaxed);
+void OscilloscopeComponent::publishSnapshot()
+{
+    Snapshot& snap = snapshots[snapshot_back];
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int c = 0; c < OSC_MAX_WIDTH; ++c)
+        {
+            snap.data[ch][4*c + 0] = oscMin[ch][c];
+            snap.data[ch][4*c + 1] = oscMax[ch][c];
+            snap.data[ch][4*c + 2] = oscSample[ch][c];
+            snap.data[ch][4*c + 3] = oscRms[ch][c];
         }
     }
 
-    SR.store(sample_rate, std::memory_order_relaxed);
-    new_data_flag = true;
+    snap.writeIndex   = writeIndex;
+    snap.validColumns = validColumnsInData;
+    snap.renderMode   = renderMode;
+
+    const SpinLock::ScopedLockType lock(snapshot_lock);
+    std::swap(snapshot_back, snapshot_middle);
+    snapshot_fresh = true;
+}
+
+void OscilloscopeComponent::prepareChannels(const float* left, const float* right, int numSamples, int mode)
+{
+    float* ch0 = channel_scratch[0];
+    float* ch1 = channel_scratch[1];
+
+    auto clipInto = [numSamples](float* dest, const float* src)
+    {
+        if (src) FloatVectorOperations::clip(dest, src, -1.0f, 1.0f, numSamples);
+        else     FloatVectorOperations::clear(dest, numSamples);
+    };
+
+    if (mode == 0)
+    {
+        clipInto(ch0, left);
+        clipInto(ch1, right);
+    }
+    else if (mode == 1)
+    {
+        clipInto(ch0, left);
+    }
+    else if (mode == 2)
+    {
+        clipInto(ch0, right);
+    }
+    else
+    {
+        // S = clip(clip(L) - clip(R)), channel 1 is only used as a temporary here.
+        clipInto(ch0, left);
+        clipInto(ch1, right);
+        FloatVectorOperations::subtract(ch0, ch1, numSamples);
+        FloatVectorOperations::clip(ch0, ch0, -1.0f, 1.0f, numSamples);
+    }
 }
 
 void OscilloscopeComponent::uploadColourMap()
@@ -236,21 +583,10 @@ void OscilloscopeComponent::newOpenGLContextCreated()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    float initData[2][OSC_MAX_WIDTH * 3];
-    for (int c = 0; c < OSC_MAX_WIDTH; ++c)
-    {
-        initData[0][3*c + 0] = oscMin[0][c];
-        initData[0][3*c + 1] = oscMax[0][c];
-        initData[0][3*c + 2] = oscSample[0][c];
-
-        initData[1][3*c + 0] = oscMin[1][c];
-        initData[1][3*c + 1] = oscMax[1][c];
-        initData[1][3*c + 2] = oscSample[1][c];
-    }
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F,
+    // the front snapshot is only ever touched by the GL thread.
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F,
                  OSC_MAX_WIDTH, 2,
-                 0, GL_RGB, GL_FLOAT, initData);
+                 0, GL_RGBA, GL_FLOAT, snapshots[snapshot_front].data);
 
     // colourmap texture 1D
     glGenTextures(1, &colourMapTexture);
@@ -281,10 +617,26 @@ void OscilloscopeComponent::renderOpenGL()
 
     using namespace juce::gl;
 
+    PerfScope render_scope(perf, PerfGLRender);
+    size_t uploaded = 0;
+
     OpenGLHelpers::clear(Colours::black);
 
     int fft_ord = (int) apvts_ref.getRawParameterValue("gb_fft_ord")->load();
 
+    bool upload = false;
+    {
+        const SpinLock::ScopedLockType lock(snapshot_lock);
+        if (snapshot_fresh)
+        {
+            std::swap(snapshot_front, snapshot_middle);
+            snapshot_fresh = false;
+            upload = true;
+        }
+    }
+
+    const Snapshot& snap = snapshots[snapshot_front];
+
     const float renderingScale = (float) opengl_context.getRenderingScale();
     glViewport(0, 0,
                roundToInt(renderingScale * getWidth()),
@@ -305,15 +657,13 @@ void OscilloscopeComponent::renderOpenGL()
         shader_uniforms->colourMapTex->set(1);
 
     if (shader_uniforms->startIndex)
-        shader_uniforms->startIndex->set(writeIndex.load());
-
-    // std::cout << "Oscilloscope : " << writeIndex.load() << " ";
+        shader_uniforms->startIndex->set(snap.writeIndex);
 
     if (shader_uniforms->numIndex)
         shader_uniforms->numIndex->set(OSC_MAX_WIDTH);
 
     if (shader_uniforms->validColumns)
-        shader_uniforms->validColumns->set(validColumnsInData.load());
+        shader_uniforms->validColumns->set(snap.validColumns);
 
     int scroll_mode = (apvts_ref.getRawParameterValue("gb_vw_mde")->load() > 0.5f) ? 0 : 1;
     if (shader_uniforms->scroll)
@@ -332,38 +682,25 @@ void OscilloscopeComponent::renderOpenGL()
         shader_uniforms->thickness->set(th);
 
     if (shader_uniforms->renderMode)
-        shader_uniforms->renderMode->set(renderMode.load(std::memory_order_relaxed));
+        shader_uniforms->renderMode->set(snap.renderMode);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, dataTexture);
 
-    if (new_data_flag)
+    if (upload)
     {
-        static float uploadData[2][OSC_MAX_WIDTH * 3];
-
-        for (int c = 0; c < OSC_MAX_WIDTH; ++c)
-        {
-            uploadData[0][3*c + 0] = oscMin[0][c];
-            uploadData[0][3*c + 1] = oscMax[0][c];
-            uploadData[0][3*c + 2] = oscSample[0][c];
-
-            uploadData[1][3*c + 0] = oscMin[1][c];
-            uploadData[1][3*c + 1] = oscMax[1][c];
-            uploadData[1][3*c + 2] = oscSample[1][c];
-        }
-
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
                         OSC_MAX_WIDTH, 2,
-                        GL_RGB, GL_FLOAT, uploadData);
-
-        new_data_flag = false;
+                        GL_RGBA, GL_FLOAT, snap.data);
+        uploaded += sizeof(snap.data);
     }
 
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_1D, colourMapTexture);
 
     uploadColourMap();
+    uploaded += sizeof(float) * 3 * COLOUR_MAP_NUM_COLOURS;
 
     GLfloat verts[] = { 1,1,  1,-1,  -1,-1,  -1,1 };
     GLuint inds[]   = { 0,1,3,  1,2,3 };
@@ -375,10 +712,13 @@ void OscilloscopeComponent::renderOpenGL()
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(inds), inds, GL_STREAM_DRAW);
+    uploaded += sizeof(verts) + sizeof(inds);
 
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
 
     glDisableVertexAttribArray(0);
+
+    if (perf) perf->record(PerfGLUpload, uploaded);
 }
 
 void OscilloscopeComponent::openGLContextClosing()
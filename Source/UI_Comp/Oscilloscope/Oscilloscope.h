@@ -7,11 +7,21 @@
 
 #include "../../ColourMaps.h"
 #include "../util.h"
+#include "MinMaxPyramid.h"
+#include "../../ds/PerfCounters.h"
 
 using namespace juce;
 
 #define OSC_FPS 60
 #define OSC_MAX_WIDTH 2000
+// audio blocks are reduced in pieces of at most this many samples.
+#define OSC_SCRATCH_SIZE 1024
+// raw stereo samples buffered between the audio thread and the timer,
+// ~0.34s at 192kHz, the timer drains it every 1/OSC_FPS seconds.
+#define OSC_FIFO_SIZE 65536
+#define OSC_FIFO_BLOCKS 512
+// the edge trigger looks this far back (at least) for a rising zero crossing.
+#define OSC_EDGE_SEARCH 4096
 
 class OscilloscopeComponent
     : public Component,
@@ -20,17 +30,28 @@ class OscilloscopeComponent
       private AudioProcessorValueTreeState::Listener
 {
 public:
-    OscilloscopeComponent(AudioProcessorValueTreeState& apvts_reference);
+    OscilloscopeComponent(AudioProcessorValueTreeState& apvts_reference, PerfCounters* perf_counters = nullptr);
     ~OscilloscopeComponent() override;
 
+    // ====================== AUDIO THREAD ========================
+    // only copies the block into the fifo, the reduction happens in the timerCallback.
+    // blocks that do not fit (the message thread is stalled) are dropped.
+    // `ppq` is the host position of the first sample, used by the beat trigger
+    // only when `ppq_valid` (the transport is running).
     void newAudioBatch(const float* left, const float* right, int numSamples,
-                       float bpm, float sample_rate, int N);
+                       float bpm, float sample_rate, int N, int D,
+                       double ppq = 0.0, bool ppq_valid = false);
+    // ============================================================
 
     void timerCallback() override;
     void parameterChanged(const String& parameterID, float newValue) override;
 
+    // thread safe, the columns are cleared on the next timer tick.
     void clearData();
 
+    // at most OSC_MAX_WIDTH / divider columns, rebuilt on the next timer tick.
+    void setResolutionDivider(int divider);
+
     void newOpenGLContextCreated() override;
     void renderOpenGL() override;
     void openGLContextClosing() override;
@@ -40,27 +61,111 @@ public:
 
 private:
     AudioProcessorValueTreeState& apvts_ref;
+    PerfCounters* perf;
 
-    std::atomic<bool> new_data_flag { false };
     std::atomic<bool> trigger_repaint { false };
     std::atomic<bool> colourmap_dirty { true };
 
     OpenGLContext opengl_context;
 
-    std::atomic<int> writeIndex { 0 };
-    std::atomic<int> validColumnsInData { OSC_MAX_WIDTH };
+    // ── audio thread -> timer ────────────────────────────────────────────────
+    // sample data and the per block metadata travel through two fifos,
+    // samples are always committed before the block that describes them.
+    struct BlockInfo
+    {
+        int   numSamples  = 0;
+        float bpm         = 120.0f;
+        float sample_rate = 44100.0f;
+        int   N           = 4;
+        int   D           = 4;
+        double ppq        = 0.0;
+        bool  ppq_valid   = false;
+    };
+
+    AbstractFifo sample_fifo { OSC_FIFO_SIZE };
+    float        sample_fifo_data[2][OSC_FIFO_SIZE] = {};
+
+    AbstractFifo block_fifo { OSC_FIFO_BLOCKS };
+    BlockInfo    block_fifo_data[OSC_FIFO_BLOCKS];
+
+    // set from any thread, the timer clears the history before the next reduction.
+    std::atomic<bool> clear_requested { true };
+    // set from any thread, the columns are rebuilt from the history on the next tick.
+    std::atomic<bool> rebuild_requested { false };
+    // most columns shown, lowered by the quality governor.
+    std::atomic<int> max_columns { OSC_MAX_WIDTH };
+
+    // ── timer thread only ────────────────────────────────────────────────────
+    // long multi-resolution history per displayed channel, the columns
+    // below are only a view of it for the present history window.
+    MinMaxPyramid pyramid[2];
+    BlockInfo last_block;
+
+    // slot of the oldest column, where the scrolling view starts.
+    int writeIndex = 0;
+    int validColumnsInData = OSC_MAX_WIDTH;
 
     int getDelayColumns() const;
+    float getBarsPerWindow() const;
 
-    uint64_t totalSamplesWritten = 0;
-    double accumulator = 0.0;
-    std::atomic<float> SR { 44100.0f };
+    float SR = 44100.0f;
 
     float oscMin[2][OSC_MAX_WIDTH] = {};
     float oscMax[2][OSC_MAX_WIDTH] = {};
+    // root mean square of the column, from the sum of squares gathered
+    // in the same pass as min/max.
+    float oscRms[2][OSC_MAX_WIDTH] = {};
 
     float oscSample[2][OSC_MAX_WIDTH] = {};
-    std::atomic<int> renderMode { 0 };
+    int renderMode = 0;
+
+    // clamped, channel-selected copy of the incoming audio.
+    float channel_scratch[2][OSC_SCRATCH_SIZE] = {};
+    // raw samples read back out of the fifo.
+    float fifo_scratch[2][OSC_SCRATCH_SIZE] = {};
+
+    // beat trigger: every column is a fixed musical position inside the window,
+    // written in place as the transport passes over it. Jumps only change
+    // which column is written next, nothing is ever re-accumulated.
+    MinMaxBucket beatColumn[2][OSC_MAX_WIDTH];
+    float beatSample[2][OSC_MAX_WIDTH] = {};
+    int beat_columns = 0;
+    int beat_last_column = -1;
+    double beat_last_lap = 0.0;
+    double beat_window = 0.0;
+    bool beat_zoomed = false;
+
+    void resetBeatColumns(int numColumns);
+    void reduceBeatLocked(int numSamples, int numChannels, const BlockInfo& info);
+
+    void resetColumns();
+    bool drainAudioFifo();
+    void reduceBlock(const float* left, const float* right, const BlockInfo& info);
+    void rebuildColumns();
+    void copyBeatColumns();
+    // start of the window for the edge trigger, -1 if there is no crossing to lock to.
+    int64_t findEdgeTrigger(int64_t windowLength) const;
+    void prepareChannels(const float* left, const float* right, int numSamples, int mode);
+
+    // ── timer -> GL thread ───────────────────────────────────────────────────
+    // packed (min, max, sample, rms) columns, exactly what is uploaded to the texture.
+    // triple buffered: the timer fills `back`, swaps it with `middle`,
+    // the GL thread swaps `middle` into `front` when something new was published.
+    // The lock only guards the index swaps, never the copies.
+    struct Snapshot
+    {
+        float data[2][OSC_MAX_WIDTH * 4] = {};
+        int   writeIndex   = 0;
+        int   validColumns = 1;
+        int   renderMode   = 0;
+    };
+
+    Snapshot snapshots[3];
+    int snapshot_back = 0, snapshot_middle = 1, snapshot_front = 2;
+    bool snapshot_fresh = false;
+    SpinLock snapshot_lock;
+
+    void publishSnapshot();
 
     void createShaders();
     void uploadColourMap();
@@ -119,11 +224,18 @@ private:
         uniform float thickness;
         uniform int renderMode;
 
+        const float flatlineAmpThreshold = 0.01;
+
         vec3 fetchMinMaxS(int c, int chan)
         {
             return texelFetch(imageData, ivec2(c, chan), 0).rgb;
         }
 
+        float fetchRms(int c, int chan)
+        {
+            return texelFetch(imageData, ivec2(c, chan), 0).a;
+        }
+
         float drawSegment(float y0, float y1, float y, float th)
         {
             float lo = min(y0, y1);
@@ -134,6 +246,27 @@ private:
             return max(inside, max(edge0, edge1));
         }
 
+        // dimmed min..max envelope with the rms core on top, coloured by the
+        // crest factor: 0dB (square, squashed) at the top of the map, 20dB and up at the bottom.
+        vec3 shadeEnvelope(float mn, float mx, float rms, float yLocal, float th)
+        {
+            float peak = max(abs(mn), abs(mx));
+
+            if (peak < flatlineAmpThreshold)
+                return texture(colourMapTex, flatlineAmpThreshold).rgb * drawSegment(0.5, 0.5, yLocal, th);
+
+            float envelope = drawSegment(0.5 + 0.5 * mn, 0.5 + 0.5 * mx, yLocal, th);
+
+            float lo = max(mn, -rms);
+            float hi = min(mx,  rms);
+            float core = drawSegment(0.5 + 0.5 * lo, 0.5 + 0.5 * hi, yLocal, th);
+
+            float crestDb = 20.0 * log(peak / max(rms, 1e-6)) / log(10.0);
+            vec3 colour = texture(colourMapTex, clamp(1.0 - crestDb / 20.0, 0.0, 1.0)).rgb;
+
+            return colour * max(0.35 * envelope, core);
+        }
+
         void main()
         {
             vec2 uv = gl_FragCoord.xy / resolution.xy;
@@ -152,7 +285,6 @@ private:
             float y  = uv.y;
 
             vec3 outCol = bg;
-            const float flatlineAmpThreshold = 0.01;
 
             bool showBoth = (mode == 0);
 
@@ -178,18 +310,12 @@ private:
 
                 vec3 mms = fetchMinMaxS(col, chan);
                 float mn = mms.r, mx = mms.g, s = mms.b;
-                if (mn > mx) { mn = 0.0; mx = 0.0; s = 0.0; }
-
-                float intensity = 0.0;
-                float amp = 0.0;
+                float rms = fetchRms(col, chan);
+                if (mn > mx) { mn = 0.0; mx = 0.0; s = 0.0; rms = 0.0; }
 
                 if (renderMode == 0)
                 {
-                    amp = max(abs(mn), abs(mx));
-                    float y0 = 0.5, y1 = 0.5;
-                    if (amp >= flatlineAmpThreshold) { y0 = 0.5 + 0.5 * mn; y1 = 0.5 + 0.5 * mx; }
-                    else amp = flatlineAmpThreshold;
-                    intensity = drawSegment(y0, y1, yLocal, th);
+                    outCol += shadeEnvelope(mn, mx, rms, yLocal, th);
                 }
                 else
                 {
@@ -199,14 +325,12 @@ private:
                     float y0 = 0.5 + 0.5 * s;
                     float y1 = 0.5 + 0.5 * s2;
 
-                    amp = max(abs(s), abs(s2));
+                    float amp = max(abs(s), abs(s2));
                     if (amp < flatlineAmpThreshold) amp = flatlineAmpThreshold;
 
-                    intensity = drawSegment(y0, y1, yLocal, th);
+                    vec3 colour = texture(colourMapTex, clamp(amp, 0.0, 1.0)).rgb;
+                    outCol += colour * drawSegment(y0, y1, yLocal, th);
                 }
-
-                vec3 colour = texture(colourMapTex, clamp(amp, 0.0, 1.0)).rgb;
-                outCol += colour * intensity;
             }
             else
             {
@@ -224,18 +348,12 @@ private:
 
                 vec3 mms = fetchMinMaxS(col, 0);
                 float mn = mms.r, mx = mms.g, s = mms.b;
-                if (mn > mx) { mn = 0.0; mx = 0.0; s = 0.0; }
-
-                float intensity = 0.0;
-                float amp = 0.0;
+                float rms = fetchRms(col, 0);
+                if (mn > mx) { mn = 0.0; mx = 0.0; s = 0.0; rms = 0.0; }
 
                 if (renderMode == 0)
                 {
-                    amp = max(abs(mn), abs(mx));
-                    float y0 = 0.5, y1 = 0.5;
-                    if (amp >= flatlineAmpThreshold) { y0 = 0.5 + 0.5 * mn; y1 = 0.5 + 0.5 * mx; }
-                    else amp = flatlineAmpThreshold;
-                    intensity = drawSegment(y0, y1, yLocal, th);
+                    outCol += shadeEnvelope(mn, mx, rms, yLocal, th);
                 }
                 else
                 {
@@ -245,14 +363,12 @@ private:
                     float y0 = 0.5 + 0.5 * s;
                     float y1 = 0.5 + 0.5 * s2;
 
-                    amp = max(abs(s), abs(s2));
+                    float amp = max(abs(s), abs(s2));
                     if (amp < flatlineAmpThreshold) amp = flatlineAmpThreshold;
 
-                    intensity = drawSegment(y0, y1, yLocal, th);
+                    vec3 colour = texture(colourMapTex, clamp(amp, 0.0, 1.0)).rgb;
+                    outCol += colour * drawSegment(y0, y1, yLocal, th);
                 }
-
-                vec3 colour = texture(colourMapTex, clamp(amp, 0.0, 1.0)).rgb;
-                outCol += colour * intensity;
             }
 
             gl_FragColor = vec4(outCol, 1.0);
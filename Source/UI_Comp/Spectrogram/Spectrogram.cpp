@@ -4,16 +4,19 @@
 #include <cmath>
 
 SpectrogramComponent::SpectrogramComponent(
-    AudioProcessorValueTreeState& apvts_reference)
-    : apvts_ref(apvts_reference)
+    AudioProcessorValueTreeState& apvts_reference, PerfCounters* perf_counters)
+    : apvts_ref(apvts_reference),
+      perf(perf_counters)
 {
     // if there is a change in the amount of history to be stored,
     // clear the existing data.
     apvts_ref.addParameterListener("gb_vw_mde", this);
     apvts_ref.addParameterListener("gb_chnl", this);
     apvts_ref.addParameterListener("gb_fft_ord", this);
+    apvts_ref.addParameterListener("gb_zero_pad", this);
     apvts_ref.addParameterListener("sp_measure", this);
     apvts_ref.addParameterListener("sp_multiple", this);
+    apvts_ref.addParameterListener("sg_phase", this);
 
     setOpaque(true);
 
@@ -38,14 +41,18 @@ SpectrogramComponent::~SpectrogramComponent()
     apvts_ref.removeParameterListener("gb_vw_mde", this);
     apvts_ref.removeParameterListener("gb_chnl", this);
     apvts_ref.removeParameterListener("gb_fft_ord", this);
+    apvts_ref.removeParameterListener("gb_zero_pad", this);
     apvts_ref.removeParameterListener("sp_measure", this);
     apvts_ref.removeParameterListener("sp_multiple", this);
+    apvts_ref.removeParameterListener("sg_phase", this);
 
     opengl_context.detach();
 }
 
 void SpectrogramComponent::timerCallback()
 {
+    updatePhasePlane();
+
     // Trigger OpenGL render at fixed fps
     if (trigger_repaint)
         opengl_context.triggerRepaint();
@@ -154,27 +161,39 @@ void SpectrogramComponent::paint(Graphics& g)
         col = logicalCol;
     }
 
-    float value = spectrogram_data[bin][col];
+    // as stored, in 0.31 dB steps.
+    float value = spectrogram_data[getView()][bin][col] / 255.0f;
     float dB = value * 80.0f - 80.0f;
 
     char noteBuf[8];
     getFrequencyToNoteBuf(freq, noteBuf);
 
+    // back from the plane's 0 to 1 to -1 to 1, see computePhasePlane.
+    const int phase_view = phase_data != nullptr ? getPhaseView() : (int) PhaseOff;
+    float phase = phase_data != nullptr ? (phase_data[bin][col] - 128) / 127.0f : 0.0f;
+    char phaseBuf[32] = "";
+    if (phase_view == PhaseDifference)
+        std::snprintf(phaseBuf, sizeof(phaseBuf), "\nPhase: %.0f deg", phase * 180.0f);
+    else if (phase_view == PhaseGroupDelay)
+        std::snprintf(phaseBuf, sizeof(phaseBuf), "\nDelay: %.2f ms", phase * PHASE_GROUP_DELAY_RANGE_MS);
+
     char textBuf[256];
     std::snprintf(
         textBuf,
         sizeof(textBuf),
-        "Freq: %.1f Hz\nNote: %s\nLevel: %.2f dB",
+        "Freq: %.1f Hz\nNote: %s\nLevel: %.1f dB%s",
         freq,
         noteBuf,
-        dB
+        dB,
+        phaseBuf
     );
 
     juce::String text(textBuf);
+    const int lines = phase_view == PhaseOff ? 3 : 4;
 
     auto bounds = getLocalBounds()
                     .removeFromRight(120)
-                    .removeFromBottom(50);
+                    .removeFromBottom(lines * 14 + 8);
 
     bounds.reduce(4, 4);
 
@@ -187,7 +206,7 @@ void SpectrogramComponent::paint(Graphics& g)
         text,
         bounds.reduced(4),
         juce::Justification::topLeft,
-        3
+        lines
     );
 }
 
@@ -248,13 +267,31 @@ void SpectrogramComponent::mouseWheelMove(
     maxParam->endChangeGesture();
 }
 
-void SpectrogramComponent::newDataBatch(std::array<std::vector<float>, 32> &data, int valid, int numBins, float bpm, float sample_rate, int N, int D)
+void SpectrogramComponent::newDataBatch(std::array<std::array<std::vector<float>, 32>, NumAnalysisViews> &data,
+                                        std::array<std::vector<float>, 32> &phase, int phase_view,
+                                        int valid, int numBins, float bpm, float sample_rate, int N, int D, int hop_size)
 {
-    numValidBins = numBins;
-    int fft_size = (numBins - 1) * 2;
+    updatePhasePlane();
+
+    // columns of another rate (the decimation changed) would not line up.
+    if (sample_rate != SR)
+    {
+        clearData();
+        writeIndex = 0;
+        accumulator = 0.0f;
+    }
+
+    // zero padded spectra can have more bins than the texture holds, they
+    // are folded down keeping the peak of every group so a tone keeps its level.
+    int decimation = 1;
+    while ((numBins - 1) / decimation + 1 > SPECTROGRAM_FFT_BINS_MAX)
+        decimation *= 2;
+
+    const int storedBins = (numBins - 1) / decimation + 1;
+    numValidBins = storedBins;
     float fft_bar_measure = apvts_ref.getRawParameterValue("sp_measure")->load();
     float fft_bar_multiple = apvts_ref.getRawParameterValue("sp_multiple")->load();
-    int hop_size = HOP_SIZE;
+    hop_size = jmax(1, hop_size);
 
     static const float measureTable[] = {
         1.0f / 4.0f,
@@ -285,11 +322,47 @@ void SpectrogramComponent::newDataBatch(std::array<std::vector<float>, 32> &data
     float frames_per_column =
         totalFramesForHistory / (float) numColumnsNeeded;
 
+    // batches submitted before "sg_phase" changed carry the old plane.
+    const bool with_phase = phase_view != PhaseOff && phase_view == getPhaseView() && phase_data != nullptr;
+
     // Process each incoming FFT frame
     for (int id = 0; id < valid; ++id) {
-        // Write data to current column
-        for (int bin = 0; bin < numBins; ++bin)
-            spectrogram_data[bin][writeIndex] = data[id][bin];
+        // Write every view to the current column, only one is drawn.
+        for (int view = 0; view < NumAnalysisViews; ++view)
+        {
+            const float* column = data[view][id].data();
+
+            for (int bin = 0; bin < storedBins; ++bin)
+            {
+                const int first = jmax(0, bin * decimation - decimation / 2);
+                const int last  = jmin(numBins - 1, bin * decimation + decimation / 2);
+
+                float peak = column[first];
+                for (int k = first + 1; k <= last; ++k)
+                    peak = jmax(peak, column[k]);
+
+                spectrogram_data[view][bin][writeIndex] = (uint8) jlimit(0, 255, roundToInt(peak * 255.0f));
+            }
+        }
+
+        // folded spectra keep the phase of the loudest bin of the group, by the mid level.
+        if (with_phase)
+        {
+            const float* mid = data[ViewMid][id].data();
+            const float* plane = phase[id].data();
+
+            for (int bin = 0; bin < storedBins; ++bin)
+            {
+                const int first = jmax(0, bin * decimation - decimation / 2);
+                const int last  = jmin(numBins - 1, bin * decimation + decimation / 2);
+
+                int loudest = first;
+                for (int k = first + 1; k <= last; ++k)
+                    if (mid[k] > mid[loudest]) loudest = k;
+
+                phase_data[bin][writeIndex] = (uint8) jlimit(0, 255, roundToInt(plane[loudest] * 255.0f));
+            }
+        }
 
         accumulator += 1.0f;
 
@@ -299,8 +372,12 @@ void SpectrogramComponent::newDataBatch(std::array<std::vector<float>, 32> &data
             writeIndex = (writeIndex + 1) % numColumnsNeeded;
             
             // Clear next column
-            for (int bin = 0; bin < numValidBins; ++bin)
-                spectrogram_data[bin][writeIndex] = 0.0f;
+            for (int view = 0; view < NumAnalysisViews; ++view)
+                for (int bin = 0; bin < numValidBins; ++bin)
+                    spectrogram_data[view][bin][writeIndex] = 0;
+            if (phase_data != nullptr)
+                for (int bin = 0; bin < numValidBins; ++bin)
+                    phase_data[bin][writeIndex] = 128;
 
         }
 
@@ -312,6 +389,25 @@ void SpectrogramComponent::newDataBatch(std::array<std::vector<float>, 32> &data
 
 void SpectrogramComponent::parameterChanged(const String &parameterID, float newValue)
 {
+    // every view has its history, only the texture changes.
+    if (parameterID == "gb_chnl")
+    {
+        new_data_flag = true;
+        if (trigger_repaint)
+            opengl_context.triggerRepaint();
+        return;
+    }
+
+    // the level history stays, the plane of the other view is meaningless.
+    if (parameterID == "sg_phase")
+    {
+        phase_cleared = true;
+        new_data_flag = true;
+        if (trigger_repaint)
+            opengl_context.triggerRepaint();
+        return;
+    }
+
     // In case FFT size is changed.
     clearData();
     writeIndex = 0;
@@ -323,11 +419,30 @@ void SpectrogramComponent::parameterChanged(const String &parameterID, float new
 
 void SpectrogramComponent::clearData()
 {
-    for (int i = 0; i < SPECTROGRAM_FFT_BINS_MAX; ++i) {
-        for (int j = 0; j < SPECTROGRAM_MAX_WIDTH; ++j) {
-            spectrogram_data[i][j] = 0.0f;
-        }
+    std::memset(spectrogram_data, 0, sizeof(spectrogram_data));
+    phase_cleared = true;
+}
+
+void SpectrogramComponent::updatePhasePlane()
+{
+    const bool wanted = getPhaseView() != PhaseOff;
+    const bool cleared = phase_cleared.exchange(false);
+    if (wanted == (phase_data != nullptr) && !cleared)
+        return;
+
+    std::lock_guard<std::mutex> lock(phase_mutex);
+
+    if (!wanted)
+    {
+        phase_data.reset();
+        return;
     }
+
+    if (phase_data == nullptr)
+        phase_data = std::make_unique<uint8[][SPECTROGRAM_MAX_WIDTH]>(SPECTROGRAM_FFT_BINS_MAX);
+
+    std::memset(phase_data.get(), 128, (size_t) SPECTROGRAM_FFT_BINS_MAX * SPECTROGRAM_MAX_WIDTH);
+    new_data_flag = true;
 }
 
 void SpectrogramComponent::newOpenGLContextCreated()
@@ -349,15 +464,28 @@ void SpectrogramComponent::newOpenGLContextCreated()
     glTexImage2D(
         GL_TEXTURE_2D,
         0,
-        GL_R32F,
+        GL_R8,
         SPECTROGRAM_MAX_WIDTH,
         SPECTROGRAM_FFT_BINS_MAX,
         0,
         GL_RED,
-        GL_FLOAT,
-        spectrogram_data
+        GL_UNSIGNED_BYTE,
+        spectrogram_data[ViewMid]
     );
 
+    glGenTextures(1, &phaseTexture);
+    glBindTexture(GL_TEXTURE_2D, phaseTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // grown to the plane's size with its first upload.
+    const uint8 no_phase = 128;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, 1, 1, 0, GL_RED, GL_UNSIGNED_BYTE, &no_phase);
+    phase_uploaded = false;
+
     glGenTextures(1, &colourMapTexture);
     glBindTexture(GL_TEXTURE_1D, colourMapTexture);
 
@@ -391,6 +519,9 @@ void SpectrogramComponent::renderOpenGL()
 
     using namespace juce::gl;
 
+    PerfScope render_scope(perf, PerfGLRender);
+    size_t uploaded = 0;
+
     const float renderingScale = (float)opengl_context.getRenderingScale();
     glViewport(
         0, 0,
@@ -446,6 +577,9 @@ void SpectrogramComponent::renderOpenGL()
 
     if (shader_uniforms->blur)
         shader_uniforms->blur->set(((bool)apvts_ref.getRawParameterValue("sg_high_res")->load() == false) ? (GLfloat)0.2f : (GLfloat)0.0f);
+
+    if (shader_uniforms->phaseData)
+        shader_uniforms->phaseData->set(2);
     
     const float* clr = getColourMapForCode((int)apvts_ref.getRawParameterValue("gb_clrmap")->load());
 
@@ -463,11 +597,43 @@ void SpectrogramComponent::renderOpenGL()
             SPECTROGRAM_MAX_WIDTH,
             numValidBins.load(),
             GL_RED,
-            GL_FLOAT,
-            spectrogram_data);
+            GL_UNSIGNED_BYTE,
+            spectrogram_data[getView()]);
 
-        new_data_flag = false;
+        uploaded += SPECTROGRAM_MAX_WIDTH * numValidBins.load();
     }
+
+    // nothing to send while the plane is off, the texture shrinks back then.
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, phaseTexture);
+    {
+        std::lock_guard<std::mutex> lock(phase_mutex);
+
+        if (phase_data == nullptr && phase_uploaded)
+        {
+            const uint8 no_phase = 128;
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, 1, 1, 0, GL_RED, GL_UNSIGNED_BYTE, &no_phase);
+            phase_uploaded = false;
+        }
+        else if (phase_data != nullptr && !phase_uploaded)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, SPECTROGRAM_MAX_WIDTH, SPECTROGRAM_FFT_BINS_MAX, 0,
+                         GL_RED, GL_UNSIGNED_BYTE, phase_data.get());
+            phase_uploaded = true;
+            uploaded += SPECTROGRAM_MAX_WIDTH * SPECTROGRAM_FFT_BINS_MAX;
+        }
+        else if (phase_data != nullptr && new_data_flag)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SPECTROGRAM_MAX_WIDTH, numValidBins.load(),
+                            GL_RED, GL_UNSIGNED_BYTE, phase_data.get());
+            uploaded += SPECTROGRAM_MAX_WIDTH * numValidBins.load();
+        }
+    }
+
+    new_data_flag = false;
+
+    if (shader_uniforms->phaseView)
+        shader_uniforms->phaseView->set(phase_uploaded ? getPhaseView() : (int) PhaseOff);
     
     if (shader_uniforms->colourMapTex)
         shader_uniforms->colourMapTex->set(1);
@@ -482,6 +648,7 @@ void SpectrogramComponent::renderOpenGL()
                 GL_RGB,
                 GL_FLOAT,
                 clr);
+    uploaded += sizeof(float) * 3 * COLOUR_MAP_NUM_COLOURS;
 
     GLfloat verts[] = { 1,1, 1,-1, -1,-1, -1,1 };
     GLuint inds[]  = { 0,1,3, 1,2,3 };
@@ -494,9 +661,13 @@ void SpectrogramComponent::renderOpenGL()
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(inds), inds, GL_STREAM_DRAW);
 
+    uploaded += sizeof(verts) + sizeof(inds);
+
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
 
     glDisableVertexAttribArray(0);
+
+    if (perf) perf->record(PerfGLUpload, uploaded);
 }
 
 void SpectrogramComponent::openGLContextClosing() {
@@ -513,6 +684,12 @@ void SpectrogramComponent::openGLContextClosing() {
     if (dataTexture)
         glDeleteTextures(1, &dataTexture);
 
+    if (phaseTexture)
+        glDeleteTextures(1, &phaseTexture);
+
+    phaseTexture = 0;
+    phase_uploaded = false;
+
     if (colourMapTexture)
         glDeleteTextures(1, &colourMapTexture);
 
@@ -556,6 +733,8 @@ SpectrogramComponent::Uniforms::Uniforms(OpenGLContext& OpenGL_Context, OpenGLSh
     bias.reset(createUniform(OpenGL_Context, shader_program, "bias"));
     curve.reset(createUniform(OpenGL_Context, shader_program, "curve"));
     blur.reset(createUniform(OpenGL_Context, shader_program, "blur"));
+    phaseData.reset(createUniform(OpenGL_Context, shader_program, "phaseData"));
+    phaseView.reset(createUniform(OpenGL_Context, shader_program, "phaseView"));
 }
 
 OpenGLShaderProgram::Uniform* SpectrogramComponent::Uniforms::createUniform(
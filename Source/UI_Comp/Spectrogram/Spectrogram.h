@@ -4,7 +4,12 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_opengl/juce_opengl.h>
 
-#include "../../ds/dataStructure.h"
+#include <memory>
+#include <mutex>
+
+#include "../../ds/PerfCounters.h"
+#include "../util.h"
+#include "../DFT/PhaseSpectrum.h"
 
 #include "../../ColourMaps.h"
 
@@ -14,6 +19,7 @@ using namespace juce;
 #define SPECTROGRAM_MAX_WIDTH 2000
 // This is required because we can zoom into the spectrogram, by giving the min_freq and max_freq.
 // so we cannot decimate even though the visible pixels might alwas be less than this.
+// Only zero padded spectra above it are, see newDataBatch.
 #define SPECTROGRAM_FFT_BINS_MAX 4097
 
 class SpectrogramComponent 
@@ -24,11 +30,15 @@ class SpectrogramComponent
 {
 public:
 
-    SpectrogramComponent(AudioProcessorValueTreeState& apvts_reference);
+    SpectrogramComponent(AudioProcessorValueTreeState& apvts_reference, PerfCounters* perf_counters = nullptr);
     ~SpectrogramComponent() override;
 
     void timerCallback() override;
-    void newDataBatch(std::array<std::vector<float>, 32>& data, int valid, int numBins, float bpm, float sample_rate, int N, int D);
+    // `data` holds every view of every frame, see AnalysisView. `phase` the
+    // plane of `phase_view` (PhaseView), used while "sg_phase" still shows it.
+    void newDataBatch(std::array<std::array<std::vector<float>, 32>, NumAnalysisViews>& data,
+                      std::array<std::vector<float>, 32>& phase, int phase_view,
+                      int valid, int numBins, float bpm, float sample_rate, int N, int D, int hop_size = HOP_SIZE);
 
     void parameterChanged(const String& parameterID, float newValue) override;
 
@@ -49,8 +59,8 @@ public:
     void mouseMove(const juce::MouseEvent& e) override;
 
 private:
-    //linkDS& linker_ref;
     AudioProcessorValueTreeState& apvts_ref;
+    PerfCounters* perf;
 
     std::atomic<bool> new_data_flag = false;
     std::atomic<bool> trigger_repaint = false;
@@ -72,7 +82,36 @@ private:
     bool mouseOver = false;
     juce::Point<int> lastMousePos;
 
-    float spectrogram_data[SPECTROGRAM_FFT_BINS_MAX][SPECTROGRAM_MAX_WIDTH] = { 0.0f };
+    // the history of every view, so "gb_chnl" switches without losing it.
+    // [-80, 0] dB in 8 bits: 255 steps of 0.31 dB, a level is rounded to
+    // within 0.16 dB of the analyser's. Finer than the colour map shows, its
+    // entries are 7 dB apart, but the hover readout has no more than that.
+    // 4 views x 4097 bins x 2000 columns are 32.8 MB, what a single float
+    // history took.
+    uint8 spectrogram_data[NumAnalysisViews][SPECTROGRAM_FFT_BINS_MAX][SPECTROGRAM_MAX_WIDTH] = {};
+    // the phase or group delay of "sg_phase", 128 being none. 8.2 MB, there
+    // only while the view is on and started over when it changes, see
+    // updatePhasePlane. Written on the message thread, which alone allocates
+    // and frees it under phase_mutex, the GL thread uploads it under the same.
+    std::unique_ptr<uint8[][SPECTROGRAM_MAX_WIDTH]> phase_data;
+    std::mutex phase_mutex;
+    // the plane starts over on the next updatePhasePlane.
+    std::atomic<bool> phase_cleared = false;
+    // GL thread only, the phase texture holds the plane. It is 1 x 1 without.
+    bool phase_uploaded = false;
+
+    // allocates, clears or frees the plane as "sg_phase" says. Message thread.
+    void updatePhasePlane();
+
+    int getPhaseView() const
+    {
+        return jlimit(0, NumPhaseViews - 1, (int) apvts_ref.getRawParameterValue("sg_phase")->load());
+    }
+
+    int getView() const
+    {
+        return jlimit(0, NumAnalysisViews - 1, (int) apvts_ref.getRawParameterValue("gb_chnl")->load());
+    }
 
     void createShaders();
     void drawOverlay(juce::Graphics& g);
@@ -98,7 +137,9 @@ private:
             scroll,
             bias,
             curve,
-            blur;
+            blur,
+            phaseData,
+            phaseView;
 
     private:
         static OpenGLShaderProgram::Uniform* createUniform(
@@ -108,6 +149,7 @@ private:
     };
 
     GLuint dataTexture = 0;
+    GLuint phaseTexture = 0;
     GLuint colourMapTexture = 0;
     GLuint VBO = 0, EBO = 0;
 
@@ -124,6 +166,8 @@ private:
     const char* fragmentShader = R"(
         uniform vec2 resolution;
         uniform sampler2D imageData;
+        uniform sampler2D phaseData;
+        uniform int phaseView;
 
         uniform sampler1D colourMapTex;
 
@@ -241,6 +285,23 @@ private:
             float curvedValue = sCurve(value, curve);
 
             vec3 colour = texture(colourMapTex, clamp(curvedValue, 0.0, 1.0)).rgb;
+
+            // hue from the phase plane, brightness from the level. Phases
+            // cannot be interpolated across the wrap, the nearest bin is taken.
+            if (phaseView != 0)
+            {
+                float fftSize = float(2 * (numBins - 1));
+                int bin = clamp(int(freqFromNorm(uv.y) * fftSize / sampleRate + 0.5), 0, numBins - 1);
+                float p = texelFetch(phaseData, ivec2(col0, bin), 0).r;
+
+                vec3 hue;
+                if (phaseView == 1)
+                    hue = 0.5 + 0.5 * cos(6.2831853 * (p + vec3(0.0, 0.6666667, 0.3333333)));
+                else
+                    hue = mix(vec3(0.2, 0.45, 1.0), vec3(1.0, 0.35, 0.2), p) * (0.6 + 0.8 * abs(p - 0.5));
+
+                colour = hue * clamp(curvedValue, 0.0, 1.0);
+            }
             
             if (curvedValue < bias)
                 colour *= 0.01;
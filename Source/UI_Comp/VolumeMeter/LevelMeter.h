@@ -0,0 +1,227 @@
+#pragma once
+
+// Per channel level meter with selectable ballistics and a peak hold,
+// run sample by sample on the audio thread. Free of any juce dependency,
+// like the LoudnessMeter next to it, so the ballistics can be checked offline.
+//
+// Every ballistic works on time constants in seconds, converted to per sample
+// coefficients in `prepare`, so what the meter shows does not depend on the
+// block size nor on how often the UI looks at it.
+//
+//   RMS     : rectangular sliding window of `setRmsTime` seconds.
+//   Digital : sample peak, instant attack, falls 20 dB in 1.7 s (IEC 60268-18).
+//   VU      : full wave average through a critically damped 2nd order
+//             section reaching 99 % in 300 ms, scaled so a sine reads its rms.
+//   PPM     : quasi peak, a 10 ms burst reads -1 dB, falls 20 dB in 1.7 s
+//             (IEC 60268-10 type I).
+//
+// The peak hold keeps the highest sample peak for `LEVEL_HOLD_S`, counted in
+// samples, then falls like the digital meter.
+//
+// Readers (any thread) get the latest value of each channel from `getLevel`
+// and `getPeakHold`, published once per processed block.
+
+#include <cmath>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#define LEVEL_MAX_CHANNELS 2
+#define LEVEL_HOLD_S 1.5
+#define LEVEL_FALL_DB 20.0
+#define LEVEL_FALL_S 1.7
+#define LEVEL_VU_RISE_S 0.3
+#define LEVEL_PPM_ATTACK_S 0.0017
+
+class LevelMeter
+{
+public:
+
+    enum Ballistics
+    {
+        RMS = 0,
+        Digital,
+        VU,
+        PPM
+    };
+
+    LevelMeter() { prepare(44100.0, 0.5); }
+
+    // allocates the rms window for up to `max_rms_time` seconds, not for the audio thread.
+    void prepare(double sample_rate, double max_rms_time)
+    {
+        fs = sample_rate;
+
+        const double max_length = std::max(1.0, std::ceil(sample_rate * max_rms_time));
+        squares.assign((size_t) max_length * LEVEL_MAX_CHANNELS, 0.0f);
+
+        // linear fall in dB, a constant factor per sample.
+        fall = (float) std::pow(10.0, -LEVEL_FALL_DB / 20.0 / (LEVEL_FALL_S * sample_rate));
+
+        // 1 - (1 + t/tau) e^(-t/tau) = 0.99 at t = 6.638 tau.
+        vu_coeff  = onePole(LEVEL_VU_RISE_S / 6.638, sample_rate);
+        ppm_coeff = onePole(LEVEL_PPM_ATTACK_S, sample_rate);
+
+        hold_samples = (int) (LEVEL_HOLD_S * sample_rate);
+
+        setRmsTime(rms_time);
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(squares.begin(), squares.end(), 0.0f);
+        square_write = 0;
+
+        for (int c = 0; c < LEVEL_MAX_CHANNELS; ++c)
+        {
+            state[c] = Channel();
+            level[c].store(0.0f);
+            peak_hold[c].store(0.0f);
+        }
+    }
+
+    // audio thread, changing the ballistics starts the meter over.
+    void setBallistics(Ballistics new_ballistics)
+    {
+        if (new_ballistics == ballistics)
+            return;
+
+        ballistics = new_ballistics;
+        reset();
+    }
+
+    Ballistics getBallistics() const { return ballistics; }
+
+    // audio thread, clamped to what `prepare` allocated.
+    void setRmsTime(double seconds)
+    {
+        rms_time = seconds;
+
+        const int length = std::clamp((int) (seconds * fs), 1, (int) squares.size() / LEVEL_MAX_CHANNELS);
+
+        if (length != rms_length)
+        {
+            rms_length = length;
+            std::fill(squares.begin(), squares.end(), 0.0f);
+            square_write = 0;
+
+            for (auto& channel : state)
+                channel.sum_squares = 0.0;
+        }
+    }
+
+    // `channels` pointers of `num` samples, a missing second channel mirrors the first.
+    void process(const float* const* channels, int num_channels, int num)
+    {
+        num_channels = std::clamp(num_channels, 1, LEVEL_MAX_CHANNELS);
+
+        for (int c = 0; c < num_channels; ++c)
+            processChannel(c, channels[c], num);
+
+        for (int c = num_channels; c < LEVEL_MAX_CHANNELS; ++c)
+            state[c] = state[num_channels - 1];
+
+        square_write = (square_write + num) % rms_length;
+
+        for (int c = 0; c < LEVEL_MAX_CHANNELS; ++c)
+        {
+            level[c].store(state[c].level);
+            peak_hold[c].store(state[c].hold);
+        }
+    }
+
+    // linear gain, any thread.
+    float getLevel(int channel) const    { return level[channel].load(std::memory_order_relaxed); }
+    float getPeakHold(int channel) const { return peak_hold[channel].load(std::memory_order_relaxed); }
+
+private:
+
+    struct Channel
+    {
+        float level = 0.0f;
+        // the two stages of the VU section.
+        float vu1 = 0.0f, vu2 = 0.0f;
+        double sum_squares = 0.0;
+
+        float hold = 0.0f;
+        int hold_left = 0;
+    };
+
+    static float onePole(double time_constant, double sample_rate)
+    {
+        return (float) (1.0 - std::exp(-1.0 / (time_constant * sample_rate)));
+    }
+
+    void processChannel(int c, const float* x, int num)
+    {
+        Channel& s = state[c];
+        int square_pos = square_write;
+
+        for (int i = 0; i < num; ++i)
+        {
+            const float v = (x[i] == x[i]) ? std::abs(x[i]) : 0.0f;
+
+            // peak hold, sample accurate.
+            if (v >= s.hold)
+            {
+                s.hold = v;
+                s.hold_left = hold_samples;
+            }
+            else if (s.hold_left > 0)
+            {
+                --s.hold_left;
+            }
+            else
+            {
+                s.hold *= fall;
+            }
+
+            switch (ballistics)
+            {
+                case RMS:
+                {
+                    // squares of the channels are interleaved in one ring.
+                    const size_t index = (size_t) (square_pos * LEVEL_MAX_CHANNELS + c);
+                    s.sum_squares += (double) (v * v) - (double) squares[index];
+                    squares[index] = v * v;
+                    s.level = (float) std::sqrt(std::max(s.sum_squares, 0.0) / (double) rms_length);
+
+                    if (++square_pos == rms_length) square_pos = 0;
+                    break;
+                }
+                case Digital:
+                    s.level = std::max(v, s.level * fall);
+                    break;
+                case VU:
+                    s.vu1 += vu_coeff * (v - s.vu1);
+                    s.vu2 += vu_coeff * (s.vu1 - s.vu2);
+                    // mean of a rectified sine is 2/pi of its peak, its rms 1/sqrt(2).
+                    s.level = s.vu2 * 1.1107207f;
+                    break;
+                case PPM:
+                    s.level = (v > s.level) ? s.level + ppm_coeff * (v - s.level)
+                                            : s.level * fall;
+                    break;
+            }
+        }
+    }
+
+    double fs = 44100.0;
+    Ballistics ballistics = RMS;
+
+    float fall = 1.0f;
+    float vu_coeff = 1.0f;
+    float ppm_coeff = 1.0f;
+    int hold_samples = 0;
+
+    double rms_time = 0.045;
+    int rms_length = 1;
+    std::vector<float> squares;
+    int square_write = 0;
+
+    Channel state[LEVEL_MAX_CHANNELS];
+
+    std::atomic<float> level[LEVEL_MAX_CHANNELS];
+    std::atomic<float> peak_hold[LEVEL_MAX_CHANNELS];
+};
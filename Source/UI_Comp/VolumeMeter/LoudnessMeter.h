@@ -0,0 +1,455 @@
+#pragma once
+
+// ITU-R BS.1770 / EBU R128 loudness of a stereo signal: momentary (400 ms),
+// short-term (3 s) and integrated (gated) loudness, the loudness range
+// (EBU Tech 3342) and the true peak. Free of any juce dependency, like
+// the correlation meter's BandSplitter.
+//
+// The K-weighted energy is summed in steps of 100 ms, momentary and
+// short-term are the mean of the last 4 and 30 steps. Every step closes a
+// 400 ms gating block (75 % overlap). Blocks go into a histogram of 0.1 LU
+// bins that also keeps their energy, so the gated integrated loudness is a
+// walk over a fixed number of bins however long the programme runs.
+// Short-term values go into a second histogram for the loudness range.
+//
+// The true peak is the peak of the signal oversampled 4 times (2 times from
+// 192 kHz on) through a polyphase windowed sinc, as described in BS.1770 annex 2.
+//
+// L and R run as the two lanes of the same filters, so every sample is a
+// couple of fixed length loops the compiler vectorizes.
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#define LOUDNESS_STEP_S 0.1
+#define LOUDNESS_MOMENTARY_STEPS 4
+#define LOUDNESS_SHORT_TERM_STEPS 30
+// the lowest bin is also the absolute gate.
+#define LOUDNESS_HIST_MIN -70.0
+#define LOUDNESS_HIST_BINS 800
+#define LOUDNESS_HIST_BIN_LU 0.1
+// taps of every polyphase branch of the true peak interpolator.
+#define LOUDNESS_TP_TAPS 12
+#define LOUDNESS_TP_MAX_FACTOR 4
+
+struct LoudnessReadings
+{
+    // LUFS, -inf while there is nothing to show.
+    float momentary  = -std::numeric_limits<float>::infinity();
+    float short_term = -std::numeric_limits<float>::infinity();
+    float integrated = -std::numeric_limits<float>::infinity();
+    // LU.
+    float range = 0.0f;
+    // dBTP, of the last step and the highest since the last reset.
+    float true_peak     = -std::numeric_limits<float>::infinity();
+    float true_peak_max = -std::numeric_limits<float>::infinity();
+};
+
+class LoudnessMeter
+{
+public:
+
+    LoudnessMeter() { prepare(44100.0); }
+
+    // does not allocate.
+    void prepare(double sample_rate)
+    {
+        setKWeighting(sample_rate);
+        setTruePeakFilter(sample_rate);
+
+        step_length = std::max(1, (int) std::lround(sample_rate * LOUDNESS_STEP_S));
+
+        reset();
+    }
+
+    void reset()
+    {
+        for (int s = 0; s < 2; ++s)
+            for (int c = 0; c < 2; ++c)
+                z1[s][c] = z2[s][c] = 0.0;
+
+        for (int c = 0; c < 2; ++c)
+            for (int k = 0; k < 2 * LOUDNESS_TP_TAPS; ++k)
+                tp_history[c][k] = 0.0f;
+
+        tp_pos = 0;
+
+        for (double& e : step_energy) e = 0.0;
+        steps_done = 0;
+        step_write = 0;
+        step_count = 0;
+        step_sum[0] = step_sum[1] = 0.0;
+        step_peak = 0.0f;
+
+        resetIntegration();
+    }
+
+    // integrated loudness, loudness range and the peak hold start over,
+    // the filters and the sliding windows keep running.
+    void resetIntegration()
+    {
+        for (int b = 0; b < LOUDNESS_HIST_BINS; ++b)
+        {
+            block_count[b] = 0;
+            block_energy[b] = 0.0;
+            short_count[b] = 0;
+            short_energy[b] = 0.0;
+        }
+
+        block_total = 0;
+        block_total_energy = 0.0;
+        short_total = 0;
+        short_total_energy = 0.0;
+
+        peak_max = 0.0f;
+
+        readings = LoudnessReadings();
+    }
+
+    // `left` and `right` may be the same channel. Returns true when at least
+    // one step completed, the readings were updated then.
+    bool process(const float* left, const float* right, int num)
+    {
+        bool updated = false;
+
+        for (int pos = 0; pos < num; )
+        {
+            const int take = std::min(num - pos, step_length - step_count);
+
+            processSpan(left + pos, right + pos, take);
+
+            pos += take;
+            step_count += take;
+
+            if (step_count == step_length)
+            {
+                finishStep();
+                updated = true;
+            }
+        }
+
+        return updated;
+    }
+
+    const LoudnessReadings& getReadings() const { return readings; }
+
+    // mean square energy -> LUFS, as in BS.1770 (both channel weights are 1).
+    static double energyToLoudness(double energy)
+    {
+        return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy)
+                            : -std::numeric_limits<double>::infinity();
+    }
+
+private:
+
+    void processSpan(const float* left, const float* right, int num)
+    {
+        double sum[2] = { step_sum[0], step_sum[1] };
+        float peak[2] = { step_peak, step_peak };
+
+        for (int i = 0; i < num; ++i)
+        {
+            // NaN -> 0, anything else goes through untouched (overs included).
+            float in[2] = { left[i], right[i] };
+            for (int c = 0; c < 2; ++c)
+                in[c] = (in[c] == in[c]) ? in[c] : 0.0f;
+
+            // K-weighting, transposed direct form II, both channels at once.
+            double x[2] = { in[0], in[1] };
+            for (int s = 0; s < 2; ++s)
+            {
+                for (int c = 0; c < 2; ++c)
+                {
+                    const double y = b0[s] * x[c] + z1[s][c];
+                    z1[s][c] = b1[s] * x[c] - a1[s] * y + z2[s][c];
+                    z2[s][c] = b2[s] * x[c] - a2[s] * y;
+                    x[c] = y;
+                }
+            }
+
+            for (int c = 0; c < 2; ++c)
+                sum[c] += x[c] * x[c];
+
+            // true peak, the history is written twice so the taps are contiguous.
+            for (int c = 0; c < 2; ++c)
+            {
+                tp_history[c][tp_pos] = in[c];
+                tp_history[c][tp_pos + LOUDNESS_TP_TAPS] = in[c];
+                peak[c] = std::max(peak[c], std::abs(in[c]));
+            }
+
+            if (++tp_pos == LOUDNESS_TP_TAPS) tp_pos = 0;
+
+            for (int c = 0; c < 2; ++c)
+            {
+                // oldest first, newest last.
+                const float* h = tp_history[c] + tp_pos;
+
+                for (int p = 0; p < tp_factor; ++p)
+                {
+                    float acc = 0.0f;
+                    for (int k = 0; k < LOUDNESS_TP_TAPS; ++k)
+                        acc += tp_phase[p][k] * h[k];
+
+                    peak[c] = std::max(peak[c], std::abs(acc));
+                }
+            }
+        }
+
+        step_sum[0] = sum[0];
+        step_sum[1] = sum[1];
+        step_peak = std::max(peak[0], peak[1]);
+    }
+
+    void finishStep()
+    {
+        step_energy[step_write] = (step_sum[0] + step_sum[1]) / (double) step_length;
+        if (++step_write == LOUDNESS_SHORT_TERM_STEPS) step_write = 0;
+        ++steps_done;
+
+        step_count = 0;
+        step_sum[0] = step_sum[1] = 0.0;
+
+        const double momentary  = meanOfLastSteps(LOUDNESS_MOMENTARY_STEPS);
+        const double short_term = meanOfLastSteps(LOUDNESS_SHORT_TERM_STEPS);
+
+        // a gating block is only complete once 400 ms went in.
+        if (steps_done >= LOUDNESS_MOMENTARY_STEPS)
+        {
+            const int bin = binOf(energyToLoudness(momentary));
+            if (bin >= 0)
+            {
+                ++block_count[bin];
+                block_energy[bin] += momentary;
+                ++block_total;
+                block_total_energy += momentary;
+            }
+        }
+
+        if (steps_done >= LOUDNESS_SHORT_TERM_STEPS)
+        {
+            const int bin = binOf(energyToLoudness(short_term));
+            if (bin >= 0)
+            {
+                ++short_count[bin];
+                short_energy[bin] += short_term;
+                ++short_total;
+                short_total_energy += short_term;
+            }
+        }
+
+        readings.momentary  = (float) energyToLoudness(momentary);
+        readings.short_term = (float) energyToLoudness(short_term);
+        readings.integrated = (float) integratedLoudness();
+        readings.range      = (float) loudnessRange();
+
+        peak_max = std::max(peak_max, step_peak);
+        readings.true_peak     = gainToDb(step_peak);
+        readings.true_peak_max = gainToDb(peak_max);
+
+        step_peak = 0.0f;
+    }
+
+    double meanOfLastSteps(int steps) const
+    {
+        double sum = 0.0;
+        int index = step_write;
+
+        for (int k = 0; k < steps; ++k)
+        {
+            if (--index < 0) index = LOUDNESS_SHORT_TERM_STEPS - 1;
+            sum += step_energy[index];
+        }
+
+        return sum / (double) steps;
+    }
+
+    // histogram bin of a loudness, -1 below the absolute gate.
+    static int binOf(double loudness)
+    {
+        if (!(loudness >= LOUDNESS_HIST_MIN))
+            return -1;
+
+        const int bin = (int) ((loudness - LOUDNESS_HIST_MIN) / LOUDNESS_HIST_BIN_LU);
+        return std::min(bin, LOUDNESS_HIST_BINS - 1);
+    }
+
+    // the first bin whose centre lies above the relative gate.
+    static int relativeGateBin(double total_energy, int total, double gate_lu)
+    {
+        const double gate = energyToLoudness(total_energy / (double) total) + gate_lu;
+        const double first = (gate - LOUDNESS_HIST_MIN) / LOUDNESS_HIST_BIN_LU - 0.5;
+
+        return std::clamp((int) std::ceil(first), 0, LOUDNESS_HIST_BINS - 1);
+    }
+
+    double integratedLoudness() const
+    {
+        if (block_total == 0)
+            return -std::numeric_limits<double>::infinity();
+
+        double energy = 0.0;
+        int count = 0;
+
+        for (int b = relativeGateBin(block_total_energy, block_total, -10.0); b < LOUDNESS_HIST_BINS; ++b)
+        {
+            energy += block_energy[b];
+            count  += block_count[b];
+        }
+
+        return count > 0 ? energyToLoudness(energy / (double) count)
+                         : -std::numeric_limits<double>::infinity();
+    }
+
+    // difference of the 95th and the 10th percentile of the gated short-term values.
+    double loudnessRange() const
+    {
+        if (short_total == 0)
+            return 0.0;
+
+        const int first = relativeGateBin(short_total_energy, short_total, -20.0);
+
+        int count = 0;
+        for (int b = first; b < LOUDNESS_HIST_BINS; ++b)
+            count += short_count[b];
+
+        if (count == 0)
+            return 0.0;
+
+        auto percentile = [&](double fraction)
+        {
+            const double target = fraction * (double) (count - 1);
+
+            int seen = 0;
+            for (int b = first; b < LOUDNESS_HIST_BINS; ++b)
+            {
+                seen += short_count[b];
+                if ((double) seen > target)
+                    return b;
+            }
+
+            return LOUDNESS_HIST_BINS - 1;
+        };
+
+        return (double) (percentile(0.95) - percentile(0.10)) * LOUDNESS_HIST_BIN_LU;
+    }
+
+    static float gainToDb(float gain)
+    {
+        return gain > 0.0f ? 20.0f * std::log10(gain) : -std::numeric_limits<float>::infinity();
+    }
+
+    // the two stages of BS.1770, a high shelf and the RLB high pass,
+    // recomputed for the sample rate from their analog prototypes.
+    void setKWeighting(double sample_rate)
+    {
+        const double pi = 3.14159265358979323846;
+
+        {
+            const double f0 = 1681.974450955533;
+            const double G  = 3.999843853973347;
+            const double Q  = 0.7071752369554196;
+
+            const double K  = std::tan(pi * f0 / sample_rate);
+            const double Vh = std::pow(10.0, G / 20.0);
+            const double Vb = std::pow(Vh, 0.4996667741545416);
+            const double a0 = 1.0 + K / Q + K * K;
+
+            b0[0] = (Vh + Vb * K / Q + K * K) / a0;
+            b1[0] = 2.0 * (K * K - Vh) / a0;
+            b2[0] = (Vh - Vb * K / Q + K * K) / a0;
+            a1[0] = 2.0 * (K * K - 1.0) / a0;
+            a2[0] = (1.0 - K / Q + K * K) / a0;
+        }
+
+        {
+            const double f0 = 38.13547087602444;
+            const double Q  = 0.5003270373238773;
+
+            const double K  = std::tan(pi * f0 / sample_rate);
+            const double a0 = 1.0 + K / Q + K * K;
+
+            b0[1] = 1.0;
+            b1[1] = -2.0;
+            b2[1] = 1.0;
+            a1[1] = 2.0 * (K * K - 1.0) / a0;
+            a2[1] = (1.0 - K / Q + K * K) / a0;
+        }
+    }
+
+    // windowed sinc low pass at the original nyquist, split into its phases.
+    // Taps are stored reversed so a phase is a dot product with the history.
+    void setTruePeakFilter(double sample_rate)
+    {
+        tp_factor = sample_rate < 192000.0 ? 4 : 2;
+
+        const double pi = 3.14159265358979323846;
+        const int length = tp_factor * LOUDNESS_TP_TAPS;
+        const double centre = 0.5 * (double) (length - 1);
+
+        for (int p = 0; p < LOUDNESS_TP_MAX_FACTOR; ++p)
+            for (int k = 0; k < LOUDNESS_TP_TAPS; ++k)
+                tp_phase[p][k] = 0.0f;
+
+        for (int p = 0; p < tp_factor; ++p)
+        {
+            double phase[LOUDNESS_TP_TAPS];
+            double sum = 0.0;
+
+            for (int k = 0; k < LOUDNESS_TP_TAPS; ++k)
+            {
+                const int n = k * tp_factor + p;
+                const double t = ((double) n - centre) / (double) tp_factor;
+                const double sinc = std::abs(t) < 1e-9 ? 1.0 : std::sin(pi * t) / (pi * t);
+
+                // blackman-harris.
+                const double w = 2.0 * pi * ((double) n + 0.5) / (double) length;
+                const double window = 0.35875 - 0.48829 * std::cos(w)
+                                    + 0.14128 * std::cos(2.0 * w) - 0.01168 * std::cos(3.0 * w);
+
+                phase[k] = sinc * window;
+                sum += phase[k];
+            }
+
+            // unity gain at DC for every phase.
+            for (int k = 0; k < LOUDNESS_TP_TAPS; ++k)
+                tp_phase[p][LOUDNESS_TP_TAPS - 1 - k] = (float) (phase[k] / sum);
+        }
+    }
+
+    // K-weighting, stage 0 the shelf, stage 1 the high pass; z per channel.
+    double b0[2], b1[2], b2[2], a1[2], a2[2];
+    double z1[2][2], z2[2][2];
+
+    int tp_factor = 4;
+    float tp_phase[LOUDNESS_TP_MAX_FACTOR][LOUDNESS_TP_TAPS];
+    float tp_history[2][2 * LOUDNESS_TP_TAPS];
+    int tp_pos = 0;
+
+    // the step being filled.
+    int step_length = 4410;
+    int step_count = 0;
+    double step_sum[2] = {};
+    float step_peak = 0.0f;
+
+    // mean square of the last steps, enough for the short-term window.
+    double step_energy[LOUDNESS_SHORT_TERM_STEPS] = {};
+    int step_write = 0;
+    long long steps_done = 0;
+
+    // gating blocks and short-term values per 0.1 LU bin, from -70 LUFS up.
+    int block_count[LOUDNESS_HIST_BINS];
+    double block_energy[LOUDNESS_HIST_BINS];
+    int block_total = 0;
+    double block_total_energy = 0.0;
+
+    int short_count[LOUDNESS_HIST_BINS];
+    double short_energy[LOUDNESS_HIST_BINS];
+    int short_total = 0;
+    double short_total_energy = 0.0;
+
+    float peak_max = 0.0f;
+
+    LoudnessReadings readings;
+};
@@ -0,0 +1,121 @@
+#include "Volume.h"
+
+VolumeMeterComponent::VolumeMeterComponent(const LevelMeter& level_meter)
+    :   meter(level_meter)
+{
+}
+
+void VolumeMeterComponent::zeroOut()
+{
+    true_peak.store(-std::numeric_limits<float>::infinity());
+}
+
+static float gain_to_db(float gain)
+{
+    return 20.0 * log10f(gain);
+}
+
+static float custom_remap(float vol_dB)
+{
+    vol_dB = std::clamp<float>(vol_dB, -80.0, 0.0);
+    return jmap<float>(vol_dB, -80.0, 0.0, 0.0, 1.0);
+}
+
+void VolumeMeterComponent::paint(Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    int padding = std::max(1.0, 0.1 * getWidth());
+
+    auto bounds = getLocalBounds();
+
+    auto right = bounds.removeFromRight(padding);
+
+    g.setColour(accent_colour);
+    g.fillRect(right);
+
+    bounds.removeFromLeft(1);
+    bounds.removeFromRight(1);
+
+    auto center_line_bounds = bounds;
+    center_line_bounds.removeFromTop(bounds.getHeight() / 2);
+    center_line_bounds.removeFromBottom(bounds.getHeight() / 2 - 1);
+
+    // the bar is the level with the selected ballistics, the grey one behind it the peak hold.
+    float l_vol_frac = custom_remap(gain_to_db(
+        std::clamp<float>(meter.getLevel(0), 0.0, 1.0)
+    ));
+    float r_vol_frac = custom_remap(gain_to_db(
+        std::clamp<float>(meter.getLevel(1), 0.0, 1.0)
+    ));
+    float l_vol_frac_smooth = custom_remap(gain_to_db(
+        std::clamp<float>(meter.getPeakHold(0), 0.0, 1.0)
+    ));
+    float r_vol_frac_smooth = custom_remap(gain_to_db(
+        std::clamp<float>(meter.getPeakHold(1), 0.0, 1.0)
+    ));
+
+    auto left_bar_bounds = bounds.removeFromLeft(bounds.getWidth() / 2);
+    auto right_bar_bounds = bounds;
+
+    auto left_background_bar_bound = left_bar_bounds;
+    auto right_background_bar_bound = right_bar_bounds;
+
+    if (left_bar_bounds.getWidth() > 1 && right_bar_bounds.getWidth() > 1)
+    {
+        left_bar_bounds.removeFromRight(1);
+        left_background_bar_bound.removeFromRight(1);
+    }
+
+    int half_remove_left  = (1.0 - l_vol_frac) * bounds.getHeight() * 0.5;
+    int half_remove_right = (1.0 - r_vol_frac) * bounds.getHeight() * 0.5;
+
+    int half_remove_left_smooth  = (1.0 - l_vol_frac_smooth) * bounds.getHeight() * 0.5;
+    int half_remove_right_smooth = (1.0 - r_vol_frac_smooth) * bounds.getHeight() * 0.5;
+
+    left_bar_bounds.removeFromTop(half_remove_left);
+    left_bar_bounds.removeFromBottom(half_remove_left);
+
+    right_bar_bounds.removeFromTop(half_remove_right);
+    right_bar_bounds.removeFromBottom(half_remove_right);
+
+    left_background_bar_bound.removeFromTop(half_remove_left_smooth);
+    left_background_bar_bound.removeFromBottom(half_remove_left_smooth);
+
+    right_background_bar_bound.removeFromTop(half_remove_right_smooth);
+    right_background_bar_bound.removeFromBottom(half_remove_right_smooth);
+
+    g.setColour(juce::Colours::darkgrey);
+    g.fillRect(left_background_bar_bound);
+    g.fillRect(right_background_bar_bound);
+
+    g.setColour(juce::Colours::white);
+    g.fillRect(left_bar_bounds);
+    g.fillRect(right_bar_bounds);
+
+    g.setColour(juce::Colours::darkgrey.withAlpha(0.5f));
+    g.fillRect(center_line_bounds);
+
+    // true peak hold, mirrored like the bars.
+    float true_peak_frac = custom_remap(true_peak.load());
+
+    if (true_peak_frac > 0.0f)
+    {
+        int half_remove_peak = (1.0 - true_peak_frac) * bounds.getHeight() * 0.5;
+
+        g.setColour(true_peak.load() > -1.0f ? juce::Colours::red : juce::Colours::orange);
+        g.fillRect(center_line_bounds.getX(), bounds.getY() + half_remove_peak,
+                   center_line_bounds.getWidth(), 1);
+        g.fillRect(center_line_bounds.getX(), bounds.getBottom() - half_remove_peak - 1,
+                   center_line_bounds.getWidth(), 1);
+    }
+}
+
+void VolumeMeterComponent::resized()
+{
+}
+
+void VolumeMeterComponent::newTruePeak(float true_peak_db)
+{
+    true_peak.store(true_peak_db);
+}
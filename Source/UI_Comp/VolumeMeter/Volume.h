@@ -0,0 +1,34 @@
+#pragma once
+
+// Volume bars, one per channel growing out from the middle.
+// Only draws what a LevelMeter published, the view that owns the
+// meter feeds it from the audio thread.
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "LevelMeter.h"
+
+using namespace juce;
+
+class VolumeMeterComponent
+    : public Component
+{
+public:
+    explicit VolumeMeterComponent(const LevelMeter& level_meter);
+
+    void paint(Graphics& g) override;
+    void resized() override;
+
+    // held true peak in dBTP, drawn as a tick on the bars.
+    void newTruePeak(float true_peak_db);
+
+    void zeroOut();
+
+    juce::Colour accent_colour = juce::Colours::red;
+private:
+
+    const LevelMeter& meter;
+
+    std::atomic<float> true_peak = -std::numeric_limits<float>::infinity();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VolumeMeterComponent)
+};
@@ -4,6 +4,16 @@
 
 #define HOP_SIZE 458
 
+// spectra every analysis frame has, in the order of the "gb_chnl" choices.
+enum AnalysisView
+{
+    ViewMid,    // L+R
+    ViewLeft,
+    ViewRight,
+    ViewSide,
+    NumAnalysisViews
+};
+
 using namespace std;
 
 // returns from 0->1
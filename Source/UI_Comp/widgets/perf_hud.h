@@ -0,0 +1,136 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "../../ds/PerfCounters.h"
+
+using namespace juce;
+
+#define PERF_HUD_HZ 4
+
+// overlay of the hot path timings, one row per metric (p50, p99, max) and
+// the drop counters. Polls the counters only while it is visible.
+class PerfHud : public Component, private Timer
+{
+public:
+
+    PerfHud(PerfCounters& perf_counters)
+        : perf(perf_counters)
+    {
+        addAndMakeVisible(save_button);
+        addAndMakeVisible(reset_button);
+        addAndMakeVisible(close_button);
+
+        save_button.onClick  = [this] { saveJSON(); };
+        reset_button.onClick = [this] { perf.reset(); repaint(); };
+        close_button.onClick = [this] { if (onClose) onClose(); };
+    }
+
+    // the owner hides the overlay and untoggles its button.
+    std::function<void()> onClose;
+
+    void visibilityChanged() override
+    {
+        if (isVisible()) startTimerHz(PERF_HUD_HZ);
+        else stopTimer();
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.fillAll(Colour(0xf00f0f0f));
+
+        auto bounds = getLocalBounds().reduced(getWidth() / 40, 0);
+        bounds.removeFromTop(header_height);
+
+        const int row_height = jmax(14, getHeight() / 32);
+        const float font_size = row_height * 0.7f;
+
+        auto columns = [&](Rectangle<int> row, const String& name, const String& p50,
+                           const String& p99, const String& max, Colour colour)
+        {
+            g.setColour(colour);
+            const int w = row.getWidth();
+
+            g.drawText(name, row.removeFromLeft(w * 40 / 100), Justification::centredLeft);
+            g.drawText(p50,  row.removeFromLeft(w * 20 / 100), Justification::centredRight);
+            g.drawText(p99,  row.removeFromLeft(w * 20 / 100), Justification::centredRight);
+            g.drawText(max,  row, Justification::centredRight);
+        };
+
+        g.setFont(Font(font_size, Font::bold));
+        columns(bounds.removeFromTop(row_height), "metric", "p50", "p99", "max", Colour(0xff00a8ff));
+
+        g.setFont(Font(font_size));
+
+        for (int m = 0; m < PerfNumMetrics; ++m)
+        {
+            const auto& h = perf.get((PerfMetric) m);
+            const String unit = PerfCounters::getUnit((PerfMetric) m);
+
+            // an audio callback over its block's duration is a dropout.
+            bool late = m == PerfAudioLoad && h.getMax() >= 100;
+
+            columns(bounds.removeFromTop(row_height),
+                    String(PerfCounters::getName((PerfMetric) m)) + " (" + unit + ")",
+                    String(h.getPercentile(0.5)), String(h.getPercentile(0.99)), String(h.getMax()),
+                    late ? Colours::orangered : Colours::white);
+        }
+
+        bounds.removeFromTop(row_height / 2);
+
+        for (int c = 0; c < PerfNumCounters; ++c)
+        {
+            auto value = perf.get((PerfCounter) c);
+
+            columns(bounds.removeFromTop(row_height), PerfCounters::getName((PerfCounter) c),
+                    "", "", String(value), value > 0 ? Colours::orangered : Colours::white);
+        }
+
+        if (status.isNotEmpty())
+        {
+            g.setColour(Colours::grey);
+            g.drawFittedText(status, bounds.removeFromTop(row_height * 2), Justification::centredLeft, 2);
+        }
+    }
+
+    void resized() override
+    {
+        header_height = jmax(20, getHeight() / 24);
+
+        auto header = getLocalBounds().removeFromTop(header_height).reduced(2);
+        const int w = header.getWidth() / 3;
+
+        save_button.setBounds(header.removeFromLeft(w).reduced(2, 0));
+        reset_button.setBounds(header.removeFromLeft(w).reduced(2, 0));
+        close_button.setBounds(header.reduced(2, 0));
+    }
+
+private:
+
+    void timerCallback() override { repaint(); }
+
+    void saveJSON()
+    {
+        File folder = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("Analytiks");
+        folder.createDirectory();
+
+        File file = folder.getNonexistentChildFile(
+            "perf-" + Time::getCurrentTime().formatted("%Y%m%d-%H%M%S"), ".json", false);
+
+        status = file.replaceWithText(String(perf.toJSON()))
+            ? "saved " + file.getFullPathName()
+            : "cannot write " + file.getFullPathName();
+
+        repaint();
+    }
+
+    PerfCounters& perf;
+
+    TextButton save_button  { "Save JSON" };
+    TextButton reset_button { "Reset" };
+    TextButton close_button { "Close" };
+
+    String status;
+    int header_height = 20;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PerfHud)
+};
@@ -3,58 +3,97 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_processors/juce_audio_processors.h>
 #include "Modernlookandfeel.h"
+#include "perf_hud.h"
+#include "../../QualityGovernor.h"
 
 using namespace juce;
 
-class settingsPage : public Component
+class settingsPage : public Component,
+                     private ChangeListener
 {
 public:
 
-    settingsPage(AudioProcessorValueTreeState& apvts_r)
-        : apvts_ref(apvts_r)
+    settingsPage(AudioProcessorValueTreeState& apvts_r, PerfCounters& perf_counters,
+                 QualityGovernor& quality_governor)
+        : apvts_ref(apvts_r),
+          governor(quality_governor),
+          perf_hud(perf_counters)
     {
+        // the controls scroll, their rows don't shrink with the page.
+        addAndMakeVisible(viewport);
+        viewport.setViewedComponent(&content, false);
+        viewport.setScrollBarsShown(true, false);
+
         // Add all components
-        addAndMakeVisible(global_settings_label);
-        addAndMakeVisible(analyser_settings_label);
-        addAndMakeVisible(spectrogram_settings_label);
-        addAndMakeVisible(correlation_settings_label);
-        addAndMakeVisible(ocsilloscope_settings_label);
-        addAndMakeVisible(accent_colour_slider_label);
-        addAndMakeVisible(num_bars_slider_label);
-        addAndMakeVisible(bar_speed_slider_label);
-        addAndMakeVisible(spec_higlight_gate_slider_label);
-        addAndMakeVisible(colourmap_bias_slider_label);
-        addAndMakeVisible(colourmap_curve_slider_label);
-        addAndMakeVisible(volume_rms_time_label);
-        addAndMakeVisible(listen_button_label);
-        addAndMakeVisible(colourmap_combobox_label);
-        addAndMakeVisible(channel_combobox_label);
-        addAndMakeVisible(scrollmode_combobox_label);
-        addAndMakeVisible(fftorder_combobox_label);
-        addAndMakeVisible(spec_history_multiply_slider_label);
-        addAndMakeVisible(measure_combobox_label);
-        addAndMakeVisible(freq_rng_min_label);
-        addAndMakeVisible(freq_rng_max_label);
+        content.addAndMakeVisible(global_settings_label);
+        content.addAndMakeVisible(analyser_settings_label);
+        content.addAndMakeVisible(spectrogram_settings_label);
+        content.addAndMakeVisible(correlation_settings_label);
+        content.addAndMakeVisible(ocsilloscope_settings_label);
+        content.addAndMakeVisible(accent_colour_slider_label);
+        content.addAndMakeVisible(num_bars_slider_label);
+        content.addAndMakeVisible(bar_speed_slider_label);
+        content.addAndMakeVisible(spec_higlight_gate_slider_label);
+        content.addAndMakeVisible(colourmap_bias_slider_label);
+        content.addAndMakeVisible(colourmap_curve_slider_label);
+        content.addAndMakeVisible(volume_rms_time_label);
+        content.addAndMakeVisible(kaiser_beta_slider_label);
+        content.addAndMakeVisible(gonio_history_slider_label);
+        content.addAndMakeVisible(listen_button_label);
+        content.addAndMakeVisible(colourmap_combobox_label);
+        content.addAndMakeVisible(channel_combobox_label);
+        content.addAndMakeVisible(scrollmode_combobox_label);
+        content.addAndMakeVisible(fftorder_combobox_label);
+        content.addAndMakeVisible(spec_history_multiply_slider_label);
+        content.addAndMakeVisible(measure_combobox_label);
+        content.addAndMakeVisible(transfer_avg_combobox_label);
+        content.addAndMakeVisible(phase_combobox_label);
+        content.addAndMakeVisible(zeropad_combobox_label);
+        content.addAndMakeVisible(window_combobox_label);
+        content.addAndMakeVisible(meter_combobox_label);
+        content.addAndMakeVisible(gonio_combobox_label);
+        content.addAndMakeVisible(bands_combobox_label);
+        content.addAndMakeVisible(trigger_combobox_label);
+        content.addAndMakeVisible(freq_rng_min_label);
+        content.addAndMakeVisible(freq_rng_max_label);
 
         
-        addAndMakeVisible(accent_colour_slider);
-        addAndMakeVisible(num_bars_slider);
-        addAndMakeVisible(bar_speed_slider);
-        addAndMakeVisible(spec_higlight_gate_slider);
-        addAndMakeVisible(colourmap_bias_slider);
-        addAndMakeVisible(colourmap_curve_slider);
-        addAndMakeVisible(volume_rms_time_slider);
-        addAndMakeVisible(freq_rng_min_slider);
-        addAndMakeVisible(freq_rng_max_slider);
-
-        addAndMakeVisible(listen_button);
-
-        addAndMakeVisible(colourmap_combobox);
-        addAndMakeVisible(channel_combobox);
-        addAndMakeVisible(scrollmode_combobox);
-        addAndMakeVisible(fftorder_combobox);
-        addAndMakeVisible(spec_history_multiply_slider);
-        addAndMakeVisible(measure_combobox);
+        content.addAndMakeVisible(accent_colour_slider);
+        content.addAndMakeVisible(num_bars_slider);
+        content.addAndMakeVisible(bar_speed_slider);
+        content.addAndMakeVisible(spec_higlight_gate_slider);
+        content.addAndMakeVisible(colourmap_bias_slider);
+        content.addAndMakeVisible(colourmap_curve_slider);
+        content.addAndMakeVisible(volume_rms_time_slider);
+        content.addAndMakeVisible(kaiser_beta_slider);
+        content.addAndMakeVisible(gonio_history_slider);
+        content.addAndMakeVisible(freq_rng_min_slider);
+        content.addAndMakeVisible(freq_rng_max_slider);
+
+        content.addAndMakeVisible(listen_button);
+        content.addAndMakeVisible(record_button);
+        content.addAndMakeVisible(decimate_button);
+        content.addAndMakeVisible(transfer_button);
+        content.addAndMakeVisible(adaptive_button);
+        content.addAndMakeVisible(perf_hud_button);
+
+        // over the whole page while the button is on.
+        addChildComponent(perf_hud);
+
+        content.addAndMakeVisible(colourmap_combobox);
+        content.addAndMakeVisible(channel_combobox);
+        content.addAndMakeVisible(scrollmode_combobox);
+        content.addAndMakeVisible(fftorder_combobox);
+        content.addAndMakeVisible(spec_history_multiply_slider);
+        content.addAndMakeVisible(measure_combobox);
+        content.addAndMakeVisible(transfer_avg_combobox);
+        content.addAndMakeVisible(phase_combobox);
+        content.addAndMakeVisible(zeropad_combobox);
+        content.addAndMakeVisible(window_combobox);
+        content.addAndMakeVisible(meter_combobox);
+        content.addAndMakeVisible(gonio_combobox);
+        content.addAndMakeVisible(bands_combobox);
+        content.addAndMakeVisible(trigger_combobox);
 
         // Populate combo boxes
         auto* param1 = dynamic_cast<juce::AudioParameterChoice*>(apvts_r.getParameter("gb_clrmap"));
@@ -77,6 +116,38 @@ public:
         for (int i = 0; i < param6->choices.size(); ++i)
             measure_combobox.addItem(param6->choices[i], i + 1);
 
+        auto* param7 = dynamic_cast<juce::AudioParameterChoice*>(apvts_r.getParameter("os_trig"));
+        for (int i = 0; i < param7->choices.size(); ++i)
+            trigger_combobox.addItem(param7->choices[i], i + 1);
+
+        auto* param8 = dynamic_cast<juce::AudioParameterChoice*>(apvts_r.getParameter("v_bands"));
+        for (int i = 0; i < param8->choices.size(); ++i)
+            bands_combobox.addItem(param8->choices[i], i + 1);
+
+        auto* param9 = dynamic_cast<juce::AudioParameterChoice*>(apvts_r.getParameter("v_gonio"));
+        for (int i = 0; i < param9->choices.size(); ++i)
+            gonio_combobox.addItem(param9->choices[i], i + 1);
+
+        auto* param10 = dynamic_cast<juce::AudioParameterChoice*>(apvts_r.getParameter("v_meter"));
+        for (int i = 0; i < param10->choices.size(); ++i)
+            meter_combobox.addItem(param10->choices[i], i + 1);
+
+        auto* param11 = dynamic_cast<juce::AudioParameterChoice*>(apvts_r.getParameter("gb_window"));
+        for (int i = 0; i < param11->choices.size(); ++i)
+            window_combobox.addItem(param11->choices[i], i + 1);
+
+        auto* param12 = dynamic_cast<juce::AudioParameterChoice*>(apvts_r.getParameter("gb_zero_pad"));
+        for (int i = 0; i < param12->choices.size(); ++i)
+            zeropad_combobox.addItem(param12->choices[i], i + 1);
+
+        auto* param13 = dynamic_cast<juce::AudioParameterChoice*>(apvts_r.getParameter("sg_phase"));
+        for (int i = 0; i < param13->choices.size(); ++i)
+            phase_combobox.addItem(param13->choices[i], i + 1);
+
+        auto* param14 = dynamic_cast<juce::AudioParameterChoice*>(apvts_r.getParameter("gb_tf_avg"));
+        for (int i = 0; i < param14->choices.size(); ++i)
+            transfer_avg_combobox.addItem(param14->choices[i], i + 1);
+
         // Set label text
         accent_colour_slider_label.setText("UI Colour", juce::dontSendNotification);
         num_bars_slider_label.setText("Number of Bars", juce::dontSendNotification);
@@ -85,12 +156,22 @@ public:
         colourmap_bias_slider_label.setText("Gate", juce::dontSendNotification);
         colourmap_curve_slider_label.setText("Curve", juce::dontSendNotification);
         volume_rms_time_label.setText("Volume RMS Window (ms)", juce::dontSendNotification);
+        kaiser_beta_slider_label.setText("Kaiser Beta", juce::dontSendNotification);
+        gonio_history_slider_label.setText("Goniometer History (ms)", juce::dontSendNotification);
         listen_button_label.setText("Listen", juce::dontSendNotification);
         colourmap_combobox_label.setText("Colourmap", juce::dontSendNotification);
         channel_combobox_label.setText("Channel", juce::dontSendNotification);
         scrollmode_combobox_label.setText("Scrolling", juce::dontSendNotification);
         fftorder_combobox_label.setText("FFT Order", juce::dontSendNotification);
         measure_combobox_label.setText("Base Measure", juce::dontSendNotification);
+        transfer_avg_combobox_label.setText("Transfer Averaging", juce::dontSendNotification);
+        phase_combobox_label.setText("Phase View", juce::dontSendNotification);
+        zeropad_combobox_label.setText("Zero Padding", juce::dontSendNotification);
+        window_combobox_label.setText("FFT Window", juce::dontSendNotification);
+        meter_combobox_label.setText("Volume Meter", juce::dontSendNotification);
+        gonio_combobox_label.setText("Goniometer", juce::dontSendNotification);
+        bands_combobox_label.setText("Correlation Bands", juce::dontSendNotification);
+        trigger_combobox_label.setText("Trigger", juce::dontSendNotification);
         spec_history_multiply_slider_label.setText("History Multiple", juce::dontSendNotification);
         freq_rng_min_label.setText("Min Frequency (Hz)", juce::dontSendNotification);
         freq_rng_max_label.setText("Max Frequency (Hz)", juce::dontSendNotification);
@@ -107,7 +188,15 @@ public:
                 &channel_combobox,
                 &scrollmode_combobox,
                 &fftorder_combobox,
-                &measure_combobox
+                &measure_combobox,
+                &trigger_combobox,
+                &bands_combobox,
+                &gonio_combobox,
+                &meter_combobox,
+                &window_combobox,
+                &zeropad_combobox,
+                &phase_combobox,
+                &transfer_avg_combobox
             })
         {
             box_->setLookAndFeel(&modernStyle);
@@ -123,6 +212,8 @@ public:
                 &colourmap_bias_slider,
                 &colourmap_curve_slider,
                 &volume_rms_time_slider,
+                &kaiser_beta_slider,
+                &gonio_history_slider,
                 &spec_history_multiply_slider
             })
         {
@@ -136,6 +227,39 @@ public:
         listen_button.setButtonText("Listen");
         listen_button.setToggleable(true);
 
+        record_button.setLookAndFeel(&modernStyle);
+        record_button.setButtonText("Record Analysis");
+        record_button.setToggleable(true);
+
+        decimate_button.setLookAndFeel(&modernStyle);
+        decimate_button.setButtonText("Decimate To Range");
+        decimate_button.setToggleable(true);
+
+        transfer_button.setLookAndFeel(&modernStyle);
+        transfer_button.setButtonText("Transfer Function");
+        transfer_button.setToggleable(true);
+
+        // the text carries the level the governor is at.
+        adaptive_button.setLookAndFeel(&modernStyle);
+        adaptive_button.setToggleable(true);
+        governor.addChangeListener(this);
+        changeListenerCallback(&governor);
+
+        perf_hud_button.setLookAndFeel(&modernStyle);
+        perf_hud_button.setButtonText("Performance HUD");
+        perf_hud_button.setToggleable(true);
+        perf_hud_button.setClickingTogglesState(true);
+        perf_hud_button.onClick = [this] {
+            perf_hud.setVisible(perf_hud_button.getToggleState());
+            perf_hud.toFront(false);
+        };
+
+        perf_hud.setLookAndFeel(&modernStyle);
+        perf_hud.onClose = [this] {
+            perf_hud_button.setToggleState(false, dontSendNotification);
+            perf_hud.setVisible(false);
+        };
+
         // Style heading labels
         for (auto label_ : {
                 &global_settings_label,
@@ -159,6 +283,8 @@ public:
                 &colourmap_bias_slider_label,
                 &colourmap_curve_slider_label,
                 &volume_rms_time_label,
+                &kaiser_beta_slider_label,
+                &gonio_history_slider_label,
                 &freq_rng_min_label,
                 &freq_rng_max_label,
                 &listen_button_label,
@@ -167,7 +293,15 @@ public:
                 &scrollmode_combobox_label,
                 &fftorder_combobox_label,
                 &spec_history_multiply_slider_label,
-                &measure_combobox_label
+                &measure_combobox_label,
+                &transfer_avg_combobox_label,
+                &phase_combobox_label,
+                &zeropad_combobox_label,
+                &window_combobox_label,
+                &meter_combobox_label,
+                &gonio_combobox_label,
+                &bands_combobox_label,
+                &trigger_combobox_label
             })
         {
             label_->setColour(Label::ColourIds::textColourId, Colour(0xffcccccc));
@@ -212,6 +346,14 @@ public:
             std::make_unique<SliderParameterAttachment>(
                 *apvts_ref.getParameter("v_rms_time"),
                 volume_rms_time_slider);
+        kaiser_beta_slider_attachment =
+            std::make_unique<SliderParameterAttachment>(
+                *apvts_ref.getParameter("gb_kaiser_beta"),
+                kaiser_beta_slider);
+        gonio_history_slider_attachment =
+            std::make_unique<SliderParameterAttachment>(
+                *apvts_ref.getParameter("v_gonio_ms"),
+                gonio_history_slider);
         spec_history_multiply_slider_attachment =
             std::make_unique<SliderParameterAttachment>(
                 *apvts_ref.getParameter("sp_multiple"),
@@ -232,21 +374,75 @@ public:
         measure_combobox_attachment =
             std::make_unique<ComboBoxParameterAttachment>
             (*apvts_ref.getParameter("sp_measure"), measure_combobox);
+        transfer_avg_combobox_attachment =
+            std::make_unique<ComboBoxParameterAttachment>
+            (*apvts_ref.getParameter("gb_tf_avg"), transfer_avg_combobox);
+        phase_combobox_attachment =
+            std::make_unique<ComboBoxParameterAttachment>
+            (*apvts_ref.getParameter("sg_phase"), phase_combobox);
+        zeropad_combobox_attachment =
+            std::make_unique<ComboBoxParameterAttachment>
+            (*apvts_ref.getParameter("gb_zero_pad"), zeropad_combobox);
+        window_combobox_attachment =
+            std::make_unique<ComboBoxParameterAttachment>
+            (*apvts_ref.getParameter("gb_window"), window_combobox);
+        meter_combobox_attachment =
+            std::make_unique<ComboBoxParameterAttachment>
+            (*apvts_ref.getParameter("v_meter"), meter_combobox);
+        gonio_combobox_attachment =
+            std::make_unique<ComboBoxParameterAttachment>
+            (*apvts_ref.getParameter("v_gonio"), gonio_combobox);
+        bands_combobox_attachment =
+            std::make_unique<ComboBoxParameterAttachment>
+            (*apvts_ref.getParameter("v_bands"), bands_combobox);
+        trigger_combobox_attachment =
+            std::make_unique<ComboBoxParameterAttachment>
+            (*apvts_ref.getParameter("os_trig"), trigger_combobox);
 
         listen_button_attachment =
             std::make_unique<ButtonParameterAttachment>
             (*apvts_ref.getParameter("gb_listen"), listen_button);
+        record_button_attachment =
+            std::make_unique<ButtonParameterAttachment>
+            (*apvts_ref.getParameter("gb_record"), record_button);
+        decimate_button_attachment =
+            std::make_unique<ButtonParameterAttachment>
+            (*apvts_ref.getParameter("gb_decimate"), decimate_button);
+        transfer_button_attachment =
+            std::make_unique<ButtonParameterAttachment>
+            (*apvts_ref.getParameter("gb_transfer"), transfer_button);
+        adaptive_button_attachment =
+            std::make_unique<ButtonParameterAttachment>
+            (*apvts_ref.getParameter("gb_adaptive"), adaptive_button);
+
+        // the averaging only applies while the transfer function is measured,
+        // the attachment clicks the button on automation too.
+        transfer_button.onClick = [this] {
+            transfer_avg_combobox.setEnabled(transfer_button.getToggleState());
+            transfer_avg_combobox_label.setEnabled(transfer_button.getToggleState());
+        };
+        transfer_button.onClick();
     }
 
     ~settingsPage()
     {
+        governor.removeChangeListener(this);
+
         // Clean up look and feel
         for (auto box_ : {
                 &colourmap_combobox,
                 &channel_combobox,
                 &scrollmode_combobox,
                 &fftorder_combobox,
-                &measure_combobox
+                &measure_combobox,
+                &trigger_combobox,
+                &bands_combobox,
+                &gonio_combobox,
+                &meter_combobox,
+                &window_combobox,
+                &zeropad_combobox,
+                &phase_combobox,
+                &transfer_avg_combobox
             })
         {
             box_->setLookAndFeel(nullptr);
@@ -262,6 +458,8 @@ public:
                 &colourmap_bias_slider,
                 &colourmap_curve_slider,
                 &volume_rms_time_slider,
+                &kaiser_beta_slider,
+                &gonio_history_slider,
                 &spec_history_multiply_slider
             })
         {
@@ -269,6 +467,12 @@ public:
         }
 
         listen_button.setLookAndFeel(nullptr);
+        record_button.setLookAndFeel(nullptr);
+        decimate_button.setLookAndFeel(nullptr);
+        transfer_button.setLookAndFeel(nullptr);
+        adaptive_button.setLookAndFeel(nullptr);
+        perf_hud_button.setLookAndFeel(nullptr);
+        perf_hud.setLookAndFeel(nullptr);
     }
 
     void paint(Graphics& g) override
@@ -280,28 +484,31 @@ public:
     void resized() override
     {
         auto bounds = getLocalBounds();
-        auto totalHeight = bounds.getHeight();
-        
-        // Calculate responsive sizes based on component height
-        auto itemHeight = totalHeight * 0.025f;
-        auto labelHeight = totalHeight * 0.025f;
-        auto headingHeight = totalHeight * 0.045f;
-        auto sectionSpacing = totalHeight * 0.005f;
-        auto itemSpacing = totalHeight * 0.0001f;
-        auto sidePadding = bounds.getWidth() * 0.02f;
-        auto verticalPadding = totalHeight * 0.02f;
-        
+        perf_hud.setBounds(bounds);
+        viewport.setBounds(bounds);
+
+        // fixed row heights, the viewport scrolls whatever doesn't fit.
+        const int itemHeight = 24;
+        const int labelHeight = 18;
+        const int headingHeight = 32;
+        const int sectionSpacing = 10;
+        const int itemSpacing = 2;
+        const int sidePadding = roundToInt(bounds.getWidth() * 0.02f);
+        const int verticalPadding = 12;
+
+        // laid out from the top of an open ended content, cut to the rows used below.
+        const int contentWidth = bounds.getWidth() - viewport.getScrollBarThickness();
+        bounds = Rectangle<int>(0, 0, contentWidth, 1 << 16);
         bounds.reduce(sidePadding, verticalPadding);
 
         // Helper lambda for adding label + control pairs
         auto addLabeledControl = [&](Label& label, Component& control) {
             label.setBounds(bounds.removeFromTop(labelHeight));
-            bounds.removeFromTop(itemSpacing * 0.3f);
             control.setBounds(bounds.removeFromTop(itemHeight));
             bounds.removeFromTop(itemSpacing);
         };
 
-        // Set responsive fonts
+        // Set fonts
         auto regularFontSize = labelHeight * 0.7f;
         auto headingFontSize = headingHeight * 0.5f;
         
@@ -315,12 +522,22 @@ public:
                 &colourmap_bias_slider_label,
                 &colourmap_curve_slider_label,
                 &volume_rms_time_label,
+                &kaiser_beta_slider_label,
+                &gonio_history_slider_label,
                 &listen_button_label,
                 &colourmap_combobox_label,
                 &channel_combobox_label,
                 &scrollmode_combobox_label,
                 &fftorder_combobox_label,
                 &measure_combobox_label,
+                &transfer_avg_combobox_label,
+                &phase_combobox_label,
+                &zeropad_combobox_label,
+                &window_combobox_label,
+                &meter_combobox_label,
+                &gonio_combobox_label,
+                &bands_combobox_label,
+                &trigger_combobox_label,
                 &spec_history_multiply_slider_label
             })
         {
@@ -351,6 +568,8 @@ public:
                 &colourmap_bias_slider,
                 &colourmap_curve_slider,
                 &volume_rms_time_slider,
+                &kaiser_beta_slider,
+                &gonio_history_slider,
                 &spec_history_multiply_slider
             })
         {
@@ -359,46 +578,82 @@ public:
 
         // Layout sections
         global_settings_label.setBounds(bounds.removeFromTop(headingHeight));
-        bounds.removeFromTop(itemSpacing * 1.5f);
+        bounds.removeFromTop(itemSpacing);
 
         addLabeledControl(accent_colour_slider_label, accent_colour_slider);
         addLabeledControl(colourmap_combobox_label, colourmap_combobox);
         addLabeledControl(channel_combobox_label, channel_combobox);
         addLabeledControl(scrollmode_combobox_label, scrollmode_combobox);
         addLabeledControl(fftorder_combobox_label, fftorder_combobox);
+        addLabeledControl(window_combobox_label, window_combobox);
+        addLabeledControl(kaiser_beta_slider_label, kaiser_beta_slider);
+        addLabeledControl(zeropad_combobox_label, zeropad_combobox);
         
         listen_button.setBounds(bounds.removeFromTop(itemHeight));
+        record_button.setBounds(bounds.removeFromTop(itemHeight));
+        decimate_button.setBounds(bounds.removeFromTop(itemHeight));
+        adaptive_button.setBounds(bounds.removeFromTop(itemHeight));
+        perf_hud_button.setBounds(bounds.removeFromTop(itemHeight));
         bounds.removeFromTop(sectionSpacing);
 
         analyser_settings_label.setBounds(bounds.removeFromTop(headingHeight));
-        bounds.removeFromTop(itemSpacing * 1.5f);
+        bounds.removeFromTop(itemSpacing);
 
         addLabeledControl(freq_rng_min_label, freq_rng_min_slider);
         addLabeledControl(freq_rng_max_label, freq_rng_max_slider);
         addLabeledControl(num_bars_slider_label, num_bars_slider);
         addLabeledControl(bar_speed_slider_label, bar_speed_slider);
+        transfer_button.setBounds(bounds.removeFromTop(itemHeight));
+        addLabeledControl(transfer_avg_combobox_label, transfer_avg_combobox);
 
         bounds.removeFromTop(sectionSpacing);
         spectrogram_settings_label.setBounds(bounds.removeFromTop(headingHeight));
-        bounds.removeFromTop(itemSpacing * 1.5f);
+        bounds.removeFromTop(itemSpacing);
         
         addLabeledControl(colourmap_curve_slider_label, colourmap_curve_slider);
         addLabeledControl(colourmap_bias_slider_label, colourmap_bias_slider);
+        addLabeledControl(phase_combobox_label, phase_combobox);
         addLabeledControl(measure_combobox_label, measure_combobox);
         addLabeledControl(spec_history_multiply_slider_label, spec_history_multiply_slider);
 
         bounds.removeFromTop(sectionSpacing);
         correlation_settings_label.setBounds(bounds.removeFromTop(headingHeight));
-        bounds.removeFromTop(itemSpacing * 1.5f);
+        bounds.removeFromTop(itemSpacing);
         
         addLabeledControl(volume_rms_time_label, volume_rms_time_slider);
+        addLabeledControl(meter_combobox_label, meter_combobox);
+        addLabeledControl(bands_combobox_label, bands_combobox);
+        addLabeledControl(gonio_combobox_label, gonio_combobox);
+        addLabeledControl(gonio_history_slider_label, gonio_history_slider);
+
+        bounds.removeFromTop(sectionSpacing);
+        ocsilloscope_settings_label.setBounds(bounds.removeFromTop(headingHeight));
+        bounds.removeFromTop(itemSpacing);
+
+        addLabeledControl(trigger_combobox_label, trigger_combobox);
+
+        content.setSize(contentWidth, bounds.getY() + verticalPadding);
     }
 
 private:
+
+    void changeListenerCallback(ChangeBroadcaster*) override
+    {
+        const int level = governor.getLevel();
+
+        adaptive_button.setButtonText(level == 0
+            ? String("Adaptive Quality (full)")
+            : "Adaptive Quality (reduced " + String(level) + "/" + String(GOVERNOR_MAX_LEVEL) + ")");
+    }
+
     AudioProcessorValueTreeState& apvts_ref;
+    QualityGovernor& governor;
 
     ModernLookAndFeel modernStyle;
 
+    Viewport viewport;
+    Component content;
+
     Label
         global_settings_label,
         analyser_settings_label,
@@ -414,13 +669,23 @@ private:
         colourmap_bias_slider_label,
         colourmap_curve_slider_label,
         volume_rms_time_label,
+        kaiser_beta_slider_label,
+        gonio_history_slider_label,
         listen_button_label,
         colourmap_combobox_label,
         channel_combobox_label,
         scrollmode_combobox_label,
         fftorder_combobox_label,
         spec_history_multiply_slider_label,
-        measure_combobox_label;
+        measure_combobox_label,
+        trigger_combobox_label,
+        bands_combobox_label,
+        gonio_combobox_label,
+        meter_combobox_label,
+        window_combobox_label,
+        zeropad_combobox_label,
+        phase_combobox_label,
+        transfer_avg_combobox_label;
 
     Slider
         accent_colour_slider,
@@ -432,17 +697,34 @@ private:
         colourmap_bias_slider,
         colourmap_curve_slider,
         volume_rms_time_slider,
+        kaiser_beta_slider,
+        gonio_history_slider,
         spec_history_multiply_slider;
 
     ToggleButton
-        listen_button;
+        listen_button,
+        record_button,
+        decimate_button,
+        transfer_button,
+        adaptive_button,
+        perf_hud_button;
+
+    PerfHud perf_hud;
 
     ComboBox
         colourmap_combobox,
         measure_combobox,
         channel_combobox,
         scrollmode_combobox,
-        fftorder_combobox;
+        fftorder_combobox,
+        trigger_combobox,
+        bands_combobox,
+        gonio_combobox,
+        meter_combobox,
+        window_combobox,
+        zeropad_combobox,
+        phase_combobox,
+        transfer_avg_combobox;
 
     std::unique_ptr<SliderParameterAttachment>
         accent_colour_slider_attachment,
@@ -454,6 +736,8 @@ private:
         colourmap_bias_slider_attachment,
         colourmap_curve_slider_attachment,
         volume_rms_time_slider_attachment,
+        kaiser_beta_slider_attachment,
+        gonio_history_slider_attachment,
         spec_history_multiply_slider_attachment;
 
     std::unique_ptr<ComboBoxParameterAttachment>
@@ -461,10 +745,22 @@ private:
         channel_combobox_attachment,
         scrollmode_combobox_attachment,
         fftorder_combobox_attachment,
-        measure_combobox_attachment;
+        measure_combobox_attachment,
+        trigger_combobox_attachment,
+        bands_combobox_attachment,
+        gonio_combobox_attachment,
+        meter_combobox_attachment,
+        window_combobox_attachment,
+        zeropad_combobox_attachment,
+        phase_combobox_attachment,
+        transfer_avg_combobox_attachment;
 
     std::unique_ptr<ButtonParameterAttachment>
-        listen_button_attachment;
+        listen_button_attachment,
+        record_button_attachment,
+        decimate_button_attachment,
+        transfer_button_attachment,
+        adaptive_button_attachment;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(settingsPage)
 };
\ No newline at end of file
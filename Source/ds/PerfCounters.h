@@ -0,0 +1,321 @@
+#pragma once
+
+// Counters of the hot paths (audio callback, FFT workers, GL renders, timer
+// callbacks), read by the performance HUD and dumped as JSON.
+//
+// Writers only do relaxed atomic adds on fixed size histograms, never lock,
+// allocate or make a system call besides reading the steady clock, so they
+// are safe on the audio thread. Every thread writes its own set of
+// histograms, picked by a hash of its id, so the audio thread, the FFT
+// workers and the GL threads don't pass cache lines around; readers merge
+// the sets. Should two threads land on the same set the adds are still
+// atomic, only the sharing comes back. A reader sees every bucket whole
+// but not necessarily the same instant of all of them, fine for a HUD.
+//
+// Free of any juce dependency.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+// 4 buckets per octave, from 0 up to 2^33, ~19% wide at most.
+#define PERF_SUB_BUCKETS 4
+#define PERF_NUM_BUCKETS 128
+// sets of histograms, one per writing thread.
+#define PERF_MAX_THREADS 16
+
+enum PerfMetric
+{
+    PerfAudioCallback,   // us, processBlock.
+    PerfAudioLoad,       // %, processBlock against the block's duration.
+    PerfFFTLatency,      // us, a batch from its submission to its result.
+    PerfFFTQueueDepth,   // batches submitted and not yet done, at submission.
+    PerfGLRender,        // us, a renderOpenGL call.
+    PerfGLUpload,        // bytes sent to the GPU by a renderOpenGL call.
+    PerfTimerCallback,   // us, a view's timerCallback on the message thread.
+    PerfNumMetrics
+};
+
+enum PerfCounter
+{
+    PerfFramesDropped,       // FFT frames overwritten before they were read, or turned away by a full queue.
+    PerfScopeBlocksDropped,  // audio blocks the oscilloscope's fifo had no room for.
+    PerfNumCounters
+};
+
+// a histogram merged from the writers' sets, plain values for the readers.
+class PerfHistogramSnapshot
+{
+public:
+
+    uint64_t getCount() const { return count; }
+    uint64_t getMax() const { return max; }
+
+    double getMean() const
+    {
+        return count > 0 ? (double) sum / (double) count : 0.0;
+    }
+
+    // upper edge of the bucket the `p` quantile (0 - 1) falls in, 0 when empty.
+    uint64_t getPercentile(double p) const;
+
+private:
+
+    friend class PerfHistogram;
+
+    std::array<uint64_t, PERF_NUM_BUCKETS> buckets {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+};
+
+class PerfHistogram
+{
+public:
+
+    void record(uint64_t value)
+    {
+        buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t previous = max.load(std::memory_order_relaxed);
+        while (value > previous
+               && !max.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+    }
+
+    void mergeInto(PerfHistogramSnapshot& snapshot) const
+    {
+        // the count is the sum of the buckets, so the percentiles always add up.
+        for (int b = 0; b < PERF_NUM_BUCKETS; ++b)
+        {
+            const uint64_t n = buckets[b].load(std::memory_order_relaxed);
+            snapshot.buckets[b] += n;
+            snapshot.count += n;
+        }
+
+        snapshot.sum += sum.load(std::memory_order_relaxed);
+        snapshot.max = std::max(snapshot.max, max.load(std::memory_order_relaxed));
+    }
+
+    void reset()
+    {
+        for (auto& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+
+        sum.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    static int bucketOf(uint64_t value)
+    {
+        if (value < PERF_SUB_BUCKETS)
+            return (int) value;
+
+        int octave = 63 - countLeadingZeros(value);
+        int sub = (int) (value >> (octave - 2)) & (PERF_SUB_BUCKETS - 1);
+
+        return std::min(PERF_SUB_BUCKETS * (octave - 1) + sub, PERF_NUM_BUCKETS - 1);
+    }
+
+    static uint64_t lowerEdge(int bucket)
+    {
+        if (bucket < PERF_SUB_BUCKETS)
+            return (uint64_t) bucket;
+
+        int octave = bucket / PERF_SUB_BUCKETS + 1;
+        int sub = bucket % PERF_SUB_BUCKETS;
+
+        return (uint64_t) (PERF_SUB_BUCKETS + sub) << (octave - 2);
+    }
+
+private:
+
+    static int countLeadingZeros(uint64_t value)
+    {
+        int n = 0;
+        for (uint64_t bit = 1ull << 63; bit != 0 && (value & bit) == 0; bit >>= 1) ++n;
+        return n;
+    }
+
+    std::array<std::atomic<uint64_t>, PERF_NUM_BUCKETS> buckets {};
+    std::atomic<uint64_t> sum { 0 };
+    std::atomic<uint64_t> max { 0 };
+};
+
+inline uint64_t PerfHistogramSnapshot::getPercentile(double p) const
+{
+    if (count == 0)
+        return 0;
+
+    uint64_t target = (uint64_t) (p * (double) (count - 1)) + 1;
+    uint64_t seen = 0;
+
+    for (int b = 0; b < PERF_NUM_BUCKETS; ++b)
+    {
+        seen += buckets[b];
+        if (seen >= target)
+            return std::min(PerfHistogram::lowerEdge(b + 1) - 1, max);
+    }
+
+    return max;
+}
+
+class PerfCounters
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    static Clock::time_point now() { return Clock::now(); }
+
+    static uint64_t microsecondsSince(Clock::time_point start)
+    {
+        return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(now() - start).count();
+    }
+
+    void record(PerfMetric metric, uint64_t value) { sets[threadSet()].histograms[metric].record(value); }
+
+    void add(PerfCounter counter, uint64_t amount = 1)
+    {
+        counters[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    // the sets of all threads merged.
+    PerfHistogramSnapshot get(PerfMetric metric) const
+    {
+        PerfHistogramSnapshot snapshot;
+
+        for (const auto& set : sets)
+            set.histograms[metric].mergeInto(snapshot);
+
+        return snapshot;
+    }
+
+    uint64_t get(PerfCounter counter) const { return counters[counter].load(std::memory_order_relaxed); }
+
+    void reset()
+    {
+        for (auto& set : sets)
+            for (auto& histogram : set.histograms) histogram.reset();
+
+        for (auto& counter : counters) counter.store(0, std::memory_order_relaxed);
+    }
+
+    static const char* getName(PerfMetric metric)
+    {
+        static const char* names[PerfNumMetrics] = {
+            "audio_callback", "audio_load", "fft_latency", "fft_queue_depth",
+            "gl_render", "gl_upload", "timer_callback"
+        };
+        return names[metric];
+    }
+
+    static const char* getUnit(PerfMetric metric)
+    {
+        static const char* units[PerfNumMetrics] = { "us", "%", "us", "batches", "us", "bytes", "us" };
+        return units[metric];
+    }
+
+    static const char* getName(PerfCounter counter)
+    {
+        static const char* names[PerfNumCounters] = { "fft_frames_dropped", "scope_blocks_dropped" };
+        return names[counter];
+    }
+
+    std::string toJSON() const
+    {
+        std::string json = "{\n  \"metrics\": {";
+
+        for (int m = 0; m < PerfNumMetrics; ++m)
+        {
+            const auto h = get((PerfMetric) m);
+
+            json += std::string(m > 0 ? ",\n    \"" : "\n    \"") + getName((PerfMetric) m) + "\": { "
+                  + "\"unit\": \"" + getUnit((PerfMetric) m) + "\""
+                  + ", \"count\": " + std::to_string(h.getCount())
+                  + ", \"mean\": " + std::to_string(h.getMean())
+                  + ", \"p50\": " + std::to_string(h.getPercentile(0.5))
+                  + ", \"p90\": " + std::to_string(h.getPercentile(0.9))
+                  + ", \"p99\": " + std::to_string(h.getPercentile(0.99))
+                  + ", \"p999\": " + std::to_string(h.getPercentile(0.999))
+                  + ", \"max\": " + std::to_string(h.getMax())
+                  + " }";
+        }
+
+        json += "\n  },\n  \"counters\": {";
+
+        for (int c = 0; c < PerfNumCounters; ++c)
+            json += std::string(c > 0 ? ",\n    \"" : "\n    \"") + getName((PerfCounter) c) + "\": "
+                  + std::to_string(get((PerfCounter) c));
+
+        json += "\n  }\n}\n";
+        return json;
+    }
+
+private:
+
+    // the calling thread's set, its id hashed: no thread local storage, which
+    // may allocate on first use in some runtimes.
+    static int threadSet()
+    {
+        const uint64_t id = (uint64_t) std::hash<std::thread::id>()(std::this_thread::get_id());
+
+        // thread ids are often aligned addresses, the top bits of the product mix them all.
+        return (int) (((id * 0x9e3779b97f4a7c15ull) >> 32) % PERF_MAX_THREADS);
+    }
+
+    // a set per cache line boundary, threads don't share lines.
+    struct alignas(64) HistogramSet
+    {
+        std::array<PerfHistogram, PerfNumMetrics> histograms;
+    };
+
+    std::array<HistogramSet, PERF_MAX_THREADS> sets;
+    std::array<std::atomic<uint64_t>, PerfNumCounters> counters {};
+};
+
+// records how long its scope took, nothing when `counters` is null.
+class PerfScope
+{
+public:
+
+    PerfScope(PerfCounters* counters_, PerfMetric metric_)
+        : counters(counters_), metric(metric_)
+    {
+        if (counters) start = PerfCounters::now();
+    }
+
+    // an audio callback, also records its share of the block's duration.
+    PerfScope(PerfCounters* counters_, int num_samples, double sample_rate)
+        : PerfScope(counters_, PerfAudioCallback)
+    {
+        deadline_us = sample_rate > 0.0 ? (double) num_samples * 1e6 / sample_rate : 0.0;
+    }
+
+    ~PerfScope()
+    {
+        if (!counters)
+            return;
+
+        uint64_t elapsed = PerfCounters::microsecondsSince(start);
+        counters->record(metric, elapsed);
+
+        if (deadline_us > 0.0)
+            counters->record(PerfAudioLoad, (uint64_t) (100.0 * (double) elapsed / deadline_us));
+    }
+
+    PerfScope(const PerfScope&)            = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+
+    PerfCounters* counters;
+    PerfMetric metric;
+    PerfCounters::Clock::time_point start;
+    double deadline_us = 0.0;
+};
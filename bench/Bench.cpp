@@ -0,0 +1,487 @@
+// analytiks-bench : times the DSP hot paths of the plugin, headless.
+// The components are never put on screen, so none of them ever gets a peer
+// or an OpenGL context, only their data paths run.
+//
+//   analytiks-bench [--filter <text>] [--min-time <s>] [--out <file.json>]
+//
+//   --filter <text>   only the benchmarks whose name contains it.
+//   --min-time <s>    time spent per benchmark, default 0.1.
+//   --out <file>      where the JSON goes, default stdout.
+//
+// The JSON follows Google Benchmark's layout (context + benchmarks with
+// name, iterations, real_time, time_unit), so its compare tools work on it.
+// Each benchmark also reports `samples_per_second` where it takes audio.
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include <cstdio>
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#endif
+
+#include "PluginProcessor.h"
+#include "UI_Comp/DFT/DFT.h"
+#include "UI_Comp/Spectrogram/Spectrogram.h"
+#include "UI_Comp/Oscilloscope/Oscilloscope.h"
+#include "UI_Comp/Correlation/Correlation.h"
+
+using namespace juce;
+
+// calls between two untimed `settle`s, small enough that fifos never fill.
+#define BENCH_BATCH 16
+// frames in one worker batch, what a 4096 block at hop 512 gives.
+#define BENCH_WORKER_FRAMES 8
+
+static const int FFT_ORDERS[]   = { 9, 10, 11, 12, 13 };
+static const int BLOCK_SIZES[]  = { 16, 64, 256, 1024, 4096, 8192 };
+static const double SAMPLE_RATES[] = { 44100.0, 48000.0, 96000.0, 192000.0 };
+
+struct BenchResult
+{
+    String name;
+    int64 iterations = 0;
+    double ns_per_iteration = 0.0;
+    // 0 when the benchmark does not take audio.
+    double samples_per_second = 0.0;
+    // extra fields, Google Benchmark's user counters.
+    std::vector<std::pair<String, double>> counters;
+};
+
+class Bench
+{
+public:
+
+    Bench(const String& filter_text, double min_seconds)
+        : filter(filter_text), min_time(min_seconds) {}
+
+    // `body()` is one iteration, `settle()` runs untimed every BENCH_BATCH
+    // iterations (draining fifos, the message thread's part).
+    template <typename Body, typename Settle>
+    void run(const String& name, int samples_per_iteration, Body&& body, Settle&& settle)
+    {
+        if (!isSelected(name))
+            return;
+
+        // warm up caches, lazy allocations and the branch predictors.
+        for (int i = 0; i < BENCH_BATCH; ++i) body();
+        settle();
+
+        const int64 min_ticks = (int64) (min_time * (double) Time::getHighResolutionTicksPerSecond());
+        int64 ticks = 0, iterations = 0;
+
+        while (ticks < min_ticks)
+        {
+            const int64 start = Time::getHighResolutionTicks();
+            for (int i = 0; i < BENCH_BATCH; ++i) body();
+            ticks += Time::getHighResolutionTicks() - start;
+
+            iterations += BENCH_BATCH;
+            settle();
+        }
+
+        BenchResult result;
+        result.name = name;
+        result.iterations = iterations;
+        result.ns_per_iteration = Time::highResolutionTicksToSeconds(ticks) * 1e9 / (double) iterations;
+
+        if (samples_per_iteration > 0)
+            result.samples_per_second = (double) samples_per_iteration * 1e9 / result.ns_per_iteration;
+
+        std::cerr << name << "  " << String(result.ns_per_iteration, 1) << " ns\n";
+        results.push_back(result);
+    }
+
+    template <typename Body>
+    void run(const String& name, int samples_per_iteration, Body&& body)
+    {
+        run(name, samples_per_iteration, std::forward<Body>(body), [] {});
+    }
+
+    bool isSelected(const String& name) const { return filter.isEmpty() || name.contains(filter); }
+
+    // adds `key` to the last benchmark that ran, nothing when it was filtered out.
+    void addCounter(const String& name, const String& key, double value)
+    {
+        if (!results.empty() && results.back().name == name)
+            results.back().counters.emplace_back(key, value);
+    }
+
+    void writeJSON(OutputStream& out) const
+    {
+        out << "{\n  \"context\": {"
+            << "\n    \"date\": " << JSON::toString(Time::getCurrentTime().toISO8601(true))
+            << ",\n    \"host_name\": " << JSON::toString(SystemStats::getComputerName())
+            << ",\n    \"executable\": \"analytiks-bench\""
+            << ",\n    \"num_cpus\": " << SystemStats::getNumCpus()
+            << ",\n    \"mhz_per_cpu\": " << SystemStats::getCpuSpeedInMegahertz()
+            << ",\n    \"pffft_simd_size\": " << pffft_simd_size()
+           #if defined(NDEBUG)
+            << ",\n    \"library_build_type\": \"release\""
+           #else
+            << ",\n    \"library_build_type\": \"debug\""
+           #endif
+            << "\n  },\n  \"benchmarks\": [";
+
+        for (size_t k = 0; k < results.size(); ++k)
+        {
+            const auto& r = results[k];
+
+            out << (k > 0 ? ",\n    " : "\n    ")
+                << "{ \"name\": " << JSON::toString(r.name)
+                << ", \"run_name\": " << JSON::toString(r.name)
+                << ", \"run_type\": \"iteration\""
+                << ", \"iterations\": " << r.iterations
+                << ", \"real_time\": " << String(r.ns_per_iteration, 3)
+                << ", \"cpu_time\": " << String(r.ns_per_iteration, 3)
+                << ", \"time_unit\": \"ns\"";
+
+            if (r.samples_per_second > 0.0)
+                out << ", \"samples_per_second\": " << String(r.samples_per_second, 0);
+
+            for (const auto& counter : r.counters)
+                out << ", " << JSON::toString(counter.first) << ": " << String(counter.second, 0);
+
+            out << " }";
+        }
+
+        out << "\n  ]\n}\n";
+    }
+
+private:
+
+    String filter;
+    double min_time;
+    std::vector<BenchResult> results;
+};
+
+// deterministic noise, the same input on every run.
+static void fillNoise(float* data, int num, int seed)
+{
+    Random random(seed);
+    for (int i = 0; i < num; ++i)
+        data[i] = random.nextFloat() * 2.0f - 1.0f;
+}
+
+static void setChoice(AudioProcessorValueTreeState& apvts, const String& id, int index)
+{
+    if (auto* param = apvts.getParameter(id))
+        param->setValueNotifyingHost(param->convertTo0to1((float) index));
+}
+
+// ── FFT engine ───────────────────────────────────────────────────────────────
+static void benchFFT(Bench& bench, AudioProcessorValueTreeState& apvts)
+{
+    // room for a right channel 8192 samples behind the left one, and a
+    // transfer mode reference behind that.
+    std::vector<float> noise(8192 * 4);
+    fillNoise(noise.data(), (int) noise.size(), 1);
+
+    for (int order : FFT_ORDERS)
+    {
+        const int fft_size = 1 << order;
+        const int num_bins = fft_size / 2 + 1;
+        const String suffix = "/order:" + String(order);
+
+        FFTTables tables { std::make_shared<const FFTPlan>(order),
+                           std::make_shared<const WindowTable>(fft_size, WindowHann) };
+        WorkerFFTBuffers bufs;
+
+        // ordered spectrum of the noise, what the amplitudes are computed from.
+        std::vector<float> spectrum(fft_size), amplitudes(num_bins);
+        std::memcpy(bufs.input, noise.data(), sizeof(float) * fft_size);
+        pffft_transform_ordered(tables.plan->setup, bufs.input, spectrum.data(), bufs.work, PFFFT_FORWARD);
+
+        bench.run("PFFFT::calculateAmplitudesFromFFT" + suffix, 0, [&]
+        {
+            PFFFT::calculateAmplitudesFromFFT(spectrum.data(), amplitudes.data(), fft_size,
+                                              tables.window->amplitude_scale);
+        });
+
+        std::vector<FrameSnapshot> frames(BENCH_WORKER_FRAMES);
+        for (int f = 0; f < BENCH_WORKER_FRAMES; ++f)
+            frames[f].samples.assign(noise.begin() + f * 512, noise.begin() + f * 512 + 2 * fft_size);
+
+        FFTResult result;
+
+        bench.run("PFFFT::transformBatch" + suffix + "/frames:" + String(BENCH_WORKER_FRAMES), 0, [&]
+        {
+            PFFFT::transformBatch(frames, tables, bufs, result);
+        });
+
+        // with the reference plane of "gb_transfer", a third transform.
+        std::vector<FrameSnapshot> transfer_frames(BENCH_WORKER_FRAMES);
+        for (int f = 0; f < BENCH_WORKER_FRAMES; ++f)
+            transfer_frames[f].samples.assign(noise.begin() + f * 512, noise.begin() + f * 512 + 3 * fft_size);
+
+        bench.run("PFFFT::transformBatch" + suffix + "/transfer/frames:" + String(BENCH_WORKER_FRAMES), 0, [&]
+        {
+            PFFFT::transformBatch(transfer_frames, tables, bufs, result);
+        });
+
+        // what "sg_phase" adds per frame, the noise against itself delayed.
+        std::vector<float> spectrum_right(fft_size), scratch(num_bins), plane(num_bins);
+        std::memcpy(bufs.input, noise.data() + 8192, sizeof(float) * fft_size);
+        pffft_transform_ordered(tables.plan->setup, bufs.input, spectrum_right.data(), bufs.work, PFFFT_FORWARD);
+
+        for (int view = PhaseDifference; view < NumPhaseViews; ++view)
+        {
+            bench.run("computePhasePlane" + suffix + "/view:" + String(view), 0, [&]
+            {
+                computePhasePlane(spectrum.data(), spectrum_right.data(), fft_size, (PhaseView) view,
+                                  48000.0f, scratch.data(), plane.data());
+            });
+        }
+
+        // the same frames on the denser grids of "gb_zero_pad".
+        for (int pad = 1; pad <= FFT_MAX_ZERO_PAD_BITS && order + pad <= FFT_MAX_PADDED_ORDER; ++pad)
+        {
+            FFTTables padded { std::make_shared<const FFTPlan>(order + pad), tables.window };
+
+            bench.run("PFFFT::transformBatch" + suffix + "/pad:" + String(1 << pad) + "x/frames:"
+                          + String(BENCH_WORKER_FRAMES), 0, [&]
+            {
+                PFFFT::transformBatch(frames, padded, bufs, result);
+            });
+        }
+    }
+
+    // the filter ahead of the ring buffer at high rates, per factor.
+    for (int factor = 2; factor <= DECIMATOR_MAX_FACTOR; factor *= 2)
+    {
+        Decimator decimator;
+        decimator.setFactor(factor);
+        std::vector<float> decimated(DECIMATION_CHUNK);
+
+        bench.run("Decimator::process/factor:" + String(factor), DECIMATION_CHUNK, [&]
+        {
+            decimator.process(noise.data(), decimated.data(), DECIMATION_CHUNK);
+        });
+    }
+
+    // the audio thread's part: ring buffer, windowing and the submission.
+    // the workers run meanwhile, like they do in the plugin.
+    PFFFT engine(apvts);
+
+    for (int order : FFT_ORDERS)
+    {
+        setChoice(apvts, "gb_fft_ord", order - 9);
+        // the order's tables, built by the engine's timer in the plugin.
+        engine.timerCallback();
+
+        for (double SR : SAMPLE_RATES)
+        {
+            engine.prepareToPlay(SR, 8192);
+
+            for (int block : BLOCK_SIZES)
+            {
+                String name = "PFFFT::processBlock/order:" + String(order)
+                            + "/block:" + String(block) + "/sr:" + String((int) SR);
+
+                int offset = 0;
+
+                bench.run(name, block, [&]
+                {
+                    engine.processBlock(noise.data() + offset, noise.data() + offset + 8192, block,
+                                        120.0f, (float) SR, 4, 4);
+                    offset = (offset + block) % 8192;
+                },
+                [&]
+                {
+                    // what the 60 Hz timer would have picked up.
+                    engine.timerCallback();
+                });
+            }
+        }
+    }
+
+    Thread::sleep(100);
+    engine.timerCallback();
+}
+
+// ── spectrogram ──────────────────────────────────────────────────────────────
+static void benchSpectrogram(Bench& bench, AudioProcessorValueTreeState& apvts)
+{
+    SpectrogramComponent spectrogram(apvts);
+    spectrogram.setSize(1200, 600);
+
+    for (int order : FFT_ORDERS)
+    {
+        const int num_bins = (1 << order) / 2 + 1;
+
+        setChoice(apvts, "gb_fft_ord", order - 9);
+
+        std::array<std::array<std::vector<float>, MAX_ACCUMULATED>, NumAnalysisViews> data;
+        std::array<std::vector<float>, MAX_ACCUMULATED> phase;
+        for (int view = 0; view < NumAnalysisViews; ++view)
+        {
+            for (int f = 0; f < MAX_ACCUMULATED; ++f)
+            {
+                data[view][f].resize(num_bins);
+                fillNoise(data[view][f].data(), num_bins, 10 + view * MAX_ACCUMULATED + f);
+                for (auto& x : data[view][f]) x = 0.5f + 0.5f * x;
+            }
+        }
+
+        bench.run("SpectrogramComponent::newDataBatch/order:" + String(order)
+                  + "/frames:" + String(BENCH_WORKER_FRAMES), 0, [&]
+        {
+            spectrogram.newDataBatch(data, phase, PhaseOff, BENCH_WORKER_FRAMES, num_bins, 120.0f, 48000.0f, 4, 4);
+        },
+        [&]
+        {
+            spectrogram.timerCallback();
+        });
+    }
+}
+
+// ── oscilloscope and correlation ─────────────────────────────────────────────
+static void benchTimeDomain(Bench& bench, AudioProcessorValueTreeState& apvts)
+{
+    OscilloscopeComponent oscilloscope(apvts);
+    oscilloscope.setSize(1200, 400);
+
+    PhaseCorrelationAnalyserComponent correlation(apvts);
+    correlation.setSize(400, 400);
+
+    AudioBuffer<float> buffer(2, 8192);
+    fillNoise(buffer.getWritePointer(0), 8192, 2);
+    fillNoise(buffer.getWritePointer(1), 8192, 3);
+
+    for (double SR : SAMPLE_RATES)
+    {
+        correlation.prepareToPlay((float) SR, 8192.0f);
+
+        for (int block : BLOCK_SIZES)
+        {
+            const String suffix = "/block:" + String(block) + "/sr:" + String((int) SR);
+
+            bench.run("OscilloscopeComponent::newAudioBatch" + suffix, block, [&]
+            {
+                oscilloscope.newAudioBatch(buffer.getReadPointer(0), buffer.getReadPointer(1),
+                                           block, 120.0f, (float) SR, 4, 4);
+            },
+            [&]
+            {
+                oscilloscope.timerCallback();
+            });
+
+            AudioBuffer<float> view(buffer.getArrayOfWritePointers(), 2, block);
+
+            bench.run("PhaseCorrelationAnalyserComponent::processBlock" + suffix, block, [&]
+            {
+                correlation.processBlock(view);
+            },
+            [&]
+            {
+                correlation.timerCallback();
+            });
+        }
+    }
+}
+
+// ── instantiation ────────────────────────────────────────────────────────────
+// bytes the process has resident, 0 where it is not known.
+static double residentBytes()
+{
+   #if JUCE_LINUX
+    long pages = 0, resident = 0;
+    if (FILE* statm = std::fopen("/proc/self/statm", "r"))
+    {
+        if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(statm);
+    }
+    return (double) resident * (double) sysconf(_SC_PAGESIZE);
+   #elif JUCE_MAC
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+        return 0.0;
+    return (double) info.resident_size;
+   #else
+    return 0.0;
+   #endif
+}
+
+// one more instance next to the one main() holds, what a host loading the
+// plugin again pays: its construction time, and what it keeps resident.
+static void benchInstantiation(Bench& bench)
+{
+    const String name = "AnalytiksAudioProcessor::construct+destroy";
+
+    bench.run(name, 0, []
+    {
+        AnalytiksAudioProcessor instance;
+    });
+
+    if (!bench.isSelected(name))
+        return;
+
+    const int count = 8;
+    const double before = residentBytes();
+    {
+        std::vector<std::unique_ptr<AnalytiksAudioProcessor>> instances;
+        for (int k = 0; k < count; ++k)
+            instances.push_back(std::make_unique<AnalytiksAudioProcessor>());
+
+        bench.addCounter(name, "resident_bytes_per_instance", (residentBytes() - before) / count);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    String filter, out_path;
+    double min_time = 0.1;
+
+    for (int k = 1; k < argc; ++k)
+    {
+        String arg(argv[k]);
+        auto value = [&]() { return k + 1 < argc ? String(argv[++k]) : String(); };
+
+        if      (arg == "--filter")   filter   = value();
+        else if (arg == "--min-time") min_time = jlimit(0.001, 60.0, value().getDoubleValue());
+        else if (arg == "--out")      out_path = value();
+        else
+        {
+            std::cout << "usage: analytiks-bench [--filter text] [--min-time s] [--out file.json]\n";
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    // a message manager for the components, never a window.
+    ScopedJuceInitialiser_GUI juce_initialiser;
+
+    // owns the parameters every component reads.
+    AnalytiksAudioProcessor processor;
+    auto& apvts = processor.apvts;
+
+    Bench bench(filter, min_time);
+
+    benchFFT(bench, apvts);
+    benchSpectrogram(bench, apvts);
+    benchTimeDomain(bench, apvts);
+    benchInstantiation(bench);
+
+    if (out_path.isEmpty())
+    {
+        MemoryOutputStream json;
+        bench.writeJSON(json);
+        std::cout << json.toString();
+        return 0;
+    }
+
+    File out_file = File::getCurrentWorkingDirectory().getChildFile(out_path);
+    out_file.deleteFile();
+
+    FileOutputStream out(out_file);
+    if (out.failedToOpen())
+    {
+        std::cerr << "cannot write " << out_file.getFullPathName() << "\n";
+        return 1;
+    }
+
+    bench.writeJSON(out);
+    return 0;
+}
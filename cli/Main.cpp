@@ -0,0 +1,519 @@
+// analytiks-cli : runs audio files through the plugin's analysis engines
+// offline, as fast as the machine allows, and writes what the plugin would
+// show to disk. Meant for batch QC of stems on render nodes.
+//
+//   analytiks-cli [options] <file or directory>...
+//
+//   --out <dir>          where the results go, default next to each input.
+//   --format csv|json    default csv.
+//   --fft-order <9..13>  spectrogram FFT size is 2^order, default 11.
+//   --fft-window <name>  hann, blackman-harris, flat-top or kaiser, default hann.
+//   --kaiser-beta <b>    the kaiser window's beta, default 9.
+//   --window <ms>        correlation window, default 45 like the plugin.
+//   --bands <0|3|5|8>    multiband correlation, default off.
+//   --jobs <n>           files analysed at once, default all cores.
+//   --binary             also write <name>.anlt, see AnalysisRecorder.h.
+//
+// Per input <name> it writes <name>.meters.csv (loudness, true peak and
+// correlation every 100 ms) and <name>.spectrogram.csv (a row of bin levels
+// in dB per FFT frame), or a single <name>.json. A summary of every file
+// goes to summary.csv / summary.json in the output directory (or the
+// working directory). Exits with 1 when any file could not be analysed.
+//
+// Mono and stereo files only: the loudness of more channels needs the
+// BS.1770 weights of the surround channels, those files are reported as
+// not analysed. A mono file is metered as one channel, not as dual mono.
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include "UI_Comp/DFT/SpectrumEngine.h"
+#include "UI_Comp/Correlation/CorrelationMeter.h"
+#include "UI_Comp/VolumeMeter/LoudnessMeter.h"
+#include "UI_Comp/DFT/AnalysisRecorder.h"
+
+using namespace juce;
+
+#define CLI_BLOCK_SIZE 4096
+// the plugin's meters get a point this often.
+#define CLI_CHUNK_RATE_HZ 1200
+// momentary, short term, integrated, range, true peak, correlation, balance.
+#define CLI_BINARY_METERS 7
+
+struct Options
+{
+    File out_dir;
+    bool json = false;
+    int fft_order = 11;
+    AnalysisWindowType fft_window = WindowHann;
+    float kaiser_beta = WINDOW_DEFAULT_KAISER_BETA;
+    double window_ms = 45.0;
+    int bands = 0;
+    int jobs = SystemStats::getNumCpus();
+    bool binary = false;
+};
+
+struct FileSummary
+{
+    File file;
+    bool ok = false;
+    String error;
+
+    double duration = 0.0;
+    double sample_rate = 0.0;
+    int channels = 0;
+
+    float integrated = -std::numeric_limits<float>::infinity();
+    float range = 0.0f;
+    float true_peak_max = -std::numeric_limits<float>::infinity();
+    float momentary_max = -std::numeric_limits<float>::infinity();
+    float short_term_max = -std::numeric_limits<float>::infinity();
+
+    // over the chunks where either channel was above the noise gate.
+    float correlation_mean = 0.0f;
+    float correlation_min = 1.0f;
+};
+
+static String number(float value)
+{
+    return std::isfinite(value) ? String(value, 2) : String("-inf");
+}
+
+static String jsonNumber(float value)
+{
+    return std::isfinite(value) ? String(value, 2) : String("null");
+}
+
+static FileSummary analyseFile(const File& file, const Options& options)
+{
+    FileSummary summary;
+    summary.file = file;
+
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<AudioFormatReader> reader(formats.createReaderFor(file));
+
+    if (reader == nullptr)
+    {
+        summary.error = "unsupported or unreadable file";
+        return summary;
+    }
+
+    const double SR = reader->sampleRate;
+    const int num_channels = (int) reader->numChannels;
+    const int64 length = reader->lengthInSamples;
+
+    summary.sample_rate = SR;
+    summary.channels = num_channels;
+    summary.duration = SR > 0.0 ? (double) length / SR : 0.0;
+
+    if (num_channels > 2)
+    {
+        summary.error = String(num_channels) + " channels, only mono and stereo are metered";
+        return summary;
+    }
+
+    File dir = options.out_dir == File() ? file.getParentDirectory() : options.out_dir;
+    String stem = file.getFileNameWithoutExtension();
+
+    File meters_file = dir.getChildFile(stem + (options.json ? ".json" : ".meters.csv"));
+    File spectrogram_file = dir.getChildFile(stem + ".spectrogram.csv");
+
+    meters_file.deleteFile();
+    FileOutputStream meters_out(meters_file);
+
+    std::unique_ptr<FileOutputStream> spectrogram_out;
+    if (!options.json)
+    {
+        spectrogram_file.deleteFile();
+        spectrogram_out = std::make_unique<FileOutputStream>(spectrogram_file);
+    }
+
+    if (meters_out.failedToOpen() || (spectrogram_out && spectrogram_out->failedToOpen()))
+    {
+        summary.error = "cannot write to " + dir.getFullPathName();
+        return summary;
+    }
+
+    SpectrumEngine spectrum(options.fft_order, HOP_SIZE, options.fft_window, options.kaiser_beta);
+
+    AnalysisRecorder recorder;
+    if (options.binary
+        && !recorder.open(dir.getChildFile(stem + ".anlt").getFullPathName().toStdString(),
+                          SR, spectrum.getFFTSize(), spectrum.getHopSize(), true, CLI_BINARY_METERS))
+    {
+        summary.error = "cannot write to " + dir.getFullPathName();
+        return summary;
+    }
+
+    // the recorder takes columns as vectors, one batch per frame here.
+    std::vector<float> binary_column;
+    uint64 binary_sequence = 0;
+
+    CorrelationMeter correlation;
+    correlation.prepare(SR, options.window_ms * 0.001, CLI_CHUNK_RATE_HZ);
+    correlation.setWindow(options.window_ms * 0.001);
+    correlation.setBands(options.bands);
+
+    LoudnessMeter loudness;
+    loudness.prepare(SR);
+
+    AudioBuffer<float> buffer(std::max(num_channels, 2), CLI_BLOCK_SIZE);
+    std::vector<float> left(CLI_BLOCK_SIZE), right(CLI_BLOCK_SIZE), mid(CLI_BLOCK_SIZE);
+
+    // the missing channel of a mono file, so its loudness is not counted twice.
+    std::vector<float> silence(CLI_BLOCK_SIZE, 0.0f);
+
+    // the meters go in spans that end on the loudness steps, one step per call
+    // whatever the sample rate, and each row is timed by the samples metered.
+    const int loudness_step = std::max(1, (int) std::lround(SR * LOUDNESS_STEP_S));
+
+    double correlation_sum = 0.0;
+    int64 correlation_count = 0;
+
+    int64 spectrum_frames = 0;
+    int64 loudness_steps = 0;
+
+    // ── headers ──────────────────────────────────────────────────────────
+    if (options.json)
+    {
+        meters_out << "{\n  \"file\": " << JSON::toString(file.getFullPathName())
+                   << ",\n  \"sample_rate\": " << String(SR)
+                   << ",\n  \"fft_size\": " << spectrum.getFFTSize()
+                   << ",\n  \"hop_size\": " << spectrum.getHopSize()
+                   << ",\n  \"meters\": [";
+    }
+    else
+    {
+        meters_out << "time,momentary,short_term,integrated,range,true_peak,correlation,balance";
+        for (int b = 0; b < options.bands; ++b)
+            meters_out << ",band" << b << "_correlation";
+        meters_out << "\n";
+
+        *spectrogram_out << "time";
+        for (int bin = 0; bin < spectrum.getNumBins(); ++bin)
+            *spectrogram_out << "," << String(bin * SR / spectrum.getFFTSize(), 1);
+        *spectrogram_out << "\n";
+    }
+
+    // the spectrogram rows of the json go after the meters, kept aside meanwhile.
+    MemoryOutputStream json_spectrogram;
+
+    for (int64 position = 0; position < length; position += CLI_BLOCK_SIZE)
+    {
+        const int num = (int) std::min<int64>(CLI_BLOCK_SIZE, length - position);
+
+        reader->read(&buffer, 0, num, position, true, true);
+
+        const float* l = buffer.getReadPointer(0);
+        const float* r = buffer.getReadPointer(num_channels > 1 ? 1 : 0);
+
+        // the plugin meters the clipped signal, loudness gets the overs.
+        for (int i = 0; i < num; ++i)
+        {
+            left[i]  = std::clamp((l[i] == l[i]) ? l[i] : 0.0f, -1.0f, 1.0f);
+            right[i] = std::clamp((r[i] == r[i]) ? r[i] : 0.0f, -1.0f, 1.0f);
+            mid[i]   = 0.5f * (left[i] + right[i]);
+        }
+
+        spectrum.process(mid.data(), num, [&](const float* amplitudes, int num_bins)
+        {
+            // frame ends at the sample that completed it.
+            double time = (double) (spectrum_frames * spectrum.getHopSize() + spectrum.getFFTSize()) / SR;
+
+            OutputStream& out = options.json ? (OutputStream&) json_spectrogram : *spectrogram_out;
+
+            if (options.json)
+                out << (spectrum_frames > 0 ? ",\n    [" : "\n    [") << String(time, 4);
+            else
+                out << String(time, 4);
+
+            for (int bin = 0; bin < num_bins; ++bin)
+                out << "," << String(amplitudes[bin] * 80.0f - 80.0f, 1);
+
+            out << (options.json ? "]" : "\n");
+            ++spectrum_frames;
+
+            if (recorder.isOpen())
+            {
+                binary_column.assign(amplitudes, amplitudes + num_bins);
+                recorder.appendSpectrogram(binary_sequence++, &binary_column, 1);
+            }
+        });
+
+        for (int offset = 0; offset < num; )
+        {
+            const int span = std::min(num - offset, loudness_step - (int) ((position + offset) % loudness_step));
+
+            correlation.process(left.data() + offset, right.data() + offset, span,
+                                [&](const CorrelationReadings& readings)
+            {
+                if (readings.rms_left + readings.rms_right > 0.0f)
+                {
+                    correlation_sum += readings.correlation;
+                    ++correlation_count;
+                    summary.correlation_min = std::min(summary.correlation_min, readings.correlation);
+                }
+            });
+
+            const float* loudness_right = num_channels > 1 ? r : silence.data();
+
+            if (loudness.process(l + offset, loudness_right + offset, span))
+            {
+                const auto& readings = loudness.getReadings();
+                const auto& corr = correlation.getReadings();
+
+                double time = (double) (position + offset + span) / SR;
+
+                summary.momentary_max  = std::max(summary.momentary_max, readings.momentary);
+                summary.short_term_max = std::max(summary.short_term_max, readings.short_term);
+
+                if (options.json)
+                {
+                    meters_out << (loudness_steps > 0 ? ",\n    " : "\n    ")
+                               << "{ \"time\": " << String(time, 2)
+                               << ", \"momentary\": " << jsonNumber(readings.momentary)
+                               << ", \"short_term\": " << jsonNumber(readings.short_term)
+                               << ", \"integrated\": " << jsonNumber(readings.integrated)
+                               << ", \"range\": " << jsonNumber(readings.range)
+                               << ", \"true_peak\": " << jsonNumber(readings.true_peak)
+                               << ", \"correlation\": " << jsonNumber(corr.correlation)
+                               << ", \"balance\": " << jsonNumber(corr.balance);
+
+                    if (options.bands > 0)
+                    {
+                        meters_out << ", \"bands\": [";
+                        for (int b = 0; b < options.bands; ++b)
+                            meters_out << (b > 0 ? ", " : "") << jsonNumber(corr.band_correlation[b]);
+                        meters_out << "]";
+                    }
+
+                    meters_out << " }";
+                }
+                else
+                {
+                    meters_out << String(time, 2)
+                               << "," << number(readings.momentary)
+                               << "," << number(readings.short_term)
+                               << "," << number(readings.integrated)
+                               << "," << number(readings.range)
+                               << "," << number(readings.true_peak)
+                               << "," << number(corr.correlation)
+                               << "," << number(corr.balance);
+
+                    for (int b = 0; b < options.bands; ++b)
+                        meters_out << "," << number(corr.band_correlation[b]);
+
+                    meters_out << "\n";
+                }
+
+                if (recorder.isOpen())
+                {
+                    const float values[CLI_BINARY_METERS] = {
+                        readings.momentary, readings.short_term, readings.integrated, readings.range,
+                        readings.true_peak, corr.correlation, corr.balance
+                    };
+                    recorder.appendMeters(time, values);
+                }
+
+                ++loudness_steps;
+            }
+
+            offset += span;
+        }
+    }
+
+    const auto& readings = loudness.getReadings();
+
+    summary.integrated    = readings.integrated;
+    summary.range         = readings.range;
+    summary.true_peak_max = readings.true_peak_max;
+
+    if (correlation_count > 0)
+        summary.correlation_mean = (float) (correlation_sum / (double) correlation_count);
+    else
+        summary.correlation_min = 0.0f;
+
+    if (options.json)
+    {
+        meters_out << "\n  ],\n  \"spectrogram\": [";
+        meters_out << json_spectrogram.toString();
+        meters_out << "\n  ]\n}\n";
+    }
+
+    meters_out.flush();
+    if (spectrogram_out) spectrogram_out->flush();
+    recorder.close();
+
+    summary.ok = meters_out.getStatus().wasOk()
+              && (spectrogram_out == nullptr || spectrogram_out->getStatus().wasOk());
+
+    if (!summary.ok)
+        summary.error = "write failed";
+
+    return summary;
+}
+
+static void writeSummary(const File& file, const std::vector<FileSummary>& summaries, bool json)
+{
+    file.deleteFile();
+    FileOutputStream out(file);
+
+    if (out.failedToOpen())
+    {
+        std::cerr << "cannot write " << file.getFullPathName() << "\n";
+        return;
+    }
+
+    if (json)
+    {
+        out << "[";
+        for (size_t k = 0; k < summaries.size(); ++k)
+        {
+            const auto& s = summaries[k];
+
+            out << (k > 0 ? ",\n  " : "\n  ")
+                << "{ \"file\": " << JSON::toString(s.file.getFullPathName())
+                << ", \"ok\": " << (s.ok ? "true" : "false");
+
+            if (!s.ok)
+                out << ", \"error\": " << JSON::toString(s.error);
+
+            out << ", \"duration\": " << String(s.duration, 3)
+                << ", \"sample_rate\": " << String(s.sample_rate)
+                << ", \"channels\": " << s.channels
+                << ", \"integrated\": " << jsonNumber(s.integrated)
+                << ", \"range\": " << jsonNumber(s.range)
+                << ", \"true_peak_max\": " << jsonNumber(s.true_peak_max)
+                << ", \"momentary_max\": " << jsonNumber(s.momentary_max)
+                << ", \"short_term_max\": " << jsonNumber(s.short_term_max)
+                << ", \"correlation_mean\": " << jsonNumber(s.correlation_mean)
+                << ", \"correlation_min\": " << jsonNumber(s.correlation_min)
+                << " }";
+        }
+        out << "\n]\n";
+    }
+    else
+    {
+        out << "file,ok,error,duration,sample_rate,channels,integrated,range,true_peak_max,"
+               "momentary_max,short_term_max,correlation_mean,correlation_min\n";
+
+        for (const auto& s : summaries)
+        {
+            out << s.file.getFullPathName().quoted()
+                << "," << (s.ok ? "1" : "0")
+                << "," << s.error.quoted()
+                << "," << String(s.duration, 3)
+                << "," << String(s.sample_rate)
+                << "," << s.channels
+                << "," << number(s.integrated)
+                << "," << number(s.range)
+                << "," << number(s.true_peak_max)
+                << "," << number(s.momentary_max)
+                << "," << number(s.short_term_max)
+                << "," << number(s.correlation_mean)
+                << "," << number(s.correlation_min)
+                << "\n";
+        }
+    }
+}
+
+static AnalysisWindowType parseWindow(const String& name)
+{
+    if (name == "blackman-harris") return WindowBlackmanHarris;
+    if (name == "flat-top")        return WindowFlatTop;
+    if (name == "kaiser")          return WindowKaiser;
+    return WindowHann;
+}
+
+static void printUsage()
+{
+    std::cout << "usage: analytiks-cli [--out dir] [--format csv|json] [--fft-order 9..13]\n"
+                 "                     [--fft-window hann|blackman-harris|flat-top|kaiser] [--kaiser-beta b]\n"
+                 "                     [--window ms] [--bands 0|3|5|8] [--jobs n] [--binary]\n"
+                 "                     <file or directory>...\n";
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    Array<File> inputs;
+
+    for (int k = 1; k < argc; ++k)
+    {
+        String arg(argv[k]);
+        auto value = [&]() { return k + 1 < argc ? String(argv[++k]) : String(); };
+
+        if      (arg == "--out")       options.out_dir   = File::getCurrentWorkingDirectory().getChildFile(value());
+        else if (arg == "--format")    options.json      = value() == "json";
+        else if (arg == "--fft-order") options.fft_order = jlimit(9, 13, value().getIntValue());
+        else if (arg == "--fft-window")  options.fft_window  = parseWindow(value());
+        else if (arg == "--kaiser-beta") options.kaiser_beta = jlimit(0.0f, 20.0f, value().getFloatValue());
+        else if (arg == "--window")    options.window_ms = jlimit(0.1, 500.0, value().getDoubleValue());
+        else if (arg == "--bands")     options.bands     = jlimit(0, BAND_MAX_BANDS, value().getIntValue());
+        else if (arg == "--jobs")      options.jobs      = std::max(1, value().getIntValue());
+        else if (arg == "--binary")    options.binary    = true;
+        else if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+        {
+            File input = File::getCurrentWorkingDirectory().getChildFile(arg);
+
+            if (input.isDirectory())
+                inputs.addArray(input.findChildFiles(File::findFiles, true, "*.wav;*.flac;*.aif;*.aiff;*.ogg"));
+            else
+                inputs.add(input);
+        }
+    }
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.out_dir != File())
+        options.out_dir.createDirectory();
+
+    std::vector<FileSummary> summaries(inputs.size());
+
+    // a file per job, every file is analysed start to end by one thread.
+    {
+        ThreadPool pool(std::min(options.jobs, inputs.size()));
+
+        for (int k = 0; k < inputs.size(); ++k)
+        {
+            pool.addJob([&, k]
+            {
+                summaries[k] = analyseFile(inputs[k], options);
+                return ThreadPoolJob::jobHasFinished;
+            });
+        }
+
+        while (pool.getNumJobs() > 0)
+            Thread::sleep(20);
+    }
+
+    bool all_ok = true;
+
+    for (const auto& s : summaries)
+    {
+        if (s.ok)
+            std::cout << s.file.getFileName() << " : " << number(s.integrated) << " LUFS, "
+                      << number(s.range) << " LU, " << number(s.true_peak_max) << " dBTP\n";
+        else
+            std::cerr << s.file.getFileName() << " : " << s.error << "\n";
+
+        all_ok = all_ok && s.ok;
+    }
+
+    File summary_dir = options.out_dir == File() ? File::getCurrentWorkingDirectory() : options.out_dir;
+    writeSummary(summary_dir.getChildFile(options.json ? "summary.json" : "summary.csv"), summaries, options.json);
+
+    return all_ok ? 0 : 1;
+}
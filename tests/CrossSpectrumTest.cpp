@@ -0,0 +1,154 @@
+// CrossSpectrum against a known system: the left channel is the right one
+// at half the gain, 10 samples late, with noise 40 dB under it. 2048 point
+// hann frames at 48 kHz, half overlapped, as the analysis takes them. The
+// H1 gain, its linear phase and the coherence are checked, then the same
+// sums blended frame by frame with keep 1 ("Infinite" averaging).
+
+#include "UI_Comp/DFT/CrossSpectrum.h"
+#include "UI_Comp/DFT/FFTTables.h"
+#include "TestUtil.h"
+
+#include <random>
+
+static const double sample_rate = 48000.0;
+static const int frame_order = 11;
+static const int delay = 10;
+
+struct Frames
+{
+    int fft_size = 1 << frame_order;
+    WindowTable window { 1 << frame_order, WindowHann };
+    FFTPlan plan { frame_order };
+
+    float* input  = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+    float* left   = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+    float* right  = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+    float* work   = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+
+    ~Frames()
+    {
+        pffft_aligned_free(input);
+        pffft_aligned_free(left);
+        pffft_aligned_free(right);
+        pffft_aligned_free(work);
+    }
+
+    // the frame at `start` of both channels, windowed and transformed.
+    void transform(const std::vector<float>& l, const std::vector<float>& r, int start)
+    {
+        for (int i = 0; i < fft_size; ++i)
+            input[i] = l[start + i] * window.data[i];
+        pffft_transform_ordered(plan.setup, input, left, work, PFFFT_FORWARD);
+
+        for (int i = 0; i < fft_size; ++i)
+            input[i] = r[start + i] * window.data[i];
+        pffft_transform_ordered(plan.setup, input, right, work, PFFFT_FORWARD);
+    }
+};
+
+static std::vector<float> noise(std::mt19937& random, int num, double rms)
+{
+    std::normal_distribution<float> normal(0.0f, (float) rms);
+
+    std::vector<float> out(num);
+    for (float& value : out)
+        value = normal(random);
+
+    return out;
+}
+
+int main()
+{
+    const double pi = 3.14159265358979323846;
+
+    Frames frames;
+    const int fft_size = frames.fft_size;
+    const int num_frames = 64;
+    const int num = (num_frames + 1) * fft_size / 2 + delay;
+
+    std::mt19937 random(1770);
+    const std::vector<float> reference = noise(random, num, 0.1);
+    const std::vector<float> floor = noise(random, num, 0.1 * dbToGain(-40.0));
+
+    // the system's output on the left, its input on the right.
+    std::vector<float> output(num, 0.0f);
+    for (int i = delay; i < num; ++i)
+        output[i] = 0.5f * reference[i - delay] + floor[i];
+
+    CrossSpectrum sums, blended;
+    for (int f = 0; f < num_frames; ++f)
+    {
+        frames.transform(output, reference, delay + f * fft_size / 2);
+        sums.accumulate(frames.left, frames.right, fft_size);
+
+        CrossSpectrum frame;
+        frame.accumulate(frames.left, frames.right, fft_size);
+        blended.blend(frame, 1.0f);
+    }
+
+    // 200 Hz to 15 kHz.
+    const int first = (int) (200.0 * fft_size / sample_rate);
+    const int last  = (int) (15000.0 * fft_size / sample_rate);
+
+    // bin by bin, a band's sum would cancel where the delay turns the phase.
+    auto measure = [&](const CrossSpectrum& spectrum, double& worst_gain, double& mean_coherence, double& worst_phase)
+    {
+        worst_gain = worst_phase = mean_coherence = 0.0;
+
+        for (int bin = first; bin <= last; ++bin)
+        {
+            const CrossBand band = spectrum.getBand(bin, bin);
+
+            // the output lags by `delay`, its phase falls linearly with frequency.
+            const double expected_phase = -2.0 * pi * bin * delay / fft_size;
+
+            worst_gain = std::max(worst_gain, std::fabs(20.0 * std::log10(band.gain) + 6.02));
+            worst_phase = std::max(worst_phase, std::fabs(std::remainder(band.phase - expected_phase, 2.0 * pi)));
+            mean_coherence += band.coherence / (last - first + 1);
+        }
+    };
+
+    double worst_gain, mean_coherence, worst_phase;
+    measure(sums, worst_gain, mean_coherence, worst_phase);
+    check("worst gain error, dB", worst_gain, 0.0, 0.0, 0.1);
+    check("worst phase error, rad", worst_phase, 0.0, 0.0, 0.02);
+    check("mean coherence", mean_coherence, 0.99, 0.01);
+    // the reference is the louder one.
+    check("pan", sums.getBand(first, last).pan, 0.6, 0.01);
+
+    // no common part, the coherence of independent noise over the band.
+    CrossSpectrum unrelated;
+    const std::vector<float> other = noise(random, num, 0.1);
+    for (int f = 0; f < num_frames; ++f)
+    {
+        frames.transform(other, reference, f * fft_size / 2);
+        unrelated.accumulate(frames.left, frames.right, fft_size);
+    }
+    check("coherence of unrelated channels", unrelated.getBand(first, last).coherence, 0.0, 0.0, 0.01);
+
+    // keep 1 never forgets, the blended frames are the plain sums.
+    double worst_sum = 0.0;
+    for (int bin = 0; bin < sums.getNumBins(); ++bin)
+    {
+        const double scale = std::max(sums.ll[bin] + sums.rr[bin], 1e-20f);
+        worst_sum = std::max({ worst_sum,
+                               std::fabs(blended.ll[bin]    - sums.ll[bin])    / scale,
+                               std::fabs(blended.rr[bin]    - sums.rr[bin])    / scale,
+                               std::fabs(blended.lr_re[bin] - sums.lr_re[bin]) / scale,
+                               std::fabs(blended.lr_im[bin] - sums.lr_im[bin]) / scale });
+    }
+    check("keep 1 against the sums, relative", worst_sum, 0.0, 0.0, 1e-5);
+
+    measure(blended, worst_gain, mean_coherence, worst_phase);
+    check("keep 1 worst gain error, dB", worst_gain, 0.0, 0.0, 0.1);
+    check("keep 1 mean coherence", mean_coherence, 0.99, 0.01);
+
+    // a new size starts over from the frame.
+    CrossSpectrum resized;
+    resized.resize(fft_size / 4 + 1);
+    resized.blend(sums, 1.0f);
+    check("blend into other bins, bins", resized.getNumBins(), sums.getNumBins(), 0.0);
+
+    std::printf("%d failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
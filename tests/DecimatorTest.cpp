@@ -0,0 +1,167 @@
+// Decimator against its design, for the factors 2, 4 and 8: noise through
+// process has to match the documented filter (a kaiser windowed sinc of
+// factor * 64 taps, beta 8, cut at DECIMATOR_CUTOFF of the decimated
+// nyquist, unity gain at DC) run directly over every input sample and kept
+// every factor-th, also in place. The response of the filter process
+// really runs, taken back from impulses, has to be flat to 0.92 of the
+// decimated nyquist and 80 dB down from 1.08 of it.
+
+#include "UI_Comp/DFT/Decimator.h"
+#include "TestUtil.h"
+
+#include <random>
+#include <string>
+
+static const double pi = 3.14159265358979323846;
+
+// the low pass the header describes, in double.
+static std::vector<double> design(int factor)
+{
+    const int taps = factor * DECIMATOR_TAPS_PER_PHASE;
+    const double cutoff = DECIMATOR_CUTOFF * 0.5 / factor;
+    const double centre = 0.5 * (taps - 1);
+
+    std::vector<double> h(taps);
+    double sum = 0.0;
+
+    for (int n = 0; n < taps; ++n)
+    {
+        const double t = n - centre;
+        const double r = t / centre;
+        const double x = 2.0 * pi * cutoff * t;
+
+        h[n] = 2.0 * cutoff * std::sin(x) / x
+             * besselI0(DECIMATOR_KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r)));
+        sum += h[n];
+    }
+
+    for (double& value : h)
+        value /= sum;
+
+    return h;
+}
+
+// the impulse response process runs: an impulse at each phase of the
+// factor gives every factor-th tap.
+static std::vector<double> measureImpulseResponse(int factor)
+{
+    const int taps = factor * DECIMATOR_TAPS_PER_PHASE;
+    std::vector<double> h(taps);
+
+    Decimator decimator;
+    decimator.setFactor(factor);
+
+    std::vector<float> input(taps + factor), output(taps + factor);
+
+    for (int position = 0; position < factor; ++position)
+    {
+        decimator.reset();
+        std::fill(input.begin(), input.end(), 0.0f);
+        input[position] = 1.0f;
+
+        const int written = decimator.process(input.data(), output.data(), (int) input.size());
+
+        // output k is taken at input factor * (k + 1) - 1, its newest.
+        for (int k = 0; k < written; ++k)
+        {
+            const int n = taps - 1 - (factor * (k + 1) - 1 - position);
+            if (n >= 0 && n < taps)
+                h[n] = output[k];
+        }
+    }
+
+    return h;
+}
+
+// 20 log10 |H(f)|, `frequency` in cycles per input sample.
+static double responseDb(const std::vector<double>& h, double frequency)
+{
+    double re = 0.0, im = 0.0;
+    for (int n = 0; n < (int) h.size(); ++n)
+    {
+        re += h[n] * std::cos(2.0 * pi * frequency * n);
+        im -= h[n] * std::sin(2.0 * pi * frequency * n);
+    }
+
+    return 10.0 * std::log10(re * re + im * im + 1e-30);
+}
+
+int main()
+{
+    std::mt19937 random(48000);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+    std::vector<float> noise(8192);
+    for (float& value : noise)
+        value = uniform(random);
+
+    for (int factor : { 2, 4, 8 })
+    {
+        const std::string name = "x" + std::to_string(factor);
+        const std::vector<double> h = design(factor);
+        const int taps = (int) h.size();
+
+        // the same noise in uneven blocks, out of place and in place.
+        Decimator decimator, in_place;
+        decimator.setFactor(factor);
+        in_place.setFactor(factor);
+
+        std::vector<float> output(noise.size()), buffer = noise;
+        int written = 0, written_in_place = 0;
+
+        for (int start = 0, block = 1; start < (int) noise.size(); start += block, block = block * 3 % 1021 + 1)
+        {
+            const int num = std::min(block, (int) noise.size() - start);
+            written += decimator.process(noise.data() + start, output.data() + written, num);
+
+            // the block reads from where its output goes, the output trails it.
+            written_in_place += in_place.process(buffer.data() + start, buffer.data() + written_in_place, num);
+        }
+
+        check((name + " outputs").c_str(), written, (double) noise.size() / factor, 0.0);
+
+        double worst = 0.0, worst_in_place = 0.0;
+        for (int k = 0; k < written; ++k)
+        {
+            const int newest = factor * (k + 1) - 1;
+
+            double expected = 0.0;
+            for (int n = 0; n < taps; ++n)
+            {
+                const int i = newest - (taps - 1) + n;
+                if (i >= 0)
+                    expected += h[n] * noise[i];
+            }
+
+            worst = std::max(worst, std::fabs(output[k] - expected));
+            worst_in_place = std::max(worst_in_place, (double) std::fabs(buffer[k] - output[k]));
+        }
+
+        check((name + " against direct filtering, 1e-6").c_str(), worst * 1e6, 0.0, 0.0, 5.0);
+        check((name + " in place against out of place").c_str(), worst_in_place, 0.0, 0.0);
+
+        // the response, over the decimated nyquist.
+        const std::vector<double> measured = measureImpulseResponse(factor);
+        const double nyquist = 0.5 / factor;
+
+        double passband = 0.0, stopband = -1000.0;
+        for (int i = 0; i <= 2000; ++i)
+        {
+            passband = std::max(passband, std::fabs(responseDb(measured, DECIMATOR_PASSBAND * nyquist * i / 2000)));
+
+            const double stop = (2.0 - DECIMATOR_PASSBAND) * nyquist;
+            stopband = std::max(stopband, responseDb(measured, stop + (0.5 - stop) * i / 2000));
+        }
+
+        check((name + " passband ripple, dB").c_str(), passband, 0.0, 0.0, 0.01);
+        check((name + " stopband, dB").c_str(), stopband, -80.0, 40.0, 0.0);
+    }
+
+    // the band of DECIMATOR_MAX_FREQUENCY has to stay.
+    check("factor at 44.1 kHz", Decimator::chooseFactor(44100.0), 1.0, 0.0);
+    check("factor at 96 kHz", Decimator::chooseFactor(96000.0), 2.0, 0.0);
+    check("factor at 192 kHz", Decimator::chooseFactor(192000.0), 4.0, 0.0);
+
+    std::printf("%d failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+// LevelMeter ballistics against tone bursts: the VU rise, the PPM
+// integration of short bursts and the fall of the PPM and digital meters,
+// read sample by sample through blocks of one sample.
+
+#include "UI_Comp/VolumeMeter/LevelMeter.h"
+#include "TestUtil.h"
+
+#include <memory>
+
+static const double sample_rate = 48000.0;
+
+static double gainToDb(double gain) { return 20.0 * std::log10(std::max(gain, 1e-12)); }
+
+// the level of channel 0 after every sample of `signal`.
+static std::vector<float> trace(LevelMeter::Ballistics ballistics, const std::vector<float>& signal)
+{
+    auto meter = std::make_unique<LevelMeter>();
+    meter->prepare(sample_rate, 0.5);
+    meter->setBallistics(ballistics);
+
+    std::vector<float> levels;
+    levels.reserve(signal.size());
+
+    for (const float& sample : signal)
+    {
+        const float* channels[1] = { &sample };
+        meter->process(channels, 1, 1);
+        levels.push_back(meter->getLevel(0));
+    }
+
+    return levels;
+}
+
+// `burst` seconds of a 5 kHz sine at 0 dBFS between silence.
+static std::vector<float> toneBurst(double burst, double silence_after)
+{
+    std::vector<float> signal;
+    SineGenerator sine { sample_rate, 5000.0 };
+
+    sine.append(signal, -200.0, 0.1);
+    sine.append(signal, 0.0, burst);
+    sine.append(signal, -200.0, silence_after);
+    return signal;
+}
+
+static size_t indexOfMax(const std::vector<float>& levels)
+{
+    return (size_t) (std::max_element(levels.begin(), levels.end()) - levels.begin());
+}
+
+static void testVu()
+{
+    // a 1 kHz sine reads its rms and gets to 99 % of it in 300 ms.
+    std::vector<float> signal;
+    SineGenerator sine { sample_rate, 1000.0 };
+    sine.append(signal, 0.0, 2.0);
+
+    const std::vector<float> levels = trace(LevelMeter::VU, signal);
+    const double steady = levels.back();
+
+    check("VU steady reading of a sine, dB re rms", gainToDb(steady / std::sqrt(0.5)), 0.0, 0.1);
+
+    size_t reached = 0;
+    while (reached < levels.size() && levels[reached] < 0.99 * steady)
+        ++reached;
+
+    check("VU time to 99 %, s", (double) reached / sample_rate, 0.3, 0.01);
+
+    // critically damped, no overshoot beyond the rectified ripple.
+    check("VU overshoot, dB", gainToDb(levels[indexOfMax(levels)] / steady), 0.0, 0.05);
+}
+
+static void testPpm()
+{
+    // the steady reading of a 5 kHz sine is its peak, less what its samples
+    // miss of the crest.
+    const std::vector<float> steady_levels = trace(LevelMeter::PPM, toneBurst(1.0, 0.0));
+    const double steady = steady_levels.back();
+
+    check("PPM steady reading of a sine, dB re peak", gainToDb(steady), 0.0, 0.3);
+
+    // IEC 60268-10 type I: a 10 ms burst reads -1 dB, a 5 ms burst -2 dB.
+    const std::vector<float> burst_10 = trace(LevelMeter::PPM, toneBurst(0.010, 2.0));
+    const std::vector<float> burst_5  = trace(LevelMeter::PPM, toneBurst(0.005, 0.1));
+
+    check("PPM 10 ms burst, dB re steady", gainToDb(burst_10[indexOfMax(burst_10)] / steady), -1.0, 0.5);
+    check("PPM 5 ms burst, dB re steady",  gainToDb(burst_5[indexOfMax(burst_5)] / steady),  -2.0, 0.75);
+
+    // then falls 20 dB in 1.7 s.
+    const size_t peak = indexOfMax(burst_10);
+    const size_t fallen = peak + (size_t) (LEVEL_FALL_S * sample_rate);
+
+    check("PPM fall over 1.7 s, dB", gainToDb(burst_10[fallen] / burst_10[peak]), -20.0, 0.5);
+}
+
+static void testDigital()
+{
+    // instant attack, the same 20 dB in 1.7 s fall.
+    const std::vector<float> levels = trace(LevelMeter::Digital, toneBurst(0.010, 2.0));
+    const size_t peak = indexOfMax(levels);
+    const size_t fallen = peak + (size_t) (LEVEL_FALL_S * sample_rate);
+
+    check("Digital 10 ms burst, dB re peak", gainToDb(levels[peak]), 0.0, 0.01);
+    check("Digital fall over 1.7 s, dB", gainToDb(levels[fallen] / levels[peak]), -20.0, 0.5);
+}
+
+int main()
+{
+    testVu();
+    testPpm();
+    testDigital();
+
+    std::printf("%d failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// LoudnessMeter against the synthetic cases of EBU Tech 3341 (loudness,
+// true peak) and EBU Tech 3342 (loudness range), generated here rather
+// than read from the EBU files. Both channels carry the same sine.
+// The programme material cases need the EBU files and the 5.0 case needs
+// more than two channels, they are not part of this test.
+
+#include "UI_Comp/VolumeMeter/LoudnessMeter.h"
+#include "TestUtil.h"
+
+#include <memory>
+#include <string>
+
+struct Segment
+{
+    double dbfs;
+    double seconds;
+};
+
+struct Run
+{
+    LoudnessReadings last;
+    // momentary and short-term seen once their window was full.
+    double momentary_min = 1e9, momentary_max = -1e9;
+    double short_term_min = 1e9, short_term_max = -1e9;
+};
+
+static Run runSegments(std::initializer_list<Segment> segments, double sample_rate = 48000.0,
+                       double frequency = 1000.0)
+{
+    std::vector<float> signal;
+    SineGenerator sine { sample_rate, frequency };
+
+    for (const Segment& segment : segments)
+        sine.append(signal, segment.dbfs, segment.seconds);
+
+    auto meter = std::make_unique<LoudnessMeter>();
+    meter->prepare(sample_rate);
+
+    Run run;
+    const int block = 512;
+    const long long step = std::lround(sample_rate * LOUDNESS_STEP_S);
+
+    for (size_t pos = 0; pos < signal.size(); pos += block)
+    {
+        const int num = (int) std::min<size_t>(block, signal.size() - pos);
+
+        if (meter->process(signal.data() + pos, signal.data() + pos, num))
+        {
+            const LoudnessReadings& r = meter->getReadings();
+            const long long steps = (long long) (pos + num) / step;
+
+            if (steps >= LOUDNESS_MOMENTARY_STEPS)
+            {
+                run.momentary_min = std::min(run.momentary_min, (double) r.momentary);
+                run.momentary_max = std::max(run.momentary_max, (double) r.momentary);
+            }
+
+            if (steps >= LOUDNESS_SHORT_TERM_STEPS)
+            {
+                run.short_term_min = std::min(run.short_term_min, (double) r.short_term);
+                run.short_term_max = std::max(run.short_term_max, (double) r.short_term);
+            }
+        }
+    }
+
+    run.last = meter->getReadings();
+    return run;
+}
+
+static void testLoudness()
+{
+    // Tech 3341 cases 1 and 2, the steady sine at 44.1, 48 and 96 kHz.
+    for (double sample_rate : { 44100.0, 48000.0, 96000.0 })
+    {
+        for (double level : { -23.0, -33.0 })
+        {
+            const Run run = runSegments({ { level, 20.0 } }, sample_rate);
+            const std::string name = "3341 sine " + std::to_string((int) level) + " dBFS at "
+                                   + std::to_string((int) sample_rate) + " Hz";
+
+            check((name + " M").c_str(), run.last.momentary,  level, 0.1);
+            check((name + " S").c_str(), run.last.short_term, level, 0.1);
+            check((name + " I").c_str(), run.last.integrated, level, 0.1);
+        }
+    }
+
+    // cases 3 to 5, the gates.
+    check("3341 case 3 I", runSegments({ { -36, 10 }, { -23, 60 }, { -36, 10 } }).last.integrated,
+          -23.0, 0.1);
+    check("3341 case 4 I", runSegments({ { -72, 10 }, { -36, 10 }, { -23, 60 }, { -36, 10 }, { -72, 10 } })
+                               .last.integrated, -23.0, 0.1);
+    check("3341 case 5 I", runSegments({ { -26, 20 }, { -20, 20.1 }, { -26, 20 } }).last.integrated,
+          -23.0, 0.1);
+
+    // case 9, a 3 s period under the short-term window reads the same all along.
+    {
+        const Run run = runSegments({ { -20, 1.34 }, { -30, 1.66 }, { -20, 1.34 }, { -30, 1.66 },
+                                      { -20, 1.34 }, { -30, 1.66 }, { -20, 1.34 }, { -30, 1.66 },
+                                      { -20, 1.34 }, { -30, 1.66 } });
+
+        check("3341 case 9 S lowest",  run.short_term_min, -23.0, 0.1);
+        check("3341 case 9 S highest", run.short_term_max, -23.0, 0.1);
+    }
+
+    // case 12, the same for a 0.4 s period under the momentary window.
+    {
+        std::vector<float> signal;
+        SineGenerator sine;
+
+        for (int k = 0; k < 25; ++k)
+        {
+            sine.append(signal, -20.0, 0.18);
+            sine.append(signal, -30.0, 0.22);
+        }
+
+        LoudnessMeter meter;
+        meter.prepare(48000.0);
+
+        double lowest = 1e9, highest = -1e9;
+        int steps = 0;
+
+        for (size_t pos = 0; pos < signal.size(); pos += 480)
+        {
+            if (meter.process(signal.data() + pos, signal.data() + pos, 480)
+                && ++steps >= LOUDNESS_MOMENTARY_STEPS)
+            {
+                lowest  = std::min(lowest,  (double) meter.getReadings().momentary);
+                highest = std::max(highest, (double) meter.getReadings().momentary);
+            }
+        }
+
+        check("3341 case 12 M lowest",  lowest,  -23.0, 0.1);
+        check("3341 case 12 M highest", highest, -23.0, 0.1);
+    }
+}
+
+static void testTruePeak()
+{
+    struct Case
+    {
+        const char* name;
+        double frequency_divisor;
+        double phase_degrees;
+        double dbfs;
+    };
+
+    // a sine of the given true peak whose samples miss its crests, read
+    // within +0.2 / -0.4 dB as Tech 3341 asks. The last step is read, the
+    // abrupt start of the sine rings above its steady peak.
+    for (const Case& c : { Case { "3341 true peak fs/4 0 deg -6 dBFS",     4.0,  0.0,  -6.0 },
+                           Case { "3341 true peak fs/4 45 deg -6 dBFS",    4.0,  45.0, -6.0 },
+                           Case { "3341 true peak fs/6 60 deg -6 dBFS",    6.0,  60.0, -6.0 },
+                           Case { "3341 true peak fs/8 67.5 deg -6 dBFS",  8.0,  67.5, -6.0 },
+                           Case { "3341 true peak fs/4 45 deg 0 dBFS",     4.0,  45.0,  0.0 } })
+    {
+        const double sample_rate = 48000.0;
+        const double pi = 3.14159265358979323846;
+
+        SineGenerator sine { sample_rate, sample_rate / c.frequency_divisor, c.phase_degrees * pi / 180.0 };
+        std::vector<float> signal;
+        sine.append(signal, c.dbfs, 1.0);
+
+        LoudnessMeter meter;
+        meter.prepare(sample_rate);
+        meter.process(signal.data(), signal.data(), (int) signal.size());
+
+        check(c.name, meter.getReadings().true_peak, c.dbfs, 0.4, 0.2);
+    }
+}
+
+static void testLoudnessRange()
+{
+    // Tech 3342 cases 1 to 4, within 1 LU.
+    check("3342 case 1 LRA", runSegments({ { -20, 20 }, { -30, 20 } }).last.range, 10.0, 1.0);
+    check("3342 case 2 LRA", runSegments({ { -20, 20 }, { -15, 20 } }).last.range, 5.0, 1.0);
+    check("3342 case 3 LRA", runSegments({ { -40, 20 }, { -20, 20 } }).last.range, 20.0, 1.0);
+    check("3342 case 4 LRA", runSegments({ { -50, 20 }, { -35, 20 }, { -20, 20 }, { -35, 20 }, { -50, 20 } })
+                                 .last.range, 15.0, 1.0);
+}
+
+int main()
+{
+    testLoudness();
+    testTruePeak();
+    testLoudnessRange();
+
+    std::printf("%d failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
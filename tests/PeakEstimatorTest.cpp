@@ -0,0 +1,91 @@
+// PeakEstimator against steady sines: 2048 point frames at 48 kHz of every
+// window, unpadded and zero padded, tones from 80 Hz to 5 kHz at a few
+// phases. The worst error of each is checked, the low tones are the ones
+// the negative frequency image leans on.
+
+#include "UI_Comp/DFT/PeakEstimator.h"
+#include "UI_Comp/DFT/SpectrumEngine.h"
+#include "TestUtil.h"
+
+#include <algorithm>
+#include <string>
+
+static const double sample_rate = 48000.0;
+static const int frame_order = 11;
+
+struct Errors
+{
+    double cents = 0.0;
+    double db = 0.0;
+};
+
+static Errors sweep(AnalysisWindowType type, int pad_bits)
+{
+    const double pi = 3.14159265358979323846;
+    const double dbfs = -6.0;
+    const int frame_size = 1 << frame_order;
+    const int fft_size = frame_size << pad_bits;
+    const int num_bins = fft_size / 2 + 1;
+
+    WindowTable window(frame_size, type);
+    FFTPlan plan(frame_order + pad_bits);
+    PeakEstimator estimator(window, fft_size);
+
+    float* input  = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+    float* output = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+    float* work   = (float*)pffft_aligned_malloc(sizeof(float) * fft_size);
+    std::vector<float> amplitudes(num_bins);
+
+    Errors worst;
+
+    for (double frequency = 80.0; frequency < 5000.0; frequency *= frequency < 500.0 ? 1.003 : 1.03)
+    {
+        for (int phase = 0; phase < 4; ++phase)
+        {
+            for (int i = 0; i < fft_size; ++i)
+                input[i] = i < frame_size ? (float) (dbToGain(dbfs) * window.data[i]
+                                                     * std::cos(2.0 * pi * frequency * i / sample_rate + phase * pi / 4))
+                                          : 0.0f;
+
+            pffft_transform_ordered(plan.setup, input, output, work, PFFFT_FORWARD);
+            SpectrumEngine::amplitudesFromFFT(output, amplitudes.data(), fft_size, window.amplitude_scale);
+
+            // the loudest bin of the tone's lobe, as the analyser picks it.
+            const int centre = (int) (frequency * fft_size / sample_rate);
+            const auto lobe = amplitudes.begin() + std::max(1, centre - 8);
+            const int peak_bin = (int) (std::max_element(lobe, lobe + 17) - amplitudes.begin());
+
+            float amplitude;
+            const double bins = estimator.estimate(amplitudes.data(), num_bins, peak_bin, amplitude);
+
+            worst.cents = std::max(worst.cents, std::fabs(1200.0 * std::log2(bins * sample_rate / fft_size / frequency)));
+            worst.db = std::max(worst.db, std::fabs(amplitude * 80.0 - 80.0 - dbfs));
+        }
+    }
+
+    pffft_aligned_free(input);
+    pffft_aligned_free(output);
+    pffft_aligned_free(work);
+
+    return worst;
+}
+
+int main()
+{
+    static const char* window_names[NumWindowTypes] = { "hann", "blackman-harris", "flat-top", "kaiser" };
+
+    for (int type = 0; type < NumWindowTypes; ++type)
+    {
+        for (int pad_bits = 0; pad_bits <= FFT_MAX_ZERO_PAD_BITS; ++pad_bits)
+        {
+            const Errors worst = sweep((AnalysisWindowType) type, pad_bits);
+            const std::string name = std::string(window_names[type]) + " x" + std::to_string(1 << pad_bits);
+
+            check((name + " worst error, cents").c_str(), worst.cents, 0.0, 0.0, 0.1);
+            check((name + " worst level error, dB").c_str(), worst.db, 0.0, 0.0, 0.01);
+        }
+    }
+
+    std::printf("%d failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
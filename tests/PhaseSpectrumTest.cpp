@@ -0,0 +1,105 @@
+// fastAtan2 against std::atan2 over a grid of every sign, signed zeros
+// included, then the phase plane of an impulse and its delayed copy: the
+// phase difference turns linearly over the bins and the group delay is the
+// delay in every bin. Ordered pffft output is written by hand, the
+// transform of an impulse is known.
+
+#include "UI_Comp/DFT/PhaseSpectrum.h"
+#include "TestUtil.h"
+
+#include <algorithm>
+#include <string>
+
+static const double pi = 3.14159265358979323846;
+static const float sample_rate = 48000.0f;
+static const int fft_size = 2048;
+
+// ordered pffft output of a unit impulse at `position`: DC and nyquist
+// packed first, then re and im of every bin.
+static std::vector<float> impulseSpectrum(int position)
+{
+    std::vector<float> spectrum(fft_size);
+    spectrum[0] = 1.0f;
+    spectrum[1] = (float) std::cos(pi * position);
+
+    for (int bin = 1; bin < fft_size / 2; ++bin)
+    {
+        const double turn = -2.0 * pi * bin * position / fft_size;
+        spectrum[2 * bin]     = (float) std::cos(turn);
+        spectrum[2 * bin + 1] = (float) std::sin(turn);
+    }
+
+    return spectrum;
+}
+
+// the worst distance of the plane from `expected` of each bin, bins
+// `first` to `last`.
+template <typename Expected>
+static double worstPlaneError(const std::vector<float>& plane, int first, int last, Expected&& expected)
+{
+    double worst = 0.0;
+    for (int bin = first; bin <= last; ++bin)
+        worst = std::max(worst, std::fabs(plane[bin] - expected(bin)));
+
+    return worst;
+}
+
+int main()
+{
+    // ── fastAtan2 ────────────────────────────────────────────────────────────
+    std::vector<float> values = { 0.0f, -0.0f, 1e-30f, -1e-30f, 1e-6f, -1e-6f, 1e6f, -1e6f };
+    for (int i = -100; i <= 100; ++i)
+        values.push_back(i * 0.0173f);
+
+    double worst = 0.0;
+    for (float y : values)
+        for (float x : values)
+            worst = std::max(worst, std::fabs((double) fastAtan2(y, x) - std::atan2((double) y, (double) x)));
+
+    check("fastAtan2 worst error, 1e-5 rad", worst * 1e5, 0.0, 0.0, 1.5);
+
+    // the quadrant of zeros comes from their signs alone.
+    check("fastAtan2(+0, +0)", fastAtan2(0.0f, 0.0f), 0.0, 0.0);
+    check("fastAtan2(-0, +0), sign", std::signbit(fastAtan2(-0.0f, 0.0f)), 1.0, 0.0);
+    check("fastAtan2(+0, -0)", fastAtan2(0.0f, -0.0f), pi, 1e-6);
+    check("fastAtan2(-0, -0)", fastAtan2(-0.0f, -0.0f), -pi, 1e-6);
+    check("fastAtan2(+0, -1)", fastAtan2(0.0f, -1.0f), pi, 1e-6);
+    check("fastAtan2(-0, -1)", fastAtan2(-0.0f, -1.0f), -pi, 1e-6);
+
+    // ── the plane ────────────────────────────────────────────────────────────
+    const int num_bins = fft_size / 2 + 1;
+    std::vector<float> scratch(num_bins), plane(num_bins);
+
+    for (int delay : { 24, -24, 5 })
+    {
+        // R behind L by `delay` samples.
+        const std::vector<float> left  = impulseSpectrum(100);
+        const std::vector<float> right = impulseSpectrum(100 + delay);
+        const std::string name = "delay " + std::to_string(delay);
+
+        computePhasePlane(left.data(), right.data(), fft_size, PhaseGroupDelay, sample_rate,
+                          scratch.data(), plane.data());
+
+        const double delay_ms = delay * 1000.0 / sample_rate;
+        const double expected = 0.5 + delay_ms / (2.0 * PHASE_GROUP_DELAY_RANGE_MS);
+        check((name + " group delay, worst plane error").c_str(),
+              worstPlaneError(plane, 0, num_bins - 1, [&](int) { return expected; }), 0.0, 0.0, 1e-4);
+
+        computePhasePlane(left.data(), right.data(), fft_size, PhaseDifference, sample_rate,
+                          scratch.data(), plane.data());
+
+        // L leads, by 2 pi delay / fft_size more every bin. Wraps are left out,
+        // where either end of -pi to pi is right.
+        auto difference = [&](int bin)
+        {
+            const double phase = std::remainder(2.0 * pi * bin * delay / fft_size, 2.0 * pi);
+            return std::fabs(phase) > pi - 1e-3 ? plane[bin] : 0.5 + phase / (2.0 * pi);
+        };
+
+        check((name + " phase difference, worst plane error").c_str(),
+              worstPlaneError(plane, 0, num_bins - 1, difference), 0.0, 0.0, 1e-5);
+    }
+
+    std::printf("%d failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
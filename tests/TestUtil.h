@@ -0,0 +1,51 @@
+#pragma once
+
+// what the engine tests share: sine segments and a failure count, a test
+// passes when main returns 0. Free of any juce dependency like the engines.
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static int failures = 0;
+
+// `value` has to lie within [expected - below, expected + above].
+inline void check(const char* name, double value, double expected, double below, double above)
+{
+    const bool ok = value >= expected - below && value <= expected + above;
+
+    std::printf("%s %-48s %9.3f (expected %.3f -%.2f +%.2f)\n",
+                ok ? "ok  " : "FAIL", name, value, expected, below, above);
+
+    if (!ok) ++failures;
+}
+
+inline void check(const char* name, double value, double expected, double tolerance)
+{
+    check(name, value, expected, tolerance, tolerance);
+}
+
+inline double dbToGain(double db) { return std::pow(10.0, db / 20.0); }
+
+// a sine that goes on where the previous segment stopped.
+struct SineGenerator
+{
+    double sample_rate = 48000.0;
+    double frequency = 1000.0;
+    double phase = 0.0;
+
+    // `seconds` of a sine of peak `dbfs` appended to `out`.
+    void append(std::vector<float>& out, double dbfs, double seconds)
+    {
+        const double pi = 3.14159265358979323846;
+        const double gain = dbToGain(dbfs);
+        const long long num = std::llround(seconds * sample_rate);
+
+        for (long long i = 0; i < num; ++i)
+        {
+            out.push_back((float) (gain * std::sin(phase)));
+            phase += 2.0 * pi * frequency / sample_rate;
+            if (phase > 2.0 * pi) phase -= 2.0 * pi;
+        }
+    }
+};